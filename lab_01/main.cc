@@ -1,35 +1,174 @@
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstdio>
 #include <iostream>
+#include <iterator>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
 
 #include "utils.h"
 #include "syntaxtree.h"
 #include "dfa.h"
+#include "mappedfile.h"
+#include "metrics.h"
+#include "scanner.h"
 
-int main()
+// stdout sink which collects matched lines into large blocks before writing them
+class Output
 {
-    std::string regexp;
-    std::cout << "Input regexp: ";
-    std::cin >> regexp;
+public:
+    ~Output()
+    {
+        flush();
+    }
 
-    std::string matcher;
-    std::cout << "Input string to match: ";
-    std::cin >> matcher;
+    void write(std::string_view line)
+    {
+        if (buffer.size() + line.size() + 1 > capacity)
+        {
+            flush();
+        }
+        buffer.append(line);
+        buffer.push_back('\n');
+    }
 
-    SyntaxTree syntaxTree;
-    syntaxTree.create(infixToPostfix(regexp));
-    const auto &dfaStartState = syntaxTree.getRoot();
+    void flush()
+    {
+        std::fwrite(buffer.data(), 1, buffer.size(), stdout);
+        buffer.clear();
+    }
+
+private:
+    static constexpr size_t capacity = 1 << 20;
+    std::string buffer;
+};
+
+int usage()
+{
+    std::cerr << "Usage: lab_01 [-j threads] [--metrics] regexp [file...]\n"
+                 "Prints lines fully matching regexp, reads stdin when no file is given\n"
+                 "regexp is built of symbols, |, * and parentheses\n"
+                 "-j takes 1 to 1024 threads\n"
+                 "--metrics writes construction and matching statistics as json to stderr\n";
+    return 2;
+}
+
+// a thread count of -j, only digits and at most maxThreads
+bool parseThreads(std::string_view arg, size_t &threads)
+{
+    constexpr size_t maxThreads = 1024;
+
+    size_t value = 0;
+    auto [end, error] = std::from_chars(arg.data(), arg.data() + arg.size(), value);
+    if (error != std::errc() || end != arg.data() + arg.size() || value == 0 || value > maxThreads)
+    {
+        return false;
+    }
+
+    threads = value;
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    size_t threads = std::max(std::thread::hardware_concurrency(), 1u);
+    bool withMetrics = false;
+    std::vector<std::string> args;
 
-    std::cout << syntaxTree.toString() << std::endl;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "-j")
+        {
+            if (i + 1 == argc || !parseThreads(argv[++i], threads))
+            {
+                return usage();
+            }
+        }
+        else if (arg == "--metrics")
+        {
+            withMetrics = true;
+        }
+        else if (arg == "-h" || arg == "--help")
+        {
+            return usage();
+        }
+        else
+        {
+            args.push_back(arg);
+        }
+    }
+
+    if (args.empty() || !isValidRegexp(args.front()))
+    {
+        return usage();
+    }
+
+    Metrics metrics;
+    metrics.regexp = args.front();
+
+    auto postfix = measure(metrics.infixToPostfixTime, [&] { return infixToPostfix(args.front()); });
+
+    SyntaxTree syntaxTree;
+    measure(metrics.syntaxTreeTime, [&] { syntaxTree.create(postfix); });
 
     Dfa dfa;
-    dfa.create(dfaStartState, syntaxTree);
+    measure(metrics.dfaTime, [&] { dfa.create(syntaxTree.getRoot(), syntaxTree); });
+
+    if (withMetrics)
+    {
+        measure(metrics.minimizeTime, [&] { dfa.minimize(syntaxTree.getAlphabet()); });
+    }
+
+    const Scanner scanner(dfa);
+    Output output;
+
+    size_t bytes = 0;
+    size_t matched = 0;
+    auto onMatch = [&output](std::string_view line) { output.write(line); };
+    auto start = std::chrono::steady_clock::now();
+
+    try
+    {
+        if (args.size() == 1)
+        {
+            std::string input(std::istreambuf_iterator<char>(std::cin), {});
+            matched += scanner.scan(input, onMatch, threads);
+            bytes += input.size();
+        }
+
+        for (auto it = std::next(std::begin(args)); it != std::end(args); ++it)
+        {
+            MappedFile file(*it);
+            matched += scanner.scan(file.getData(), onMatch, threads);
+            bytes += file.getData().size();
+        }
+    }
+    catch (const std::system_error &err)
+    {
+        output.flush();
+        std::cerr << "lab_01: " << err.what() << std::endl;
+        return 1;
+    }
+
+    output.flush();
 
-    std::cout << dfa.toString(dfa.getTransitions()) << std::endl;
-    std::cout << "Regexp match result dfa: " << std::boolalpha << dfa.match(matcher) << std::endl;
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
 
-    dfa.minimize(syntaxTree.getAlphabet());
-    std::cout << dfa.toString(dfa.getMinimizedTransitions()) << std::endl;
-    std::cout << "Regexp match result min dfa: " << std::boolalpha << dfa.matchMinimized(matcher)
-              << std::endl;
+    if (withMetrics)
+    {
+        metrics.collect(syntaxTree, dfa, scanner);
+        metrics.scannedBytes = bytes;
+        metrics.matchedLines = matched;
+        metrics.matchTime = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed);
+        std::cerr << metrics.toJson() << std::endl;
+    }
+    std::cerr << "lab_01: " << matched << " matching lines, " << bytes << " bytes in "
+              << elapsed.count() << " s, " << bytes / elapsed.count() / 1e9 << " GB/s, "
+              << threads << " threads" << std::endl;
 
-    return 0;
+    return matched > 0 ? 0 : 1;
 }
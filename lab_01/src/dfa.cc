@@ -1,7 +1,12 @@
 #include "dfa.h"
 
+#include <algorithm>
 #include <deque>
+#include <functional>
+#include <iterator>
+#include <map>
 #include <sstream>
+#include <vector>
 
 #include "syntaxtree.h"
 
@@ -45,6 +50,16 @@ void Dfa::create(const Node &dfaStartState, const SyntaxTree &syntaxTree)
         dfaTransitionsTmp[transitionId++] = newStates;
     }
 
+    // symbol == '#' - custom regexp end symbol, states holding it are accepting
+    std::set<size_t> dfaAcceptingStates;
+    for (const auto &[id, state]: allDfaStates)
+    {
+        if (state.find(syntaxTree.getSyntaxTree().size() - 2) != std::end(state))
+        {
+            dfaAcceptingStates.insert(id);
+        }
+    }
+
     DfaTransitions dfaTransitions;
 
     for (const auto &[id, transitions]: dfaTransitionsTmp)
@@ -60,36 +75,71 @@ void Dfa::create(const Node &dfaStartState, const SyntaxTree &syntaxTree)
     }
 
     std::swap(allDfaStates, states);
+    std::swap(dfaAcceptingStates, acceptingStates);
     std::swap(dfaTransitions, transitions);
 }
 
 void Dfa::minimize(const std::set<char> &alphabet)
 {
-    std::unordered_map<size_t, std::unordered_map<char, size_t>> newDfaTransitions;
+    // Hopcroft's algorithm over the completed dfa: state `dead` absorbs every
+    // missing transition, so the partition never depends on how states are numbered
+    const size_t dead = states.size();
+    const size_t size = dead + 1;
+    const std::vector<char> symbols(std::begin(alphabet), std::end(alphabet));
+
+    std::vector<std::vector<size_t>> delta(size, std::vector<size_t>(symbols.size(), dead));
+    for (const auto &[id, transition]: transitions)
+    {
+        for (size_t a = 0; a < symbols.size(); ++a)
+        {
+            if (auto it = transition.find(symbols[a]); it != std::end(transition))
+            {
+                delta[id][a] = it->second;
+            }
+        }
+    }
 
-    std::set<size_t> S1;
-    std::set<size_t> S2;
+    std::vector<std::vector<std::vector<size_t>>> inverse(
+        symbols.size(), std::vector<std::vector<size_t>>(size));
+    for (size_t s = 0; s < size; ++s)
+    {
+        for (size_t a = 0; a < symbols.size(); ++a)
+        {
+            inverse[a][delta[s][a]].push_back(s);
+        }
+    }
 
-    for (const auto &[id, state]: states)
+    std::vector<std::vector<size_t>> P;
+    std::vector<size_t> classOf(size);
     {
-        if (id != states.size() - 1)
+        std::vector<size_t> F;
+        std::vector<size_t> Q;
+        for (size_t s = 0; s < size; ++s)
         {
-            S1.insert(id);
+            (acceptingStates.find(s) != std::end(acceptingStates) ? F : Q).push_back(s);
         }
-        else
+
+        for (auto &&R: {F, Q})
         {
-            S2.insert(id);
+            if (!R.empty())
+            {
+                for (const auto &s: R)
+                {
+                    classOf[s] = P.size();
+                }
+                P.push_back(R);
+            }
         }
     }
 
-    std::set<std::set<size_t>> P = {S1, S2};
-    std::deque<std::pair<std::set<size_t>, char>> S;
-
-    for (const char &c: alphabet)
+    std::deque<std::pair<size_t, size_t>> S;
+    std::set<std::pair<size_t, size_t>> inS;
+    for (size_t C = 0; C < P.size(); ++C)
     {
-        for (const auto &p: P)
+        for (size_t a = 0; a < symbols.size(); ++a)
         {
-            S.push_back({p, c});
+            S.push_back({C, a});
+            inS.insert({C, a});
         }
     }
 
@@ -97,102 +147,120 @@ void Dfa::minimize(const std::set<char> &alphabet)
     {
         auto [C, a] = S.front();
         S.pop_front();
+        inS.erase({C, a});
 
-        auto newP = P;
-        for (const auto &R: P)
+        // states leading into C by a, grouped by their current class
+        std::map<size_t, std::vector<size_t>> involved;
+        for (const auto &t: P[C])
         {
-            std::set<size_t> R1;
-            std::set<size_t> R2;
-
-            for (const auto &r: R)
+            for (const auto &r: inverse[a][t])
             {
-                const auto tr = transitions[r];
-                if (auto it = tr.find(a); it != std::end(tr))
-                {
-                    if (C.find(it->second) != std::end(C))
-                    {
-                        R1.insert(r);
-                    }
-                    else
-                    {
-                        R2.insert(r);
-                    }
-                }
+                involved[classOf[r]].push_back(r);
             }
+        }
 
-            if (!R1.empty() && !R2.empty())
+        for (auto &[R, R1]: involved)
+        {
+            if (R1.size() == P[R].size())
             {
-                newP.erase(R);  // replace with R1 and R2
-                newP.insert(R1);
-                newP.insert(R2);
+                continue;
+            }
 
-                bool contains = false;
+            std::set<size_t> split(std::begin(R1), std::end(R1));
+            std::vector<size_t> R2;
+            std::copy_if(std::begin(P[R]), std::end(P[R]), std::back_inserter(R2),
+                [&](auto &&s) { return split.find(s) == std::end(split); });
 
-                for (auto it = std::begin(S); it != std::end(S) && !contains; ++it)
-                {
-                    if (it->first == R && it->second == a)
-                    {
-                        S.erase(it);
-                        S.push_back({R1, a});
-                        S.push_back({R2, a});
-
-                        contains = true;
-                    }
-                }
+            // R keeps the larger half, the smaller one becomes a new class
+            if (R1.size() > R2.size())
+            {
+                std::swap(R1, R2);
+            }
 
-                if (!contains)
+            const size_t newClass = P.size();
+            for (const auto &s: R1)
+            {
+                classOf[s] = newClass;
+            }
+            P[R] = std::move(R2);
+            P.push_back(std::move(R1));
+
+            // a pending (R, b) now stands for the larger half, otherwise splitting by the
+            // smaller half is enough - either way only the new class has to be queued
+            for (size_t b = 0; b < symbols.size(); ++b)
+            {
+                if (inS.insert({newClass, b}).second)
                 {
-                    if (R1 <= R2)
-                    {
-                        S.push_back({R1, a});
-                    }
-                    else
-                    {
-                        S.push_back({R2, a});
-                    }
+                    S.push_back({newClass, b});
                 }
             }
         }
-
-        std::swap(P, newP);
     }
 
-    for (const auto &states: P)
+    // every class is named by its smallest original state, so the start state keeps id 0
+    // and ids stay valid keys of getStates()
+    std::vector<size_t> representative(P.size(), size);
+    for (size_t s = 0; s < size; ++s)
     {
-        auto i = *std::begin(states);
-        newDfaTransitions[i] = transitions[i];
+        representative[classOf[s]] = std::min(representative[classOf[s]], s);
     }
 
-    std::swap(minimizedTransitions, newDfaTransitions);
-}
+    DfaTransitions newDfaTransitions;
+    std::set<size_t> newAcceptingStates;
+    const size_t deadClass = classOf[dead];
 
-bool Dfa::match(std::string_view regexp) const
-{
-    size_t currentState = 0;
-
-    for (const char &c: regexp)
+    for (size_t C = 0; C < P.size(); ++C)
     {
-        const auto transitions = getTransitions().at(currentState);
-        if (auto it = transitions.find(c); it == std::end(transitions))
+        if (C == deadClass)
         {
-            return false;
+            continue;
         }
-        else
+
+        auto i = representative[C];
+        auto &newTransitions = newDfaTransitions[i];
+        for (size_t a = 0; a < symbols.size(); ++a)
         {
-            currentState = it->second;
+            if (auto to = classOf[delta[i][a]]; to != deadClass)
+            {
+                newTransitions[symbols[a]] = representative[to];
+            }
+        }
+
+        if (acceptingStates.find(i) != std::end(acceptingStates))
+        {
+            newAcceptingStates.insert(i);
         }
     }
 
-    return currentState == getStates().size() - 1 ? true : false;
+    std::swap(minimizedTransitions, newDfaTransitions);
+    std::swap(minimizedAcceptingStates, newAcceptingStates);
+}
+
+bool Dfa::match(std::string_view regexp) const
+{
+    return run(getTransitions(), getAcceptingStates(), regexp);
 }
 
 bool Dfa::matchMinimized(std::string_view regexp) const
+{
+    return run(getMinimizedTransitions(), getMinimizedAcceptingStates(), regexp);
+}
+
+bool Dfa::run(const DfaTransitions &dfaTransitions,
+    const std::set<size_t> &dfaAcceptingStates,
+    std::string_view regexp) const
 {
     size_t currentState = 0;
 
     for (const char &c: regexp)
     {
-        const auto transitions = getMinimizedTransitions().at(currentState);
+        auto state = dfaTransitions.find(currentState);
+        if (state == std::end(dfaTransitions))
+        {
+            return false;
+        }
+
+        const auto &transitions = state->second;
         if (auto it = transitions.find(c); it == std::end(transitions))
         {
             return false;
@@ -203,7 +271,7 @@ bool Dfa::matchMinimized(std::string_view regexp) const
         }
     }
 
-    return currentState == getStates().size() - 1 ? true : false;
+    return dfaAcceptingStates.find(currentState) != std::end(dfaAcceptingStates);
 }
 
 const Dfa::DfaStates &Dfa::getStates() const
@@ -211,6 +279,11 @@ const Dfa::DfaStates &Dfa::getStates() const
     return states;
 }
 
+const std::set<size_t> &Dfa::getAcceptingStates() const
+{
+    return acceptingStates;
+}
+
 const Dfa::DfaTransitions &Dfa::getTransitions() const
 {
     return transitions;
@@ -221,6 +294,11 @@ const Dfa::DfaTransitions &Dfa::getMinimizedTransitions() const
     return minimizedTransitions;
 }
 
+const std::set<size_t> &Dfa::getMinimizedAcceptingStates() const
+{
+    return minimizedAcceptingStates;
+}
+
 std::string Dfa::toString(const DfaTransitions &dfaTransitions) const
 {
     std::stringstream ss;
@@ -22,13 +22,22 @@ public:
     bool matchMinimized(std::string_view regexp) const;
 
     const DfaStates &getStates() const;
+    const std::set<size_t> &getAcceptingStates() const;
     const DfaTransitions &getTransitions() const;
     const DfaTransitions &getMinimizedTransitions() const;
+    const std::set<size_t> &getMinimizedAcceptingStates() const;
 
     std::string toString(const DfaTransitions &dfaTransitions) const;
 
+private:
+    bool run(const DfaTransitions &dfaTransitions,
+        const std::set<size_t> &dfaAcceptingStates,
+        std::string_view regexp) const;
+
 private:
     DfaStates states;
+    std::set<size_t> acceptingStates;
     DfaTransitions transitions;
     DfaTransitions minimizedTransitions;
+    std::set<size_t> minimizedAcceptingStates;
 };
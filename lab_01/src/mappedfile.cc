@@ -0,0 +1,56 @@
+#include "mappedfile.h"
+
+#include <cerrno>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MappedFile::MappedFile(const std::string &path)
+{
+    fd = ::open(path.c_str(), O_RDONLY);
+    if (fd == -1)
+    {
+        throw std::system_error(errno, std::generic_category(), path);
+    }
+
+    struct stat st;
+    if (::fstat(fd, &st) == -1)
+    {
+        auto error = errno;
+        ::close(fd);
+        throw std::system_error(error, std::generic_category(), path);
+    }
+
+    size = static_cast<size_t>(st.st_size);
+
+    // mmap refuses zero-length mappings, an empty file is just an empty view
+    if (size > 0)
+    {
+        address = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (address == MAP_FAILED)
+        {
+            auto error = errno;
+            ::close(fd);
+            throw std::system_error(error, std::generic_category(), path);
+        }
+
+        ::madvise(address, size, MADV_SEQUENTIAL);
+    }
+}
+
+MappedFile::~MappedFile()
+{
+    if (address != nullptr)
+    {
+        ::munmap(address, size);
+    }
+    ::close(fd);
+}
+
+std::string_view MappedFile::getData() const
+{
+    return {static_cast<const char *>(address), size};
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+// read-only memory mapping of a whole file, throws std::system_error on failure
+class MappedFile
+{
+public:
+    explicit MappedFile(const std::string &path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    std::string_view getData() const;
+
+private:
+    int fd = -1;
+    void *address = nullptr;
+    size_t size = 0;
+};
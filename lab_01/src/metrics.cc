@@ -0,0 +1,104 @@
+#include "metrics.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <sstream>
+
+#include "syntaxtree.h"
+#include "dfa.h"
+#include "scanner.h"
+
+static std::string escape(std::string_view str)
+{
+    std::string result;
+    result.reserve(str.size());
+
+    for (const char &c: str)
+    {
+        switch (c)
+        {
+            case '"':
+                result += "\\\"";
+                break;
+            case '\\':
+                result += "\\\\";
+                break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20)
+                {
+                    char code[8];
+                    std::snprintf(code, sizeof(code), "\\u%04x", c);
+                    result += code;
+                }
+                else
+                {
+                    result.push_back(c);
+                }
+                break;
+        }
+    }
+
+    return result;
+}
+
+void Metrics::collect(const SyntaxTree &syntaxTree, const Dfa &dfa, const Scanner &scanner)
+{
+    // positions are the leaves, symbols and the end marker, operator nodes have none
+    const auto &tree = syntaxTree.getSyntaxTree();
+    treePositions = std::count_if(std::begin(tree), std::end(tree), [](const auto &entry) {
+        auto symbol = entry.second.symbol;
+        return symbol != '|' && symbol != '&' && symbol != '*';
+    });
+
+    followPosSize = 0;
+    for (const auto &[pos, followPos]: syntaxTree.getFollowPos())
+    {
+        followPosSize += followPos.size();
+    }
+
+    dfaStates = dfa.getStates().size();
+
+    dfaTransitions = 0;
+    for (const auto &[id, transitions]: dfa.getTransitions())
+    {
+        dfaTransitions += transitions.size();
+    }
+
+    minimizedDfaStates = dfa.getMinimizedTransitions().size();
+    transitionTableBytes = scanner.getTableSize();
+}
+
+double Metrics::getBytesPerSecond() const
+{
+    std::chrono::duration<double> seconds = matchTime;
+    return seconds.count() > 0 ? scannedBytes / seconds.count() : 0;
+}
+
+std::string Metrics::toJson() const
+{
+    std::stringstream ss;
+
+    ss << "{\"regexp\":\"" << escape(regexp) << "\"";
+    ss << ",\"treePositions\":" << treePositions;
+    ss << ",\"followPosSize\":" << followPosSize;
+    ss << ",\"dfaStates\":" << dfaStates;
+    ss << ",\"dfaTransitions\":" << dfaTransitions;
+    ss << ",\"minimizedDfaStates\":" << minimizedDfaStates;
+    ss << ",\"transitionTableBytes\":" << transitionTableBytes;
+
+    ss << ",\"timeNs\":{";
+    ss << "\"infixToPostfix\":" << infixToPostfixTime.count();
+    ss << ",\"syntaxTree\":" << syntaxTreeTime.count();
+    ss << ",\"dfa\":" << dfaTime.count();
+    ss << ",\"minimize\":" << minimizeTime.count();
+    ss << ",\"match\":" << matchTime.count();
+    ss << "}";
+
+    ss << ",\"scannedBytes\":" << scannedBytes;
+    ss << ",\"matchedLines\":" << matchedLines;
+    ss << ",\"bytesPerSecond\":" << static_cast<uint64_t>(getBytesPerSecond());
+    ss << "}";
+
+    return ss.str();
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+
+class SyntaxTree;
+class Dfa;
+class Scanner;
+
+// construction and matching statistics of a single regexp, exported as one json object
+struct Metrics
+{
+    std::string regexp;
+
+    size_t treePositions = 0;
+    size_t followPosSize = 0;
+    size_t dfaStates = 0;
+    size_t dfaTransitions = 0;
+    size_t minimizedDfaStates = 0;
+    size_t transitionTableBytes = 0;
+
+    std::chrono::nanoseconds infixToPostfixTime{};
+    std::chrono::nanoseconds syntaxTreeTime{};
+    std::chrono::nanoseconds dfaTime{};
+    std::chrono::nanoseconds minimizeTime{};
+
+    size_t scannedBytes = 0;
+    size_t matchedLines = 0;
+    std::chrono::nanoseconds matchTime{};
+
+    void collect(const SyntaxTree &syntaxTree, const Dfa &dfa, const Scanner &scanner);
+
+    double getBytesPerSecond() const;
+    std::string toJson() const;
+};
+
+// runs f and adds its wall time to elapsed, returns whatever f returns
+template<typename F>
+decltype(auto) measure(std::chrono::nanoseconds &elapsed, F &&f)
+{
+    struct Timer
+    {
+        std::chrono::nanoseconds &elapsed;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+        ~Timer()
+        {
+            elapsed += std::chrono::steady_clock::now() - start;
+        }
+    } timer{elapsed};
+
+    return f();
+}
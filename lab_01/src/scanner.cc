@@ -0,0 +1,220 @@
+#include "scanner.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <thread>
+
+#include "dfa.h"
+
+Scanner::Scanner(const Dfa &dfa)
+{
+    // dfa state ids are dense, one extra row is the dead state looping to itself
+    deadState = static_cast<uint32_t>(dfa.getStates().size());
+    table.assign((deadState + 1) * alphabetSize, deadState);
+    accepting.assign(deadState + 1, false);
+
+    for (const auto &[id, transitions]: dfa.getTransitions())
+    {
+        for (const auto &[symbol, to]: transitions)
+        {
+            table[id * alphabetSize + static_cast<unsigned char>(symbol)] =
+                static_cast<uint32_t>(to);
+        }
+    }
+
+    for (const auto &id: dfa.getAcceptingStates())
+    {
+        accepting[id] = true;
+    }
+}
+
+bool Scanner::match(std::string_view line) const
+{
+    uint32_t state = 0;
+    for (const char &c: line)
+    {
+        state = table[state * alphabetSize + static_cast<unsigned char>(c)];
+        if (state == deadState)
+        {
+            return false;
+        }
+    }
+    return accepting[state];
+}
+
+size_t Scanner::scan(std::string_view data,
+    const LineCallback &onMatch,
+    size_t threads,
+    size_t chunkSize) const
+{
+    auto chunks = splitChunks(data, std::max<size_t>(chunkSize, 1));
+    threads = std::min(std::max<size_t>(threads, 1), chunks.size());
+
+    size_t matched = 0;
+
+    if (threads <= 1)
+    {
+        for (const auto &chunk: chunks)
+        {
+            for (const auto &line: scanChunk(chunk))
+            {
+                onMatch(line);
+                ++matched;
+            }
+        }
+        return matched;
+    }
+
+    // workers may run at most `window` chunks ahead of the writer, so memory for
+    // pending results stays bounded no matter how large the input is
+    const size_t window = threads * 4;
+
+    std::mutex mutex;
+    std::condition_variable canTake;
+    std::condition_variable chunkReady;
+
+    size_t next = 0;
+    size_t emitted = 0;
+    std::vector<std::vector<std::string_view>> results(chunks.size());
+    std::vector<bool> ready(chunks.size(), false);
+
+    auto worker = [&] {
+        for (;;)
+        {
+            size_t i = 0;
+            {
+                std::unique_lock lock(mutex);
+                canTake.wait(
+                    lock, [&] { return next >= chunks.size() || next < emitted + window; });
+                if (next >= chunks.size())
+                {
+                    return;
+                }
+                i = next++;
+            }
+
+            auto lines = scanChunk(chunks[i]);
+
+            {
+                std::lock_guard lock(mutex);
+                results[i] = std::move(lines);
+                ready[i] = true;
+            }
+            chunkReady.notify_one();
+        }
+    };
+
+    std::vector<std::thread> pool;
+    pool.reserve(threads);
+    for (size_t i = 0; i < threads; ++i)
+    {
+        pool.emplace_back(worker);
+    }
+
+    for (size_t i = 0; i < chunks.size(); ++i)
+    {
+        std::vector<std::string_view> lines;
+        {
+            std::unique_lock lock(mutex);
+            chunkReady.wait(lock, [&] { return ready[i]; });
+            lines = std::move(results[i]);
+            emitted = i + 1;
+        }
+        canTake.notify_all();
+
+        for (const auto &line: lines)
+        {
+            onMatch(line);
+        }
+        matched += lines.size();
+    }
+
+    for (auto &thread: pool)
+    {
+        thread.join();
+    }
+
+    return matched;
+}
+
+size_t Scanner::getTableSize() const
+{
+    return table.size() * sizeof(uint32_t);
+}
+
+std::vector<std::string_view> Scanner::scanChunk(std::string_view chunk) const
+{
+    std::vector<std::string_view> lines;
+
+    const char *p = chunk.data();
+    const char *end = p + chunk.size();
+    const char *lineStart = p;
+    uint32_t state = 0;
+
+    while (p != end)
+    {
+        if (*p == '\n')
+        {
+            if (accepting[state])
+            {
+                lines.emplace_back(lineStart, static_cast<size_t>(p - lineStart));
+            }
+            state = 0;
+            lineStart = ++p;
+            continue;
+        }
+
+        state = table[state * alphabetSize + static_cast<unsigned char>(*p)];
+        if (state == deadState)
+        {
+            // nothing can match anymore, skip the rest of the line at memchr speed
+            auto newline = static_cast<const char *>(
+                std::memchr(p, '\n', static_cast<size_t>(end - p)));
+            if (newline == nullptr)
+            {
+                return lines;
+            }
+            p = newline;
+            continue;
+        }
+        ++p;
+    }
+
+    // last line without a trailing newline
+    if (lineStart != end && accepting[state])
+    {
+        lines.emplace_back(lineStart, static_cast<size_t>(end - lineStart));
+    }
+
+    return lines;
+}
+
+std::vector<std::string_view> Scanner::splitChunks(std::string_view data, size_t chunkSize) const
+{
+    std::vector<std::string_view> chunks;
+
+    size_t begin = 0;
+    while (begin < data.size())
+    {
+        size_t end = begin + chunkSize;
+        if (end >= data.size())
+        {
+            end = data.size();
+        }
+        else if (auto newline = data.find('\n', end); newline == std::string_view::npos)
+        {
+            end = data.size();
+        }
+        else
+        {
+            end = newline + 1;
+        }
+
+        chunks.push_back(data.substr(begin, end - begin));
+        begin = end;
+    }
+
+    return chunks;
+}
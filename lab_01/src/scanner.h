@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string_view>
+#include <vector>
+
+class Dfa;
+
+// line-oriented matcher over a dense transition table compiled from a dfa,
+// the table is immutable after construction and shared by all worker threads
+class Scanner
+{
+    using LineCallback = std::function<void(std::string_view)>;
+
+public:
+    static constexpr size_t defaultChunkSize = 16 << 20;
+
+    explicit Scanner(const Dfa &dfa);
+
+    bool match(std::string_view line) const;
+
+    // calls onMatch for every fully matching line in input order, returns their count
+    size_t scan(std::string_view data,
+        const LineCallback &onMatch,
+        size_t threads = 1,
+        size_t chunkSize = defaultChunkSize) const;
+
+    size_t getTableSize() const;
+
+private:
+    std::vector<std::string_view> scanChunk(std::string_view chunk) const;
+    std::vector<std::string_view> splitChunks(std::string_view data, size_t chunkSize) const;
+
+private:
+    static constexpr size_t alphabetSize = 256;
+
+    std::vector<uint32_t> table;
+    std::vector<bool> accepting;
+    uint32_t deadState = 0;
+};
@@ -1,5 +1,7 @@
 #include "syntaxtree.h"
 
+#include <algorithm>
+#include <iterator>
 #include <sstream>
 
 inline constexpr char regexpEndingSymbol = '#';
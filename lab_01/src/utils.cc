@@ -55,6 +55,44 @@ auto formatRegexp(std::string_view regex)
     return result;
 }
 
+bool isValidRegexp(std::string_view regexp)
+{
+    // whether an operand ends right before i
+    auto follows = [&](size_t i) { return i > 0 && regexp[i - 1] != '(' && regexp[i - 1] != '|'; };
+
+    size_t depth = 0;
+    for (size_t i = 0; i < regexp.size(); ++i)
+    {
+        switch (regexp[i])
+        {
+            case '(':
+                ++depth;
+                break;
+            case ')':
+                if (depth == 0 || !follows(i))
+                {
+                    return false;
+                }
+                --depth;
+                break;
+            case '|':
+            case '*':
+                if (!follows(i))
+                {
+                    return false;
+                }
+                break;
+            case '&':
+            case regexpEndingSymbol:
+                return false;
+            default:
+                break;
+        }
+    }
+
+    return !regexp.empty() && depth == 0 && follows(regexp.size());
+}
+
 std::string infixToPostfix(std::string_view infix)
 {
     auto formatted = formatRegexp(infix);
@@ -2,4 +2,10 @@
 
 #include <string_view>
 
+/*
+ * Whether infixToPostfix can take regexp: not empty, parentheses balanced and not empty,
+ * operands on both sides of | and before *, no '&' or '#' which are used internally
+ */
+bool isValidRegexp(std::string_view regexp);
+
 std::string infixToPostfix(std::string_view infix);
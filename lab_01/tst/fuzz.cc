@@ -0,0 +1,305 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <regex>
+#include <string>
+#include <vector>
+
+#include "utils.h"
+#include "syntaxtree.h"
+#include "dfa.h"
+#include "scanner.h"
+
+/*
+ * Differential harness: random patterns over the supported syntax
+ * (symbols, implicit concatenation, '|', '*', parentheses) are checked
+ * against std::regex_match on random and on generated matching inputs
+ */
+static constexpr char alphabet[] = {'a', 'b', 'c'};
+
+struct Pattern
+{
+    enum class Kind
+    {
+        Symbol,
+        Concatenation,
+        Alternation,
+        Star,
+    };
+
+    Kind kind;
+    char symbol = 0;
+    std::vector<std::unique_ptr<Pattern>> children;
+};
+
+class Generator
+{
+public:
+    explicit Generator(unsigned seed) : random(seed) {}
+
+    // nested quantifiers like "(a*)*" send std::regex into exponential backtracking,
+    // so the body of a star never contains another star
+    std::unique_ptr<Pattern> pattern(size_t depth, bool withStar = true)
+    {
+        auto node = std::make_unique<Pattern>();
+        auto choice = depth == 0 ? 0 : uniform(0, withStar ? 9 : 8);
+
+        if (choice < 4)
+        {
+            node->kind = Pattern::Kind::Symbol;
+            node->symbol = alphabet[uniform(0, std::size(alphabet) - 1)];
+        }
+        else if (choice < 7)
+        {
+            node->kind = Pattern::Kind::Concatenation;
+            for (size_t i = 0, count = uniform(2, 3); i < count; ++i)
+            {
+                node->children.push_back(pattern(depth - 1, withStar));
+            }
+        }
+        else if (choice < 9)
+        {
+            node->kind = Pattern::Kind::Alternation;
+            for (size_t i = 0, count = uniform(2, 3); i < count; ++i)
+            {
+                node->children.push_back(pattern(depth - 1, withStar));
+            }
+        }
+        else
+        {
+            node->kind = Pattern::Kind::Star;
+            node->children.push_back(pattern(depth - 1, false));
+        }
+
+        return node;
+    }
+
+    // a random word from the language of the pattern
+    std::string sample(const Pattern &pattern)
+    {
+        switch (pattern.kind)
+        {
+            case Pattern::Kind::Symbol:
+                return std::string(1, pattern.symbol);
+            case Pattern::Kind::Concatenation:
+            {
+                std::string result;
+                for (const auto &child: pattern.children)
+                {
+                    result += sample(*child);
+                }
+                return result;
+            }
+            case Pattern::Kind::Alternation:
+                return sample(*pattern.children[uniform(0, pattern.children.size() - 1)]);
+            case Pattern::Kind::Star:
+            {
+                std::string result;
+                for (size_t i = 0, count = uniform(0, 3); i < count; ++i)
+                {
+                    result += sample(*pattern.children.front());
+                }
+                return result;
+            }
+        }
+        return {};
+    }
+
+    std::string word(size_t maxLength)
+    {
+        std::string result(uniform(0, maxLength), 0);
+        for (auto &c: result)
+        {
+            c = alphabet[uniform(0, std::size(alphabet) - 1)];
+        }
+        return result;
+    }
+
+    // a word from the language with one symbol changed, the interesting near misses
+    std::string mutate(std::string word)
+    {
+        if (!word.empty())
+        {
+            word[uniform(0, word.size() - 1)] = alphabet[uniform(0, std::size(alphabet) - 1)];
+        }
+        return word;
+    }
+
+private:
+    size_t uniform(size_t from, size_t to)
+    {
+        return std::uniform_int_distribution<size_t>(from, to)(random);
+    }
+
+private:
+    std::mt19937 random;
+};
+
+static std::string toString(const Pattern &pattern, bool grouped = false)
+{
+    switch (pattern.kind)
+    {
+        case Pattern::Kind::Symbol:
+            return std::string(1, pattern.symbol);
+        case Pattern::Kind::Concatenation:
+        {
+            std::string result;
+            for (const auto &child: pattern.children)
+            {
+                result += toString(*child, child->kind == Pattern::Kind::Alternation);
+            }
+            return grouped ? "(" + result + ")" : result;
+        }
+        case Pattern::Kind::Alternation:
+        {
+            std::string result;
+            for (const auto &child: pattern.children)
+            {
+                result += (result.empty() ? "" : "|") + toString(*child);
+            }
+            return grouped ? "(" + result + ")" : result;
+        }
+        case Pattern::Kind::Star:
+        {
+            const auto &child = *pattern.children.front();
+            return toString(child, child.kind != Pattern::Kind::Symbol) + "*";
+        }
+    }
+    return {};
+}
+
+struct Engines
+{
+    explicit Engines(std::string_view regexp)
+    {
+        syntaxTree.create(infixToPostfix(regexp));
+        dfa.create(syntaxTree.getRoot(), syntaxTree);
+        dfa.minimize(syntaxTree.getAlphabet());
+        scanner = std::make_unique<Scanner>(dfa);
+    }
+
+    SyntaxTree syntaxTree;
+    Dfa dfa;
+    std::unique_ptr<Scanner> scanner;
+};
+
+TEST(Fuzz, TestsThatAllEnginesAgreeWithStdRegex)
+{
+    constexpr size_t patterns = 2000;
+    constexpr size_t wordsPerPattern = 30;
+
+    Generator generator(20191107);
+
+    for (size_t i = 0; i < patterns; ++i)
+    {
+        auto pattern = generator.pattern(4);
+        auto regexp = toString(*pattern);
+
+        Engines engines(regexp);
+        const std::regex reference(regexp);
+
+        for (size_t j = 0; j < wordsPerPattern; ++j)
+        {
+            std::string word;
+            switch (j % 3)
+            {
+                case 0:
+                    word = generator.word(8);
+                    break;
+                case 1:
+                    word = generator.sample(*pattern);
+                    break;
+                default:
+                    word = generator.mutate(generator.sample(*pattern));
+                    break;
+            }
+
+            bool expected = std::regex_match(word, reference);
+
+            ASSERT_EQ(engines.dfa.match(word), expected) << regexp << " on '" << word << "'";
+            ASSERT_EQ(engines.dfa.matchMinimized(word), expected)
+                << regexp << " on '" << word << "'";
+            ASSERT_EQ(engines.scanner->match(word), expected) << regexp << " on '" << word << "'";
+        }
+    }
+}
+
+TEST(Fuzz, RecordsRelativeThroughput)
+{
+    constexpr size_t patterns = 20;
+    constexpr size_t wordsPerPattern = 2000;
+
+    Generator generator(42);
+
+    std::chrono::nanoseconds referenceTime{};
+    std::chrono::nanoseconds dfaTime{};
+    std::chrono::nanoseconds minimizedTime{};
+    std::chrono::nanoseconds scannerTime{};
+    size_t agreed = 0;
+
+    auto timed = [](std::chrono::nanoseconds &elapsed, auto &&f) {
+        auto start = std::chrono::steady_clock::now();
+        size_t count = f();
+        elapsed += std::chrono::steady_clock::now() - start;
+        return count;
+    };
+
+    for (size_t i = 0; i < patterns; ++i)
+    {
+        auto pattern = generator.pattern(5);
+        auto regexp = toString(*pattern);
+
+        Engines engines(regexp);
+        const std::regex reference(regexp);
+
+        std::vector<std::string> words;
+        for (size_t j = 0; j < wordsPerPattern; ++j)
+        {
+            words.push_back(j % 2 ? generator.sample(*pattern) : generator.word(32));
+        }
+
+        auto count = [&](auto &&match) {
+            size_t matched = 0;
+            for (const auto &word: words)
+            {
+                matched += match(word);
+            }
+            return matched;
+        };
+
+        auto expected = timed(referenceTime,
+            [&] { return count([&](auto &&w) { return std::regex_match(w, reference); }); });
+        agreed += expected ==
+            timed(dfaTime, [&] { return count([&](auto &&w) { return engines.dfa.match(w); }); });
+        agreed += expected == timed(minimizedTime, [&] {
+            return count([&](auto &&w) { return engines.dfa.matchMinimized(w); });
+        });
+        agreed += expected == timed(scannerTime, [&] {
+            return count([&](auto &&w) { return engines.scanner->match(w); });
+        });
+    }
+
+    EXPECT_EQ(agreed, patterns * 3);
+
+    auto speedup = [&](std::chrono::nanoseconds time) {
+        return static_cast<double>(referenceTime.count()) / std::max<int64_t>(time.count(), 1);
+    };
+
+    std::cout << "throughput relative to std::regex: match x" << speedup(dfaTime)
+              << ", matchMinimized x" << speedup(minimizedTime) << ", Scanner::match x"
+              << speedup(scannerTime) << std::endl;
+
+    RecordProperty("dfaSpeedup", std::to_string(speedup(dfaTime)));
+    RecordProperty("minimizedSpeedup", std::to_string(speedup(minimizedTime)));
+    RecordProperty("scannerSpeedup", std::to_string(speedup(scannerTime)));
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,79 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include "utils.h"
+#include "syntaxtree.h"
+#include "dfa.h"
+#include "scanner.h"
+#include "metrics.h"
+
+TEST(Metrics, TestsThatSizesAreCollected)
+{
+    Metrics metrics;
+    metrics.regexp = "(a|b)*abb";
+
+    auto postfix = measure(metrics.infixToPostfixTime, [&] { return infixToPostfix(metrics.regexp); });
+
+    SyntaxTree syntaxTree;
+    measure(metrics.syntaxTreeTime, [&] { syntaxTree.create(postfix); });
+
+    Dfa dfa;
+    dfa.create(syntaxTree.getRoot(), syntaxTree);
+    dfa.minimize(syntaxTree.getAlphabet());
+
+    const Scanner scanner(dfa);
+    metrics.collect(syntaxTree, dfa, scanner);
+
+    // a, b, a, b, b and the end marker
+    EXPECT_EQ(metrics.treePositions, 6);
+    EXPECT_EQ(metrics.followPosSize, 9);
+    EXPECT_EQ(metrics.dfaStates, 4);
+    EXPECT_EQ(metrics.dfaTransitions, 8);
+    EXPECT_EQ(metrics.minimizedDfaStates, 4);
+    EXPECT_EQ(metrics.transitionTableBytes, 5 * 256 * sizeof(uint32_t));
+    EXPECT_GT(metrics.infixToPostfixTime.count(), 0);
+    EXPECT_GT(metrics.syntaxTreeTime.count(), 0);
+}
+
+TEST(Metrics, TestsThatMinimizedStatesAreCounted)
+{
+    Metrics metrics;
+    SyntaxTree syntaxTree;
+    syntaxTree.create(infixToPostfix("ab|cb"));
+
+    Dfa dfa;
+    dfa.create(syntaxTree.getRoot(), syntaxTree);
+    dfa.minimize(syntaxTree.getAlphabet());
+
+    const Scanner scanner(dfa);
+    metrics.collect(syntaxTree, dfa, scanner);
+
+    EXPECT_EQ(metrics.treePositions, 5);
+
+    // the states after a and after c both only wait for b
+    EXPECT_EQ(metrics.dfaStates, 4);
+    EXPECT_EQ(metrics.minimizedDfaStates, 3);
+    EXPECT_THAT(metrics.toJson(), testing::HasSubstr("\"minimizedDfaStates\":3"));
+}
+
+TEST(Metrics, TestsThatJsonIsWritten)
+{
+    Metrics metrics;
+    metrics.regexp = "a\"b";
+    metrics.dfaStates = 3;
+    metrics.scannedBytes = 1000;
+    metrics.matchTime = std::chrono::milliseconds(1);
+
+    auto json = metrics.toJson();
+
+    EXPECT_THAT(json, testing::StartsWith("{\"regexp\":\"a\\\"b\""));
+    EXPECT_THAT(json, testing::HasSubstr("\"dfaStates\":3"));
+    EXPECT_THAT(json, testing::HasSubstr("\"bytesPerSecond\":1000000"));
+    EXPECT_THAT(json, testing::EndsWith("}"));
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
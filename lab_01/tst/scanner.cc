@@ -0,0 +1,77 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <string>
+#include <vector>
+
+#include "utils.h"
+#include "syntaxtree.h"
+#include "dfa.h"
+#include "scanner.h"
+
+static Dfa makeDfa(std::string_view regexp)
+{
+    SyntaxTree syntaxTree;
+    syntaxTree.create(infixToPostfix(regexp));
+
+    Dfa dfa;
+    dfa.create(syntaxTree.getRoot(), syntaxTree);
+    return dfa;
+}
+
+TEST(Scanner, TestsThatLinesAreMatched)
+{
+    const Scanner scanner(makeDfa("(a|b)*abb"));
+
+    EXPECT_TRUE(scanner.match("abb"));
+    EXPECT_TRUE(scanner.match("ababb"));
+    EXPECT_FALSE(scanner.match("abba"));
+    EXPECT_FALSE(scanner.match("abc"));
+    EXPECT_FALSE(scanner.match(""));
+}
+
+TEST(Scanner, TestsThatMatchingLinesAreReportedInOrder)
+{
+    const Scanner scanner(makeDfa("a(a|b)*"));
+    const std::string data = "ab\nba\n\naaa\nabc\nabab";
+
+    std::vector<std::string> lines;
+    auto count =
+        scanner.scan(data, [&](std::string_view line) { lines.emplace_back(line); });
+
+    EXPECT_EQ(count, 3);
+    ASSERT_THAT(lines, testing::ElementsAre("ab", "aaa", "abab"));
+}
+
+TEST(Scanner, TestsThatParallelScanKeepsOrder)
+{
+    const Scanner scanner(makeDfa("(a|b)*abb"));
+
+    std::string data;
+    std::vector<std::string> expected;
+    for (size_t i = 0; i < 5000; ++i)
+    {
+        auto line = std::string(i % 7, 'a') + (i % 3 == 0 ? "abb" : "bab");
+        if (i % 3 == 0)
+        {
+            expected.push_back(line);
+        }
+        data += line + '\n';
+    }
+
+    for (size_t threads: {1, 2, 8})
+    {
+        std::vector<std::string> lines;
+        auto count = scanner.scan(
+            data, [&](std::string_view line) { lines.emplace_back(line); }, threads, 64);
+
+        EXPECT_EQ(count, expected.size());
+        EXPECT_EQ(lines, expected);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
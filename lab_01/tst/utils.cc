@@ -11,6 +11,27 @@ TEST(Utils, InfixToPostfix)
     EXPECT_EQ(postfix, "ab|*b&a&a*&aa&b|&#&");
 }
 
+TEST(Utils, TestsThatMalformedRegexpsAreRejected)
+{
+    EXPECT_TRUE(isValidRegexp("(a|b)*baa*(aa|b)"));
+    EXPECT_TRUE(isValidRegexp("a**"));
+    EXPECT_TRUE(isValidRegexp("((a))"));
+
+    EXPECT_FALSE(isValidRegexp(""));
+    EXPECT_FALSE(isValidRegexp("a)"));
+    EXPECT_FALSE(isValidRegexp("(a"));
+    EXPECT_FALSE(isValidRegexp("()"));
+    EXPECT_FALSE(isValidRegexp("a||b"));
+    EXPECT_FALSE(isValidRegexp("|a"));
+    EXPECT_FALSE(isValidRegexp("a|"));
+    EXPECT_FALSE(isValidRegexp("(a|)b"));
+    EXPECT_FALSE(isValidRegexp("*"));
+    EXPECT_FALSE(isValidRegexp("(*a)"));
+    EXPECT_FALSE(isValidRegexp("a|*"));
+    EXPECT_FALSE(isValidRegexp("a&b"));
+    EXPECT_FALSE(isValidRegexp("a#"));
+}
+
 int main(int argc, char **argv)
 {
     ::testing::InitGoogleTest(&argc, argv);
@@ -0,0 +1,77 @@
+#include "grammargen.h"
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+CompactGrammar generateGrammar(const GeneratorOptions &options)
+{
+    std::mt19937 random(options.seed);
+    auto uniform = [&](size_t from, size_t to) {
+        return std::uniform_int_distribution<size_t>(from, to)(random);
+    };
+    auto chance = [&](double p) { return std::bernoulli_distribution(p)(random); };
+
+    CompactGrammar grammar;
+    std::vector<SymbolId> nonterms(options.nonterms);
+    std::vector<SymbolId> terminals(std::max<size_t>(options.terminals, 1));
+    for (size_t i = 0; i < nonterms.size(); ++i)
+    {
+        nonterms[i] = grammar.symbols.intern("N" + std::to_string(i), true);
+    }
+    for (size_t i = 0; i < terminals.size(); ++i)
+    {
+        terminals[i] = grammar.symbols.intern("t" + std::to_string(i), false);
+    }
+    if (nonterms.empty())
+    {
+        return grammar;
+    }
+    grammar.start = nonterms.front();
+
+    auto terminal = [&] { return terminals[uniform(0, terminals.size() - 1)]; };
+    auto any = [&](size_t from) {
+        auto k = uniform(0, nonterms.size() - from + terminals.size() - 1);
+        return k < terminals.size() ? terminals[k] : nonterms[from + k - terminals.size()];
+    };
+
+    std::vector<SymbolId> rhs;
+    for (size_t i = 0; i < nonterms.size(); ++i)
+    {
+        auto lhs = nonterms[i];
+        grammar.addProduction(lhs, std::vector<SymbolId>{terminal()});
+
+        rhs = {terminal()};
+        for (auto child = 2 * i + 1; child < nonterms.size() && child <= 2 * i + 2; ++child)
+        {
+            rhs.push_back(nonterms[child]);
+        }
+        grammar.addProduction(lhs, rhs);
+
+        if (chance(options.nullableDensity))
+        {
+            grammar.addProduction(lhs, std::vector<SymbolId>());
+        }
+
+        // Ni -> Ni+1 ... inside every block of depth nonterminals, the last one closes it
+        if (auto depth = options.leftRecursionDepth; depth > 0)
+        {
+            auto block = i - i % depth;
+            auto next = i + 1 == block + depth || i + 1 == nonterms.size() ? block : i + 1;
+            grammar.addProduction(lhs, std::vector<SymbolId>{nonterms[next], terminal()});
+        }
+
+        for (size_t rule = 0; rule < options.rulesPerNonterm; ++rule)
+        {
+            rhs = {any(i + 1)};
+            for (auto length = uniform(1, std::max<size_t>(options.maxRuleLength, 1));
+                 rhs.size() < length;)
+            {
+                rhs.push_back(any(i + 1));
+            }
+            grammar.addProduction(lhs, rhs);
+        }
+    }
+    return grammar;
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstddef>
+
+#include "compactgrammar.h"
+
+struct GeneratorOptions
+{
+    size_t nonterms = 1000;
+    size_t terminals = 50;
+    size_t rulesPerNonterm = 4;  // besides the ones every nonterminal gets
+    size_t maxRuleLength = 5;
+    double nullableDensity = 0.1;  // share of nonterminals with an epsilon rule
+    size_t leftRecursionDepth = 2;  // length of left recursive cycles, 0 for none
+    unsigned seed = 20191201;
+};
+
+/*
+ * Random grammar N0..Nn over t0..tk with start N0. Every nonterminal derives a
+ * terminal and is reachable through a binary tree of rules, so removing useless
+ * symbols keeps it whole. Left recursion comes only from the cycles the options ask
+ * for: other rules only mention nonterminals of a higher number, so no rule starts
+ * with a lower one even once nullable symbols are dropped
+ */
+CompactGrammar generateGrammar(const GeneratorOptions &options);
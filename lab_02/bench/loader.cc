@@ -0,0 +1,79 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+
+#include "bnf.h"
+
+// random grammar text with nonterms * 10 productions
+static std::string generate(size_t nonterms, std::mt19937 &random)
+{
+    auto uniform = [&](size_t from, size_t to) {
+        return std::uniform_int_distribution<size_t>(from, to)(random);
+    };
+
+    std::string text;
+    for (size_t i = 0; i < nonterms; ++i)
+    {
+        text += "N" + std::to_string(i) + " ->";
+        for (size_t r = 0; r < 10; ++r)
+        {
+            text += r == 0 ? " " : "\n    | ";
+            for (size_t k = 0, length = uniform(1, 6); k < length; ++k)
+            {
+                text += k == 0 ? "" : " ";
+                text += uniform(0, 2) == 0 ? "N" + std::to_string(uniform(0, nonterms - 1))
+                                           : "t" + std::to_string(uniform(0, 49));
+            }
+        }
+        text += '\n';
+    }
+    return text;
+}
+
+// best of runs, in milliseconds
+template<typename F>
+static double measure(size_t runs, F &&f)
+{
+    double best = 1e100;
+    for (size_t run = 0; run < runs; ++run)
+    {
+        auto begin = std::chrono::steady_clock::now();
+        f();
+        auto end = std::chrono::steady_clock::now();
+        best = std::min(best, std::chrono::duration<double, std::milli>(end - begin).count());
+    }
+    return best;
+}
+
+int main(int argc, char **argv)
+{
+    size_t nonterms = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 10000;
+    size_t runs = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 5;
+
+    std::mt19937 random(20191201);
+    auto text = generate(nonterms, random);
+    auto grammar = parseBnf(text);
+
+    auto parseTime = measure(runs, [&] { grammar = parseBnf(text); });
+
+    std::string written;
+    auto writeTime = measure(runs, [&] {
+        std::ostringstream out;
+        writeBnf(out, grammar);
+        written = out.str();
+    });
+
+    auto megabytes = static_cast<double>(text.size()) / (1 << 20);
+    std::cout << "productions: " << grammar.productions.size()
+              << ", symbols: " << grammar.symbols.size() << ", text: " << megabytes << " MiB\n";
+    std::cout << "parseBnf: " << parseTime << " ms, " << megabytes / parseTime * 1000
+              << " MiB/s\n";
+    std::cout << "writeBnf: " << writeTime << " ms, "
+              << static_cast<double>(written.size()) / (1 << 20) / writeTime * 1000
+              << " MiB/s\n";
+    return 0;
+}
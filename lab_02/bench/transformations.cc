@@ -0,0 +1,257 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "chomskyutils.h"
+#include "grammargen.h"
+#include "leftutils.h"
+#include "utils.h"
+
+/*
+ * Heap use of the whole program, counted by the replaced global operator new.
+ * Every block carries its size in a header so delete can subtract it
+ */
+static size_t allocated = 0;
+static size_t peak = 0;
+
+static constexpr size_t header = alignof(std::max_align_t);
+
+void *operator new(size_t size)
+{
+    auto block = static_cast<char *>(std::malloc(size + header));
+    if (!block)
+    {
+        throw std::bad_alloc();
+    }
+    std::memcpy(block, &size, sizeof(size));
+    allocated += size;
+    peak = std::max(peak, allocated);
+    return block + header;
+}
+
+void operator delete(void *pointer) noexcept
+{
+    if (!pointer)
+    {
+        return;
+    }
+    auto block = static_cast<char *>(pointer) - header;
+    size_t size;
+    std::memcpy(&size, block, sizeof(size));
+    allocated -= size;
+    std::free(block);
+}
+
+void *operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete[](void *pointer) noexcept
+{
+    operator delete(pointer);
+}
+
+void operator delete(void *pointer, size_t) noexcept
+{
+    operator delete(pointer);
+}
+
+void operator delete[](void *pointer, size_t) noexcept
+{
+    operator delete(pointer);
+}
+
+struct Measurement
+{
+    double milliseconds = 0;
+    size_t peakBytes = 0;  // above what was allocated before the call
+    size_t output = 0;  // productions of the result, or what the function returns
+    bool failed = false;
+};
+
+// best time of runs, peak memory of the first one
+static Measurement measure(size_t runs, const std::function<size_t()> &f)
+{
+    Measurement result;
+    result.milliseconds = 1e100;
+    for (size_t run = 0; run < runs; ++run)
+    {
+        auto before = allocated;
+        peak = allocated;
+        auto begin = std::chrono::steady_clock::now();
+        try
+        {
+            result.output = f();
+        }
+        catch (const std::length_error &)
+        {
+            result.failed = true;
+            return result;
+        }
+        auto end = std::chrono::steady_clock::now();
+
+        result.milliseconds = std::min(
+            result.milliseconds, std::chrono::duration<double, std::milli>(end - begin).count());
+        result.peakBytes = run == 0 ? peak - before : result.peakBytes;
+    }
+    return result;
+}
+
+static size_t count(const std::vector<bool> &flags)
+{
+    return static_cast<size_t>(std::count(std::begin(flags), std::end(flags), true));
+}
+
+static void usage(const char *name)
+{
+    std::cerr << "usage: " << name << " [--max nonterms] [--runs n] [--rules n] [--length n]"
+              << " [--nullable density] [--depth n] [--threads n] [--seed n]\n";
+}
+
+int main(int argc, char **argv)
+{
+    GeneratorOptions options;
+    size_t maxNonterms = 10000;
+    size_t runs = 3;
+    size_t threads = 4;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string option = argv[i];
+        if (i + 1 == argc)
+        {
+            usage(argv[0]);
+            return 1;
+        }
+
+        auto value = argv[++i];
+        if (option == "--max")
+        {
+            maxNonterms = std::strtoul(value, nullptr, 10);
+        }
+        else if (option == "--runs")
+        {
+            runs = std::max<size_t>(std::strtoul(value, nullptr, 10), 1);
+        }
+        else if (option == "--rules")
+        {
+            options.rulesPerNonterm = std::strtoul(value, nullptr, 10);
+        }
+        else if (option == "--length")
+        {
+            options.maxRuleLength = std::strtoul(value, nullptr, 10);
+        }
+        else if (option == "--nullable")
+        {
+            options.nullableDensity = std::strtod(value, nullptr);
+        }
+        else if (option == "--depth")
+        {
+            options.leftRecursionDepth = std::strtoul(value, nullptr, 10);
+        }
+        else if (option == "--threads")
+        {
+            threads = std::strtoul(value, nullptr, 10);
+        }
+        else if (option == "--seed")
+        {
+            options.seed = static_cast<unsigned>(std::strtoul(value, nullptr, 10));
+        }
+        else
+        {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    // input of toCompact, the generated grammar in the other representation
+    Grammar named;
+    std::string start;
+    auto size = [](const Grammar &g) {
+        size_t result = 0;
+        for (auto &&[lhs, rules]: g)
+        {
+            result += rules.size();
+        }
+        return result;
+    };
+
+    // the Grammar overloads convert to and from CompactGrammar around these
+    const std::vector<std::pair<std::string, std::function<size_t(const CompactGrammar &)>>>
+        passes = {
+            {"toGrammar", [&](auto &&g) { return size(toGrammar(g)); }},
+            {"toCompact", [&](auto &&) { return toCompact(named, start).productions.size(); }},
+            {"findEpsilonNonterms", [](auto &&g) { return count(findEpsilonNonterms(g)); }},
+            {"findGeneratingSymbols", [](auto &&g) { return count(findGeneratingSymbols(g)); }},
+            {"findReachableSymbols", [](auto &&g) { return count(findReachableSymbols(g)); }},
+            {"estimateEpsilonExpansion", [](auto &&g) { return estimateEpsilonExpansion(g); }},
+            {"removeUselessSymbols",
+                [](auto &&g) { return removeUselessSymbols(g).productions.size(); }},
+            {"removeEpsilonNonterms",
+                [](auto &&g) { return removeEpsilonNonterms(g).productions.size(); }},
+            {"removeEpsilonNonterms/helpers",
+                [](auto &&g) {
+                    return removeEpsilonNonterms(g, EpsilonElimination::Helpers)
+                        .productions.size();
+                }},
+            {"removeEpsilonNonterms/threads",
+                [&](auto &&g) {
+                    return removeEpsilonNonterms(
+                        g, EpsilonElimination::Permutations, maxEpsilonExpansion, threads)
+                        .productions.size();
+                }},
+            {"deleteLongRules", [](auto &&g) { return deleteLongRules(g).productions.size(); }},
+            {"deleteLongRules/threads",
+                [&](auto &&g) { return deleteLongRules(g, threads).productions.size(); }},
+            {"deleteChainRules", [](auto &&g) { return deleteChainRules(g).productions.size(); }},
+            {"toChomskyNormalForm",
+                [](auto &&g) { return toChomskyNormalForm(g).productions.size(); }},
+            {"eliminateLeftRecursion",
+                [](auto &&g) { return eliminateLeftRecursion(g).productions.size(); }},
+            {"eliminateLeftRecursionInPlace",
+                [](auto &&g) {
+                    auto copy = g;
+                    return eliminateLeftRecursionInPlace(copy).productionsAfter;
+                }},
+            {"leftFactoring", [](auto &&g) { return leftFactoring(g).productions.size(); }},
+            {"leftFactoring/threads",
+                [&](auto &&g) { return leftFactoring(g, threads).productions.size(); }},
+        };
+
+    std::cout << std::left << std::setw(32) << "pass" << std::right << std::setw(10)
+              << "nonterms" << std::setw(12) << "input" << std::setw(12) << "ms"
+              << std::setw(14) << "peak KiB" << std::setw(12) << "output" << '\n';
+
+    for (size_t nonterms = 100; nonterms <= maxNonterms; nonterms *= 10)
+    {
+        options.nonterms = nonterms;
+        auto grammar = generateGrammar(options);
+        named = toGrammar(grammar);
+        start = grammar.symbols.getName(grammar.start);
+
+        for (auto &&[name, pass]: passes)
+        {
+            auto result = measure(runs, [&, &pass = pass] { return pass(grammar); });
+            std::cout << std::left << std::setw(32) << name << std::right << std::setw(10)
+                      << nonterms << std::setw(12) << grammar.productions.size();
+            if (result.failed)
+            {
+                std::cout << std::setw(12) << "limit" << std::endl;
+                continue;
+            }
+            std::cout << std::setw(12) << std::fixed << std::setprecision(2)
+                      << result.milliseconds << std::setw(14) << result.peakBytes / 1024
+                      << std::setw(12) << result.output << std::endl;
+        }
+    }
+    return 0;
+}
@@ -1,8 +1,72 @@
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+
 #include "leftutils.h"
 #include "chomskyutils.h"
+#include "bnf.h"
+#include "cache.h"
+
+// the same passes over a grammar file, every step written in the file format;
+// with a cache directory steps done before on an equal grammar are read back
+static void transform(const std::string &path, const std::string &cacheDirectory)
+{
+    auto grammar = loadBnf(path);
+    auto step = [](const char *title, const CompactGrammar &result) {
+        std::cout << title << "\n===\n";
+        writeBnf(std::cout, result);
+        std::cout << "===\n\n";
+    };
+
+    std::optional<GrammarCache> cache;
+    if (!cacheDirectory.empty())
+    {
+        cache.emplace(cacheDirectory);
+    }
+    auto run = [&](const char *name, const CompactGrammar &input, auto &&pass) {
+        auto pipeline = [&](const CompactGrammar &g) { return pass(g); };
+        return cache ? cache->transform(input, name, pipeline) : pipeline(input);
+    };
+
+    step("GRAMMAR", grammar);
 
-int main()
+    auto grammarWithoutLongRules =
+        run("deleteLongRules", grammar, [](auto &&g) { return deleteLongRules(g); });
+    step("WITHOUT LONG RULES", grammarWithoutLongRules);
+
+    auto grammarWithoutEpsilonNonterminals = run("removeEpsilonNonterms",
+        grammarWithoutLongRules, [](auto &&g) { return removeEpsilonNonterms(g); });
+    step("WITHOUT EPSILON RULES", grammarWithoutEpsilonNonterminals);
+
+    step("WITHOUT CHAIN RULES",
+        run("deleteChainRules", grammarWithoutEpsilonNonterminals,
+            [](auto &&g) { return deleteChainRules(g); }));
+
+    auto grammarWithoutLeftRecursion = run(
+        "eliminateLeftRecursion", grammar, [](auto &&g) { return eliminateLeftRecursion(g); });
+    step("WITHOUT LEFT RECURSION", grammarWithoutLeftRecursion);
+
+    step("LEFT FACTORED",
+        run("leftFactoring", grammarWithoutLeftRecursion,
+            [](auto &&g) { return leftFactoring(g); }));
+}
+
+int main(int argc, char **argv)
 {
+    if (argc > 1)
+    {
+        try
+        {
+            transform(argv[1], argc > 2 ? argv[2] : "");
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << e.what() << "\n";
+            return 1;
+        }
+        return 0;
+    }
+
     Grammar grammar = {
         {"S", {"aXbX", "aZ"}},
         {"X", {"aY", "bY", epsilon}},
@@ -0,0 +1,234 @@
+#include "analysis.h"
+
+#include <algorithm>
+
+#include "utils.h"
+
+static constexpr size_t noIndex = static_cast<size_t>(-1);
+
+GrammarAnalysis::GrammarAnalysis(const CompactGrammar &grammar)
+    : grammar(grammar), terminalIndices(grammar.symbols.size(), noIndex)
+{
+    for (SymbolId id = 0; id < grammar.symbols.size(); ++id)
+    {
+        if (!grammar.symbols.isNonterm(id))
+        {
+            terminalIndices[id] = terminals.size();
+            terminals.push_back(id);
+        }
+    }
+
+    nullable = findEpsilonNonterms(grammar);
+    computeFirst();
+    computeFollow();
+}
+
+void GrammarAnalysis::propagate(std::vector<Bitset> &sets,
+    std::vector<std::vector<SymbolId>> &dependents,
+    std::vector<SymbolId> worklist)
+{
+    std::vector<bool> queued(sets.size(), false);
+    for (auto &&symbol: worklist)
+    {
+        queued[symbol] = true;
+    }
+
+    for (auto &&edges: dependents)
+    {
+        std::sort(std::begin(edges), std::end(edges));
+        edges.erase(std::unique(std::begin(edges), std::end(edges)), std::end(edges));
+    }
+
+    while (!worklist.empty())
+    {
+        auto symbol = worklist.back();
+        worklist.pop_back();
+        queued[symbol] = false;
+
+        for (auto &&dependent: dependents[symbol])
+        {
+            if (dependent != symbol && sets[dependent].unite(sets[symbol]) && !queued[dependent])
+            {
+                queued[dependent] = true;
+                worklist.push_back(dependent);
+            }
+        }
+    }
+}
+
+void GrammarAnalysis::computeFirst()
+{
+    first.assign(grammar.symbols.size(), Bitset(terminals.size() + 1));
+
+    // FIRST(B) is part of FIRST(A) for every A -> x B y with nullable x
+    std::vector<std::vector<SymbolId>> dependents(grammar.symbols.size());
+
+    for (auto &&production: grammar.productions)
+    {
+        for (auto &&symbol: grammar.getRhs(production))
+        {
+            if (grammar.symbols.isNonterm(symbol))
+            {
+                dependents[symbol].push_back(production.lhs);
+            }
+            else
+            {
+                first[production.lhs].set(terminalIndices[symbol]);
+            }
+
+            if (!nullable[symbol])
+            {
+                break;
+            }
+        }
+    }
+
+    std::vector<SymbolId> worklist;
+    for (SymbolId id = 0; id < grammar.symbols.size(); ++id)
+    {
+        if (grammar.symbols.isNonterm(id) && !first[id].none())
+        {
+            worklist.push_back(id);
+        }
+    }
+
+    propagate(first, dependents, std::move(worklist));
+}
+
+void GrammarAnalysis::computeFollow()
+{
+    follow.assign(grammar.symbols.size(), Bitset(terminals.size() + 1));
+    if (grammar.start != noSymbol)
+    {
+        follow[grammar.start].set(getEndMarkerIndex());
+    }
+
+    // FOLLOW(A) is part of FOLLOW(B) for every A -> x B y with nullable y
+    std::vector<std::vector<SymbolId>> dependents(grammar.symbols.size());
+
+    // FIRST of the suffix right of the current symbol, built right to left
+    Bitset trailer(terminals.size() + 1);
+
+    for (auto &&production: grammar.productions)
+    {
+        auto rhs = grammar.getRhs(production);
+        trailer.reset();
+        bool trailerNullable = true;
+
+        for (auto i = rhs.size(); i-- > 0;)
+        {
+            auto symbol = rhs[i];
+            if (grammar.symbols.isNonterm(symbol))
+            {
+                follow[symbol].unite(trailer);
+                if (trailerNullable)
+                {
+                    dependents[production.lhs].push_back(symbol);
+                }
+            }
+
+            if (!nullable[symbol])
+            {
+                trailer.reset();
+                trailerNullable = false;
+            }
+
+            if (grammar.symbols.isNonterm(symbol))
+            {
+                trailer.unite(first[symbol]);
+            }
+            else
+            {
+                trailer.set(terminalIndices[symbol]);
+            }
+        }
+    }
+
+    std::vector<SymbolId> worklist;
+    for (SymbolId id = 0; id < grammar.symbols.size(); ++id)
+    {
+        if (grammar.symbols.isNonterm(id) && !follow[id].none())
+        {
+            worklist.push_back(id);
+        }
+    }
+
+    propagate(follow, dependents, std::move(worklist));
+}
+
+bool GrammarAnalysis::isNullable(SymbolId symbol) const
+{
+    return nullable[symbol];
+}
+
+bool GrammarAnalysis::isNullable(Rhs rhs) const
+{
+    return std::all_of(rhs.begin(), rhs.end(), [this](auto &&x) { return nullable[x]; });
+}
+
+Bitset GrammarAnalysis::getFirst(SymbolId symbol) const
+{
+    if (grammar.symbols.isNonterm(symbol))
+    {
+        return first[symbol];
+    }
+
+    Bitset result(terminals.size() + 1);
+    result.set(terminalIndices[symbol]);
+    return result;
+}
+
+Bitset GrammarAnalysis::getFirst(Rhs rhs) const
+{
+    Bitset result(terminals.size() + 1);
+    for (auto &&symbol: rhs)
+    {
+        if (!grammar.symbols.isNonterm(symbol))
+        {
+            result.set(terminalIndices[symbol]);
+            break;
+        }
+
+        result.unite(first[symbol]);
+        if (!nullable[symbol])
+        {
+            break;
+        }
+    }
+    return result;
+}
+
+const Bitset &GrammarAnalysis::getFollow(SymbolId nonterm) const
+{
+    return follow[nonterm];
+}
+
+size_t GrammarAnalysis::getTerminalCount() const
+{
+    return terminals.size();
+}
+
+size_t GrammarAnalysis::getTerminalIndex(SymbolId terminal) const
+{
+    return terminalIndices[terminal];
+}
+
+SymbolId GrammarAnalysis::getTerminal(size_t index) const
+{
+    return terminals[index];
+}
+
+size_t GrammarAnalysis::getEndMarkerIndex() const
+{
+    return terminals.size();
+}
+
+std::vector<std::string> GrammarAnalysis::getNames(const Bitset &set) const
+{
+    std::vector<std::string> result;
+    set.forEach([&](size_t index) {
+        result.push_back(
+            index == getEndMarkerIndex() ? endMarker : grammar.symbols.getName(terminals[index]));
+    });
+    return result;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "bitset.h"
+#include "compactgrammar.h"
+
+inline const char *endMarker = "$";
+
+/*
+ * Nullable, FIRST and FOLLOW sets of a grammar. Terminals are numbered densely,
+ * every set is a Bitset over terminal indices plus one extra bit for the end marker.
+ * The grammar is referenced, not copied, and must outlive the analysis
+ */
+class GrammarAnalysis
+{
+public:
+    explicit GrammarAnalysis(const CompactGrammar &grammar);
+
+    bool isNullable(SymbolId symbol) const;
+    bool isNullable(Rhs rhs) const;
+
+    // FIRST of a nonterminal, or of a single terminal
+    Bitset getFirst(SymbolId symbol) const;
+    Bitset getFirst(Rhs rhs) const;
+    const Bitset &getFollow(SymbolId nonterm) const;
+
+    size_t getTerminalCount() const;
+    size_t getTerminalIndex(SymbolId terminal) const;
+    SymbolId getTerminal(size_t index) const;
+    size_t getEndMarkerIndex() const;
+
+    // terminal names of a set in index order, the end marker as "$"
+    std::vector<std::string> getNames(const Bitset &set) const;
+
+private:
+    void computeFirst();
+    void computeFollow();
+
+    // while any set grows, pushes it into the sets of its dependents
+    static void propagate(std::vector<Bitset> &sets,
+        std::vector<std::vector<SymbolId>> &dependents,
+        std::vector<SymbolId> worklist);
+
+private:
+    const CompactGrammar &grammar;
+
+    std::vector<SymbolId> terminals;
+    std::vector<size_t> terminalIndices;
+
+    std::vector<bool> nullable;
+    std::vector<Bitset> first;
+    std::vector<Bitset> follow;
+};
@@ -0,0 +1,143 @@
+#include "binaryio.h"
+
+#include <stdexcept>
+
+void BinaryWriter::writeVarint(std::uint64_t value)
+{
+    while (value >= 0x80)
+    {
+        data.push_back(static_cast<char>((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    data.push_back(static_cast<char>(value));
+}
+
+void BinaryWriter::writeString(std::string_view text)
+{
+    writeVarint(text.size());
+    data.append(text);
+}
+
+const std::string &BinaryWriter::getData() const
+{
+    return data;
+}
+
+BinaryReader::BinaryReader(std::string_view data) : data(data)
+{
+}
+
+std::uint64_t BinaryReader::readVarint()
+{
+    std::uint64_t value = 0;
+    for (unsigned shift = 0; shift < 64; shift += 7)
+    {
+        if (position == data.size())
+        {
+            throw std::runtime_error("BinaryReader: unexpected end of data");
+        }
+
+        auto byte = static_cast<unsigned char>(data[position++]);
+        value |= std::uint64_t(byte & 0x7f) << shift;
+        if (!(byte & 0x80))
+        {
+            return value;
+        }
+    }
+    throw std::runtime_error("BinaryReader: varint is too long");
+}
+
+std::string_view BinaryReader::readString()
+{
+    auto size = readCount();
+    auto text = data.substr(position, size);
+    position += size;
+    return text;
+}
+
+size_t BinaryReader::readCount()
+{
+    auto count = readVarint();
+    if (count > data.size() - position)
+    {
+        throw std::runtime_error("BinaryReader: count exceeds the data");
+    }
+    return static_cast<size_t>(count);
+}
+
+std::string_view BinaryReader::readRemaining()
+{
+    auto rest = data.substr(position);
+    position = data.size();
+    return rest;
+}
+
+bool BinaryReader::atEnd() const
+{
+    return position == data.size();
+}
+
+void writeGrammar(BinaryWriter &writer, const CompactGrammar &grammar)
+{
+    const auto &symbols = grammar.symbols;
+    writer.writeVarint(symbols.size());
+    for (SymbolId id = 0; id < symbols.size(); ++id)
+    {
+        writer.writeVarint(symbols.isNonterm(id));
+        writer.writeString(symbols.getName(id));
+    }
+    writer.writeIndex(grammar.start);
+
+    writer.writeVarint(grammar.productions.size());
+    for (auto &&production: grammar.productions)
+    {
+        writer.writeVarint(production.lhs);
+        writer.writeVarint(production.size);
+        for (auto &&symbol: grammar.getRhs(production))
+        {
+            writer.writeVarint(symbol);
+        }
+    }
+}
+
+CompactGrammar readGrammar(BinaryReader &reader)
+{
+    CompactGrammar grammar;
+    auto symbolCount = reader.readCount();
+    for (size_t i = 0; i < symbolCount; ++i)
+    {
+        bool nonterm = reader.readVarint() != 0;
+        if (grammar.symbols.intern(reader.readString(), nonterm) != i)
+        {
+            throw std::runtime_error("readGrammar: repeated symbol name");
+        }
+    }
+
+    auto symbol = [&] {
+        auto id = reader.readVarint();
+        if (id >= symbolCount)
+        {
+            throw std::runtime_error("readGrammar: symbol id out of range");
+        }
+        return static_cast<SymbolId>(id);
+    };
+
+    grammar.start = reader.readIndex<SymbolId>();
+    if (grammar.start != noSymbol && grammar.start >= symbolCount)
+    {
+        throw std::runtime_error("readGrammar: symbol id out of range");
+    }
+
+    std::vector<SymbolId> rhs;
+    for (auto count = reader.readCount(); count > 0; --count)
+    {
+        auto lhs = symbol();
+        rhs.resize(reader.readCount());
+        for (auto &&x: rhs)
+        {
+            x = symbol();
+        }
+        grammar.addProduction(lhs, rhs);
+    }
+    return grammar;
+}
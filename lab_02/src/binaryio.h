@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "compactgrammar.h"
+
+/*
+ * Compact binary encoding: integers are LEB128 varints, so symbol ids and
+ * production indices mostly take one or two bytes. Indices that may be "none"
+ * (all bits set) are stored plus one, none becomes 0
+ */
+class BinaryWriter
+{
+public:
+    void writeVarint(std::uint64_t value);
+    void writeString(std::string_view text);
+
+    template<typename T>
+    void writeIndex(T value)
+    {
+        writeVarint(static_cast<T>(value + 1));
+    }
+
+    template<typename T>
+    void writeIndices(const std::vector<T> &values)
+    {
+        writeVarint(values.size());
+        for (auto &&value: values)
+        {
+            writeIndex(value);
+        }
+    }
+
+    const std::string &getData() const;
+
+private:
+    std::string data;
+};
+
+// throws std::runtime_error on data that ends early or does not make sense
+class BinaryReader
+{
+public:
+    explicit BinaryReader(std::string_view data);
+
+    std::uint64_t readVarint();
+    std::string_view readString();
+
+    // a count of elements that take at least a byte each
+    size_t readCount();
+
+    // everything not read yet
+    std::string_view readRemaining();
+
+    template<typename T>
+    T readIndex()
+    {
+        return static_cast<T>(readVarint() - 1);
+    }
+
+    template<typename T>
+    std::vector<T> readIndices()
+    {
+        std::vector<T> values(readCount());
+        for (auto &&value: values)
+        {
+            value = readIndex<T>();
+        }
+        return values;
+    }
+
+    bool atEnd() const;
+
+private:
+    std::string_view data;
+    size_t position = 0;
+};
+
+// symbols in id order, so ids of the grammar read back are the same
+void writeGrammar(BinaryWriter &writer, const CompactGrammar &grammar);
+CompactGrammar readGrammar(BinaryReader &reader);
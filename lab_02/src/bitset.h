@@ -0,0 +1,121 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <vector>
+
+// fixed size set of small integers, one bit each
+class Bitset
+{
+public:
+    Bitset() = default;
+
+    explicit Bitset(size_t size) : words((size + 63) / 64, 0), bits(size) {}
+
+    bool test(size_t i) const
+    {
+        return words[i / 64] >> (i % 64) & 1;
+    }
+
+    void set(size_t i)
+    {
+        words[i / 64] |= std::uint64_t(1) << (i % 64);
+    }
+
+    void reset()
+    {
+        std::fill(std::begin(words), std::end(words), 0);
+    }
+
+    // true if any bit was added
+    bool unite(const Bitset &other)
+    {
+        std::uint64_t added = 0;
+        for (size_t i = 0; i < words.size(); ++i)
+        {
+            added |= other.words[i] & ~words[i];
+            words[i] |= other.words[i];
+        }
+        return added != 0;
+    }
+
+    bool intersects(const Bitset &other) const
+    {
+        for (size_t i = 0; i < words.size(); ++i)
+        {
+            if (words[i] & other.words[i])
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // intersection limited to the words holding bits [from, to)
+    bool intersects(const Bitset &other, size_t from, size_t to) const
+    {
+        for (size_t i = from / 64; i < (to + 63) / 64; ++i)
+        {
+            if (words[i] & other.words[i])
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool none() const
+    {
+        for (auto &&word: words)
+        {
+            if (word)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    size_t count() const
+    {
+        size_t result = 0;
+        for (auto &&word: words)
+        {
+            result += __builtin_popcountll(word);
+        }
+        return result;
+    }
+
+    size_t size() const
+    {
+        return bits;
+    }
+
+    // calls f with every set bit in increasing order
+    template<typename F>
+    void forEach(F &&f) const
+    {
+        for (size_t i = 0; i < words.size(); ++i)
+        {
+            for (auto word = words[i]; word; word &= word - 1)
+            {
+                f(i * 64 + __builtin_ctzll(word));
+            }
+        }
+    }
+
+    bool operator==(const Bitset &other) const
+    {
+        return bits == other.bits && words == other.words;
+    }
+
+    bool operator!=(const Bitset &other) const
+    {
+        return !(*this == other);
+    }
+
+private:
+    std::vector<std::uint64_t> words;
+    size_t bits = 0;
+};
@@ -0,0 +1,509 @@
+#include "bnf.h"
+
+#include <algorithm>
+#include <deque>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <vector>
+
+namespace
+{
+enum class Kind : std::uint8_t
+{
+    Name,
+    Nonterm,   // <name>
+    Terminal,  // "name"
+    Epsilon,
+    Arrow,
+    Bar,
+    Semicolon,
+    Open,
+    Close,
+    OptionOpen,
+    OptionClose,
+    RepeatOpen,
+    RepeatClose,
+    End,
+};
+
+struct Token
+{
+    Kind kind;
+    std::uint32_t offset;
+    SymbolId id = noSymbol;
+    std::string_view text;
+};
+
+bool isSpecial(char c)
+{
+    switch (c)
+    {
+        case '|':
+        case ';':
+        case '(':
+        case ')':
+        case '[':
+        case ']':
+        case '{':
+        case '}':
+        case '"':
+        case '<':
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool isSpace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' || c == '\v';
+}
+
+bool startsArrow(std::string_view text, size_t i)
+{
+    return text.compare(i, 2, "->") == 0 || text.compare(i, 3, "::=") == 0;
+}
+
+class BnfReader
+{
+public:
+    explicit BnfReader(std::string_view text) : text(text)
+    {
+    }
+
+    CompactGrammar read()
+    {
+        tokenize();
+        intern();
+
+        while (tokens[position].kind != Kind::End)
+        {
+            if (!isHead(position))
+            {
+                fail(tokens[position], "expected a rule");
+            }
+
+            auto lhs = tokens[position].id;
+            position += 2;
+            readAlternatives(lhs);
+
+            accept(Kind::Semicolon);
+        }
+        return std::move(grammar);
+    }
+
+private:
+    [[noreturn]] void fail(const Token &token, const std::string &message) const
+    {
+        auto line = 1 + std::count(text.data(), text.data() + token.offset, '\n');
+        throw std::invalid_argument(
+            "parseBnf: line " + std::to_string(line) + ": " + message);
+    }
+
+    void push(Kind kind, size_t offset, std::string_view name = {})
+    {
+        tokens.push_back({kind, static_cast<std::uint32_t>(offset), noSymbol, name});
+    }
+
+    // text up to the closing character, backslash escapes are copied out
+    size_t readQuoted(Kind kind, size_t begin, char closing)
+    {
+        auto i = begin + 1;
+        bool escaped = false;
+        for (; i < text.size() && text[i] != closing; ++i)
+        {
+            if (text[i] == '\\')
+            {
+                escaped = true;
+                ++i;
+            }
+        }
+        if (i >= text.size())
+        {
+            push(kind, begin);
+            fail(tokens.back(), std::string("missing ") + closing);
+        }
+
+        auto name = text.substr(begin + 1, i - begin - 1);
+        if (escaped)
+        {
+            auto &copy = unescaped.emplace_back();
+            for (size_t k = 0; k < name.size(); ++k)
+            {
+                k += name[k] == '\\';
+                copy.push_back(name[k]);
+            }
+            name = copy;
+        }
+        if (name.empty())
+        {
+            push(kind, begin);
+            fail(tokens.back(), "empty symbol name");
+        }
+
+        push(kind, begin, name);
+        return i + 1;
+    }
+
+    void tokenize()
+    {
+        tokens.reserve(text.size() / 4);
+
+        for (size_t i = 0; i < text.size();)
+        {
+            auto c = text[i];
+            if (isSpace(c))
+            {
+                ++i;
+            }
+            else if (c == '#')
+            {
+                i = std::min(text.find('\n', i), text.size());
+            }
+            else if (startsArrow(text, i))
+            {
+                push(Kind::Arrow, i);
+                i += text[i] == '-' ? 2 : 3;
+            }
+            else if (c == '"')
+            {
+                i = readQuoted(Kind::Terminal, i, '"');
+            }
+            else if (c == '<')
+            {
+                i = readQuoted(Kind::Nonterm, i, '>');
+            }
+            else if (isSpecial(c))
+            {
+                static constexpr std::string_view specials = "|;()[]{}";
+                static constexpr Kind kinds[] = {Kind::Bar, Kind::Semicolon, Kind::Open,
+                    Kind::Close, Kind::OptionOpen, Kind::OptionClose, Kind::RepeatOpen,
+                    Kind::RepeatClose};
+                push(kinds[specials.find(c)], i);
+                ++i;
+            }
+            else
+            {
+                auto begin = i;
+                while (i < text.size() && !isSpace(text[i]) && !isSpecial(text[i]) &&
+                    !startsArrow(text, i))
+                {
+                    ++i;
+                }
+
+                auto name = text.substr(begin, i - begin);
+                push(name == epsilonName ? Kind::Epsilon : Kind::Name, begin, name);
+            }
+        }
+        push(Kind::End, text.size());
+    }
+
+    bool accept(Kind kind)
+    {
+        if (tokens[position].kind != kind)
+        {
+            return false;
+        }
+        ++position;
+        return true;
+    }
+
+    bool isHead(size_t i) const
+    {
+        return (tokens[i].kind == Kind::Name || tokens[i].kind == Kind::Nonterm) &&
+            tokens[i + 1].kind == Kind::Arrow;
+    }
+
+    // left sides and <names> first so bare names resolve without a second look at the text
+    void intern()
+    {
+        for (size_t i = 0; i + 1 < tokens.size(); ++i)
+        {
+            if (isHead(i) || tokens[i].kind == Kind::Nonterm)
+            {
+                tokens[i].id = grammar.symbols.intern(tokens[i].text, true);
+                if (grammar.start == noSymbol)
+                {
+                    grammar.start = tokens[i].id;
+                }
+            }
+            else if (tokens[i].kind == Kind::Arrow && (i == 0 || !isHead(i - 1)))
+            {
+                fail(tokens[i], "expected a left side before the arrow");
+            }
+        }
+
+        for (auto &&token: tokens)
+        {
+            if (token.kind == Kind::Name)
+            {
+                token.id = grammar.symbols.intern(token.text, false);
+            }
+            else if (token.kind == Kind::Terminal)
+            {
+                token.id = grammar.symbols.intern(token.text, false);
+                if (grammar.symbols.isNonterm(token.id))
+                {
+                    fail(token, "terminal \"" + std::string(token.text) + "\" has a rule");
+                }
+            }
+        }
+    }
+
+    // symbols of the alternatives are stacked above the enclosing sequence
+    void readAlternatives(SymbolId lhs)
+    {
+        do
+        {
+            auto mark = stack.size();
+            readSequence(lhs);
+            grammar.addProduction(lhs, stack.data() + mark, stack.data() + stack.size());
+            stack.resize(mark);
+        } while (accept(Kind::Bar));
+    }
+
+    void readSequence(SymbolId lhs)
+    {
+        for (;;)
+        {
+            const auto &token = tokens[position];
+            switch (token.kind)
+            {
+                case Kind::Name:
+                case Kind::Nonterm:
+                    if (isHead(position))
+                    {
+                        return;
+                    }
+                    [[fallthrough]];
+                case Kind::Terminal:
+                    stack.push_back(token.id);
+                    ++position;
+                    break;
+                case Kind::Epsilon:
+                    ++position;
+                    break;
+                case Kind::Open:
+                case Kind::OptionOpen:
+                case Kind::RepeatOpen:
+                    stack.push_back(readGroup(lhs));
+                    break;
+                default:
+                    return;
+            }
+        }
+    }
+
+    // ( a ) is H -> a, [ a ] is H -> a | ? and { a } is H -> a H | ?
+    SymbolId readGroup(SymbolId lhs)
+    {
+        const auto &open = tokens[position++];
+        auto kind = open.kind;
+        auto closing = kind == Kind::Open ? Kind::Close
+            : kind == Kind::OptionOpen    ? Kind::OptionClose
+                                          : Kind::RepeatClose;
+        auto helper = grammar.symbols.fresh(lhs);
+
+        do
+        {
+            auto mark = stack.size();
+            readSequence(lhs);
+            if (kind == Kind::RepeatOpen)
+            {
+                stack.push_back(helper);
+            }
+            grammar.addProduction(helper, stack.data() + mark, stack.data() + stack.size());
+            stack.resize(mark);
+        } while (accept(Kind::Bar));
+
+        if (!accept(closing))
+        {
+            fail(open, "unbalanced bracket");
+        }
+
+        if (kind != Kind::Open)
+        {
+            grammar.addProduction(helper, stack.data(), stack.data());
+        }
+        return helper;
+    }
+
+private:
+    static constexpr std::string_view epsilonName = "?";
+
+    std::string_view text;
+    std::vector<Token> tokens;
+    std::deque<std::string> unescaped;
+    size_t position = 0;
+
+    std::vector<SymbolId> stack;
+    CompactGrammar grammar;
+};
+
+/* appends to a fixed size buffer and writes it out whole */
+class BufferedWriter
+{
+public:
+    explicit BufferedWriter(std::ostream &out) : out(out)
+    {
+        buffer.reserve(capacity);
+    }
+
+    ~BufferedWriter()
+    {
+        flush();
+    }
+
+    void write(std::string_view text)
+    {
+        if (buffer.size() + text.size() > capacity)
+        {
+            flush();
+        }
+        buffer.append(text);
+    }
+
+    void flush()
+    {
+        out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        buffer.clear();
+    }
+
+private:
+    static constexpr size_t capacity = 1 << 16;
+
+    std::ostream &out;
+    std::string buffer;
+};
+
+bool isPlain(std::string_view name)
+{
+    if (name.empty() || name == "?" || name.front() == '#')
+    {
+        return false;
+    }
+    for (size_t i = 0; i < name.size(); ++i)
+    {
+        if (isSpace(name[i]) || isSpecial(name[i]) || startsArrow(name, i))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void writeQuoted(BufferedWriter &writer, std::string_view name, char open, char closing)
+{
+    std::string quoted(1, open);
+    for (auto &&c: name)
+    {
+        if (c == closing || c == '\\')
+        {
+            quoted.push_back('\\');
+        }
+        quoted.push_back(c);
+    }
+    quoted.push_back(closing);
+    writer.write(quoted);
+}
+}  // namespace
+
+CompactGrammar parseBnf(std::string_view text)
+{
+    return BnfReader(text).read();
+}
+
+CompactGrammar loadBnf(const std::string &path)
+{
+    std::ifstream in(path, std::ios::binary);
+    if (!in)
+    {
+        throw std::runtime_error("loadBnf: cannot open " + path);
+    }
+
+    std::string text;
+    in.seekg(0, std::ios::end);
+    text.resize(static_cast<size_t>(in.tellg()));
+    in.seekg(0, std::ios::beg);
+    in.read(text.data(), static_cast<std::streamsize>(text.size()));
+    if (!in)
+    {
+        throw std::runtime_error("loadBnf: cannot read " + path);
+    }
+    return parseBnf(text);
+}
+
+void writeBnf(std::ostream &out, const CompactGrammar &grammar)
+{
+    auto byLhs = grammar.groupByLhs();
+    BufferedWriter writer(out);
+
+    // a nonterminal without rules would read back as a terminal unless it is bracketed
+    auto writeSymbol = [&](SymbolId id) {
+        const auto &name = grammar.symbols.getName(id);
+        if (isPlain(name) && (!grammar.symbols.isNonterm(id) || !byLhs[id].empty()))
+        {
+            writer.write(name);
+        }
+        else if (grammar.symbols.isNonterm(id))
+        {
+            writeQuoted(writer, name, '<', '>');
+        }
+        else
+        {
+            writeQuoted(writer, name, '"', '"');
+        }
+    };
+
+    auto writeRules = [&](SymbolId lhs) {
+        if (byLhs[lhs].empty())
+        {
+            return;
+        }
+
+        writeSymbol(lhs);
+        writer.write(" ->");
+        for (size_t i = 0; i < byLhs[lhs].size(); ++i)
+        {
+            writer.write(i == 0 ? " " : " | ");
+
+            auto rhs = grammar.getRhs(grammar.productions[byLhs[lhs][i]]);
+            if (rhs.empty())
+            {
+                writer.write("?");
+            }
+            for (size_t k = 0; k < rhs.size(); ++k)
+            {
+                if (k > 0)
+                {
+                    writer.write(" ");
+                }
+                writeSymbol(rhs[k]);
+            }
+        }
+        writer.write("\n");
+    };
+
+    if (grammar.start != noSymbol)
+    {
+        writeRules(grammar.start);
+    }
+    for (SymbolId id = 0; id < grammar.symbols.size(); ++id)
+    {
+        if (id != grammar.start)
+        {
+            writeRules(id);
+        }
+    }
+}
+
+void saveBnf(const std::string &path, const CompactGrammar &grammar)
+{
+    std::ofstream out(path, std::ios::binary);
+    if (!out)
+    {
+        throw std::runtime_error("saveBnf: cannot open " + path);
+    }
+    writeBnf(out, grammar);
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <ostream>
+#include <string>
+#include <string_view>
+
+#include "compactgrammar.h"
+
+/*
+ * Grammar text format, one rule per left side or several:
+ *
+ *     # comment up to the end of the line
+ *     S -> a X b X | a Z ;
+ *     <X> ::= "a" Y | [ b ] { c } | ?
+ *
+ * Symbols are separated by spaces. A bare name is a nonterminal if it has a rule,
+ * <name> always is one and "name" is always a terminal ('\' escapes inside quotes).
+ * ? or an empty alternative is epsilon, ';' after a rule is optional and the first
+ * left side is the start symbol. EBNF groups ( ), options [ ] and repetitions { }
+ * become helper nonterminals named after the left side
+ */
+
+// throws std::invalid_argument with the line of the first syntax error
+CompactGrammar parseBnf(std::string_view text);
+
+// throws std::runtime_error if the file cannot be read
+CompactGrammar loadBnf(const std::string &path);
+
+// rules of the start symbol first, the output reads back into an equal grammar
+void writeBnf(std::ostream &out, const CompactGrammar &grammar);
+void saveBnf(const std::string &path, const CompactGrammar &grammar);
@@ -0,0 +1,231 @@
+#include "cache.h"
+
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+
+#include "binaryio.h"
+
+namespace
+{
+// FNV-1a
+class Hasher
+{
+public:
+    void add(std::string_view bytes)
+    {
+        for (auto &&c: bytes)
+        {
+            hash = (hash ^ static_cast<unsigned char>(c)) * 0x100000001b3;
+        }
+    }
+
+    // little endian whatever the machine is
+    void add(std::uint64_t value)
+    {
+        for (int i = 0; i < 8; ++i)
+        {
+            hash = (hash ^ (value >> 8 * i & 0xff)) * 0x100000001b3;
+        }
+    }
+
+    std::uint64_t get() const
+    {
+        return hash;
+    }
+
+private:
+    std::uint64_t hash = 0xcbf29ce484222325;
+};
+
+constexpr std::string_view magic = "lab02gc";
+
+// "lab02gc", version, key, payload size and payload hash, then the payload
+std::string makeFile(std::uint64_t key, const std::string &payload)
+{
+    BinaryWriter header;
+    header.writeString(magic);
+    header.writeVarint(GrammarCache::version);
+    header.writeVarint(key);
+    header.writeVarint(payload.size());
+
+    Hasher hasher;
+    hasher.add(payload);
+    header.writeVarint(hasher.get());
+    return header.getData() + payload;
+}
+
+// the payload, or an empty view if data is not a current file for key
+std::string_view checkFile(std::uint64_t key, std::string_view data)
+{
+    try
+    {
+        BinaryReader reader(data);
+        if (reader.readString() != magic || reader.readVarint() != GrammarCache::version ||
+            reader.readVarint() != key)
+        {
+            return {};
+        }
+
+        auto size = reader.readVarint();
+        auto hash = reader.readVarint();
+        auto payload = reader.readRemaining();
+
+        Hasher hasher;
+        hasher.add(payload);
+        return payload.size() == size && hasher.get() == hash ? payload : std::string_view();
+    }
+    catch (const std::runtime_error &)
+    {
+        return {};
+    }
+}
+}  // namespace
+
+std::uint64_t hashGrammar(const CompactGrammar &grammar)
+{
+    Hasher hasher;
+    const auto &symbols = grammar.symbols;
+    hasher.add(symbols.size());
+    for (SymbolId id = 0; id < symbols.size(); ++id)
+    {
+        // every name is length prefixed, so the concatenation is unambiguous
+        hasher.add(symbols.isNonterm(id));
+        hasher.add(symbols.getName(id).size());
+        hasher.add(symbols.getName(id));
+    }
+    hasher.add(grammar.start == noSymbol ? 0 : std::uint64_t(grammar.start) + 1);
+
+    hasher.add(grammar.productions.size());
+    for (auto &&production: grammar.productions)
+    {
+        auto rhs = grammar.getRhs(production);
+        hasher.add(production.lhs);
+        hasher.add(rhs.size());
+        for (auto &&symbol: rhs)
+        {
+            hasher.add(symbol);
+        }
+    }
+    return hasher.get();
+}
+
+std::uint64_t hashGrammar(const Grammar &grammar, std::string_view start)
+{
+    return hashGrammar(toCompact(grammar, start));
+}
+
+GrammarCache::GrammarCache(std::string directory) : directory(std::move(directory))
+{
+    std::error_code error;
+    std::filesystem::create_directories(this->directory, error);
+    if (error)
+    {
+        throw std::runtime_error(
+            "GrammarCache: cannot create " + this->directory + ": " + error.message());
+    }
+}
+
+CompactGrammar GrammarCache::transform(
+    const CompactGrammar &grammar, std::string_view name, const Pipeline &pipeline)
+{
+    return lookup<CompactGrammar>(
+        hashGrammar(grammar), name, readGrammar, writeGrammar, [&] { return pipeline(grammar); });
+}
+
+Ll1Table GrammarCache::getLl1Table(const Grammar &grammar, std::string_view start)
+{
+    return lookup<Ll1Table>(
+        hashGrammar(grammar, start), "ll1", Ll1Table::read,
+        [](BinaryWriter &writer, const Ll1Table &table) { table.write(writer); },
+        [&] { return makeLl1Table(grammar, start); });
+}
+
+LalrTable GrammarCache::getLalrTable(const Grammar &grammar, std::string_view start, size_t threads)
+{
+    return lookup<LalrTable>(
+        hashGrammar(grammar, start), "lalr", LalrTable::read,
+        [](BinaryWriter &writer, const LalrTable &table) { table.write(writer); },
+        [&] { return makeLalrTable(grammar, start, threads); });
+}
+
+size_t GrammarCache::getHits() const
+{
+    return hits;
+}
+
+size_t GrammarCache::getMisses() const
+{
+    return misses;
+}
+
+template<typename T, typename Read, typename Write, typename Make>
+T GrammarCache::lookup(
+    std::uint64_t grammarHash, std::string_view name, Read &&read, Write &&write, Make &&make)
+{
+    Hasher hasher;
+    hasher.add(grammarHash);
+    hasher.add(name.size());
+    hasher.add(name);
+    auto key = hasher.get();
+
+    std::ostringstream fileName;
+    fileName << std::hex << key << ".bin";
+    auto path = std::filesystem::path(directory) / fileName.str();
+
+    std::string data;
+    if (std::ifstream in(path, std::ios::binary); in)
+    {
+        data.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+
+    if (auto payload = checkFile(key, data); !payload.empty())
+    {
+        try
+        {
+            BinaryReader reader(payload);
+            auto result = read(reader);
+            if (reader.atEnd())
+            {
+                ++hits;
+                return result;
+            }
+        }
+        catch (const std::runtime_error &)
+        {
+        }
+    }
+
+    ++misses;
+    auto result = make();
+
+    BinaryWriter writer;
+    write(writer, result);
+
+    // a cache that cannot be written only costs time, the result is still good
+    auto temporary = path;
+    temporary += "." + std::to_string(std::random_device()()) + ".tmp";
+    {
+        std::ofstream out(temporary, std::ios::binary);
+        auto file = makeFile(key, writer.getData());
+        out.write(file.data(), static_cast<std::streamsize>(file.size()));
+        if (!out)
+        {
+            out.close();
+            std::error_code error;
+            std::filesystem::remove(temporary, error);
+            return result;
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(temporary, path, error);
+    if (error)
+    {
+        std::filesystem::remove(temporary, error);
+    }
+    return result;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+
+#include "compactgrammar.h"
+#include "lalr.h"
+#include "ll1.h"
+#include "utils.h"
+
+/*
+ * Hash of a grammar exactly as the passes see it: symbols in id order, the start and
+ * the productions in order. Names of fresh nonterminals and the order of the output
+ * depend on all of these, so a cached result is the one the pipeline would return
+ */
+std::uint64_t hashGrammar(const CompactGrammar &grammar);
+std::uint64_t hashGrammar(const Grammar &grammar, std::string_view start = "S");
+
+/*
+ * Results of grammar pipelines kept on disk, one file per result named by the hash
+ * of the input grammar and the pipeline. Files hold the format of binaryio.h behind
+ * a header with a checksum; a missing, damaged or older file is a miss and is
+ * replaced. Files are written under a temporary name and renamed, so concurrent
+ * builds sharing a directory never read a half written file
+ */
+class GrammarCache
+{
+public:
+    using Pipeline = std::function<CompactGrammar(const CompactGrammar &)>;
+
+    // creates the directory, throws std::runtime_error if that fails
+    explicit GrammarCache(std::string directory);
+
+    // pipeline applied to grammar; name identifies the pipeline, so different
+    // passes must never share one
+    CompactGrammar transform(
+        const CompactGrammar &grammar, std::string_view name, const Pipeline &pipeline);
+
+    // makeLl1Table and makeLalrTable, threads do not change the table
+    Ll1Table getLl1Table(const Grammar &grammar, std::string_view start = "S");
+    LalrTable getLalrTable(const Grammar &grammar, std::string_view start = "S",
+        size_t threads = 1);
+
+    size_t getHits() const;
+    size_t getMisses() const;
+
+    // bumped whenever a pass or the file format changes, so old files are misses
+    static constexpr std::uint32_t version = 2;
+
+private:
+    template<typename T, typename Read, typename Write, typename Make>
+    T lookup(std::uint64_t grammarHash, std::string_view name, Read &&read, Write &&write,
+        Make &&make);
+
+private:
+    std::string directory;
+    size_t hits = 0;
+    size_t misses = 0;
+};
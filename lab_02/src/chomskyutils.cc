@@ -1,44 +1,197 @@
 #include "chomskyutils.h"
 
-constexpr size_t longRuleSize = 2;
+#include <algorithm>
+
+#include "bitset.h"
+#include "grammarshard.h"
+
+
+static constexpr std::uint32_t noIndex = static_cast<std::uint32_t>(-1);
 
 Grammar deleteLongRules(const Grammar &grammar)
 {
-    Grammar newGrammar;
-    for (auto &&[nonterm, rules]: grammar)
+    return toGrammar(deleteLongRules(toCompactWithoutStart(grammar)));
+}
+
+Grammar deleteChainRules(const Grammar &grammar)
+{
+    return toGrammar(deleteChainRules(toCompactWithoutStart(grammar)));
+}
+
+Grammar toChomskyNormalForm(const Grammar &grammar, std::string_view start)
+{
+    return toGrammar(toChomskyNormalForm(toCompact(grammar, start)));
+}
+
+CompactGrammar deleteLongRules(const CompactGrammar &input, size_t threads)
+{
+    auto grammar = removeUselessSymbols(input);
+    auto newGrammar = makeEmptyCopy(grammar);
+
+    runSharded(newGrammar, grammar.productions.size(), threads,
+        [&](GrammarShard &shard, size_t begin, size_t end) {
+            for (auto p = begin; p < end; ++p)
+            {
+                const auto &production = grammar.productions[p];
+                auto rule = grammar.getRhs(production);
+                auto currentNonterm = production.lhs;
+                size_t i = 0;
+
+                for (; rule.size() > longRuleSize && i < rule.size() - longRuleSize; ++i)
+                {
+                    auto nextNonterm = shard.fresh(currentNonterm);
+                    shard.addProduction(
+                        currentNonterm, std::vector<SymbolId>{rule[i], nextNonterm});
+                    currentNonterm = nextNonterm;
+                }
+
+                shard.addProduction(currentNonterm, rule.begin() + i, rule.end());
+            }
+        });
+
+    newGrammar.normalize();
+    return newGrammar;
+}
+
+CompactGrammar deleteChainRules(const CompactGrammar &grammar)
+{
+    const auto &symbols = grammar.symbols;
+    auto isUnit = [&](Rhs rule) { return rule.size() == 1 && symbols.isNonterm(rule[0]); };
+
+    // only nonterminals on either side of a unit rule get a row in the matrix
+    std::vector<std::uint32_t> indices(symbols.size(), noIndex);
+    std::vector<SymbolId> nonterms;
+    auto index = [&](SymbolId nonterm) {
+        if (indices[nonterm] == noIndex)
+        {
+            indices[nonterm] = static_cast<std::uint32_t>(nonterms.size());
+            nonterms.push_back(nonterm);
+        }
+        return indices[nonterm];
+    };
+
+    std::vector<std::pair<std::uint32_t, std::uint32_t>> units;
+    for (auto &&production: grammar.productions)
     {
-        for (auto &&rule: rules)
+        if (auto rule = grammar.getRhs(production); isUnit(rule))
         {
-            auto currentNonterm = nonterm;
-            int i = 0;
+            units.emplace_back(index(production.lhs), index(rule[0]));
+        }
+    }
 
-            for (; i < static_cast<int>(rule.size()) - 2; ++i)
+    // reflexive unit pairs closed by Warshall, a row at a time over 64-bit words
+    std::vector<Bitset> derives(nonterms.size(), Bitset(nonterms.size()));
+    for (std::uint32_t i = 0; i < nonterms.size(); ++i)
+    {
+        derives[i].set(i);
+    }
+    for (auto &&[from, to]: units)
+    {
+        derives[from].set(to);
+    }
+    for (size_t k = 0; k < nonterms.size(); ++k)
+    {
+        for (size_t i = 0; i < nonterms.size(); ++i)
+        {
+            if (i != k && derives[i].test(k))
             {
-                auto nextNonterm = generateNewNonterm(grammar, currentNonterm);
-                newGrammar[currentNonterm].insert(rule[i] + nextNonterm);
-                currentNonterm = nextNonterm;
+                derives[i].unite(derives[k]);
             }
+        }
+    }
 
-            newGrammar[currentNonterm].insert(rule.substr(i));
+    auto newGrammar = makeEmptyCopy(grammar);
+    auto byLhs = grammar.groupByLhs();
+    for (auto &&production: grammar.productions)
+    {
+        if (auto rule = grammar.getRhs(production); !isUnit(rule))
+        {
+            newGrammar.addProduction(production.lhs, rule.begin(), rule.end());
         }
     }
+
+    // every nonterminal lends its other rules to all that reach it through unit rules
+    for (std::uint32_t i = 0; i < nonterms.size(); ++i)
+    {
+        derives[i].forEach([&](size_t j) {
+            if (j == i)
+            {
+                return;
+            }
+
+            for (auto &&p: byLhs[nonterms[j]])
+            {
+                if (auto rule = grammar.getRhs(grammar.productions[p]); !isUnit(rule))
+                {
+                    newGrammar.addProduction(nonterms[i], rule.begin(), rule.end());
+                }
+            }
+        });
+    }
+
+    newGrammar.normalize();
     return newGrammar;
 }
 
-Grammar deleteChainRules(const Grammar &grammar)
+static CompactGrammar replaceStart(const CompactGrammar &grammar)
 {
+    bool onRightSide = std::any_of(std::begin(grammar.arena), std::end(grammar.arena),
+        [&](auto &&symbol) { return symbol == grammar.start; });
+    if (!onRightSide)
+    {
+        return grammar;
+    }
+
     auto newGrammar = grammar;
-    for (auto &&[nonterm, rules]: grammar)
+    newGrammar.start = newGrammar.symbols.fresh(grammar.start);
+    newGrammar.addProduction(newGrammar.start, std::vector<SymbolId>{grammar.start});
+    return newGrammar;
+}
+
+static CompactGrammar replaceTerms(const CompactGrammar &grammar)
+{
+    auto newGrammar = makeEmptyCopy(grammar);
+    std::vector<SymbolId> replacements(grammar.symbols.size(), noSymbol);
+
+    std::vector<SymbolId> rhs;
+    for (auto &&production: grammar.productions)
     {
-        for (auto &&rule: rules)
+        auto rule = grammar.getRhs(production);
+        rhs.assign(rule.begin(), rule.end());
+
+        for (auto &&symbol: rhs)
         {
-            if (grammar.find(rule) != std::end(grammar))
+            if (rhs.size() < 2 || grammar.symbols.isNonterm(symbol))
             {
-                auto &&tmp = grammar.at(rule);
-                newGrammar[nonterm].erase(rule);
-                newGrammar[nonterm].insert(std::begin(tmp), std::end(tmp));
+                continue;
             }
+
+            if (replacements[symbol] == noSymbol)
+            {
+                replacements[symbol] = newGrammar.symbols.fresh(symbol);
+                newGrammar.addProduction(replacements[symbol], std::vector<SymbolId>{symbol});
+            }
+            symbol = replacements[symbol];
         }
+
+        newGrammar.addProduction(production.lhs, rhs);
     }
     return newGrammar;
 }
+
+CompactGrammar toChomskyNormalForm(const CompactGrammar &grammar)
+{
+    auto newGrammar = deleteLongRules(replaceTerms(replaceStart(grammar)));
+
+    bool startNullable =
+        newGrammar.start != noSymbol && findEpsilonNonterms(newGrammar)[newGrammar.start];
+
+    newGrammar = deleteChainRules(removeEpsilonNonterms(newGrammar));
+    if (startNullable)
+    {
+        newGrammar.addProduction(newGrammar.start, std::vector<SymbolId>{});
+    }
+
+    newGrammar.normalize();
+    return newGrammar;
+}
@@ -4,3 +4,19 @@
 
 Grammar deleteLongRules(const Grammar &grammar);
 Grammar deleteChainRules(const Grammar &grammar);
+// the normal form depends on the start, throws std::invalid_argument if there is none
+Grammar toChomskyNormalForm(const Grammar &grammar, std::string_view start = "S");
+
+// right sides deleteLongRules leaves are at most this long
+inline constexpr size_t longRuleSize = 2;
+
+// threads only change the speed, names of new nonterminals do not depend on them
+CompactGrammar deleteLongRules(const CompactGrammar &grammar, size_t threads = 1);
+CompactGrammar deleteChainRules(const CompactGrammar &grammar);
+
+/*
+ * Rules A -> BC, A -> a and S -> ? only, S never on a right side:
+ * new start, terminals moved out of long rules, deleteLongRules,
+ * epsilon rules removed and unit rules replaced by what they derive
+ */
+CompactGrammar toChomskyNormalForm(const CompactGrammar &grammar);
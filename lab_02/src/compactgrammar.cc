@@ -0,0 +1,267 @@
+#include "compactgrammar.h"
+
+#include <algorithm>
+#include <functional>
+#include <set>
+#include <stdexcept>
+
+#include "utils.h"
+
+SymbolTable::SymbolTable(const SymbolTable &other)
+    : names(other.names), nonterms(other.nonterms), primes(other.primes)
+{
+    for (SymbolId id = 0; id < names.size(); ++id)
+    {
+        ids.emplace(names[id], id);
+    }
+}
+
+SymbolTable &SymbolTable::operator=(const SymbolTable &other)
+{
+    if (this != &other)
+    {
+        *this = SymbolTable(other);
+    }
+    return *this;
+}
+
+SymbolId SymbolTable::intern(std::string_view name, bool nonterm)
+{
+    if (auto it = ids.find(name); it != std::end(ids))
+    {
+        return it->second;
+    }
+
+    auto id = static_cast<SymbolId>(names.size());
+    names.emplace_back(name);
+    nonterms.push_back(nonterm);
+    ids.emplace(names.back(), id);
+    return id;
+}
+
+SymbolId SymbolTable::find(std::string_view name) const
+{
+    auto it = ids.find(name);
+    return it == std::end(ids) ? noSymbol : it->second;
+}
+
+SymbolId SymbolTable::fresh(SymbolId base)
+{
+    if (primes.size() <= base)
+    {
+        primes.resize(names.size(), 0);
+    }
+
+    auto count = primes[base];
+    auto name = names[base] + std::string(count, '\'');
+    do
+    {
+        name += "'";
+        ++count;
+    } while (ids.find(name) != std::end(ids));
+
+    primes[base] = count;
+    return intern(name, true);
+}
+
+const std::string &SymbolTable::getName(SymbolId id) const
+{
+    return names[id];
+}
+
+bool SymbolTable::isNonterm(SymbolId id) const
+{
+    return nonterms[id];
+}
+
+size_t SymbolTable::size() const
+{
+    return names.size();
+}
+
+void CompactGrammar::addProduction(SymbolId lhs, const SymbolId *first, const SymbolId *last)
+{
+    auto begin = static_cast<std::uint32_t>(arena.size());
+    arena.insert(std::end(arena), first, last);
+    productions.push_back({lhs, begin, static_cast<std::uint32_t>(last - first)});
+}
+
+Rhs CompactGrammar::getRhs(const Production &production) const
+{
+    const auto *first = arena.data() + production.begin;
+    return {first, first + production.size};
+}
+
+std::vector<std::vector<std::uint32_t>> CompactGrammar::groupByLhs() const
+{
+    std::vector<std::vector<std::uint32_t>> result(symbols.size());
+    for (std::uint32_t i = 0; i < productions.size(); ++i)
+    {
+        result[productions[i].lhs].push_back(i);
+    }
+    return result;
+}
+
+void CompactGrammar::normalize()
+{
+    auto less = [this](auto &&a, auto &&b) {
+        if (a.lhs != b.lhs)
+        {
+            return a.lhs < b.lhs;
+        }
+        auto x = getRhs(a);
+        auto y = getRhs(b);
+        return std::lexicographical_compare(x.begin(), x.end(), y.begin(), y.end());
+    };
+    auto equal = [this](auto &&a, auto &&b) {
+        auto x = getRhs(a);
+        auto y = getRhs(b);
+        return a.lhs == b.lhs && std::equal(x.begin(), x.end(), y.begin(), y.end());
+    };
+
+    std::sort(std::begin(productions), std::end(productions), less);
+    productions.erase(
+        std::unique(std::begin(productions), std::end(productions), equal), std::end(productions));
+
+    std::vector<SymbolId> newArena;
+    newArena.reserve(arena.size());
+    for (auto &&production: productions)
+    {
+        auto rhs = getRhs(production);
+        production.begin = static_cast<std::uint32_t>(newArena.size());
+        newArena.insert(std::end(newArena), rhs.begin(), rhs.end());
+    }
+    std::swap(arena, newArena);
+}
+
+void CompactGrammar::retain(const std::vector<bool> &keep)
+{
+    std::vector<SymbolId> newArena;
+    newArena.reserve(arena.size());
+
+    size_t kept = 0;
+    for (size_t i = 0; i < productions.size(); ++i)
+    {
+        if (keep[i])
+        {
+            auto production = productions[i];
+            auto rhs = getRhs(production);
+            production.begin = static_cast<std::uint32_t>(newArena.size());
+            newArena.insert(std::end(newArena), rhs.begin(), rhs.end());
+            productions[kept++] = production;
+        }
+    }
+
+    productions.resize(kept);
+    std::swap(arena, newArena);
+}
+
+CompactGrammar makeEmptyCopy(const CompactGrammar &grammar)
+{
+    CompactGrammar result;
+    result.symbols = grammar.symbols;
+    result.start = grammar.start;
+    return result;
+}
+
+std::string toString(const CompactGrammar &grammar, Rhs rhs)
+{
+    std::string result;
+    for (auto &&symbol: rhs)
+    {
+        result += grammar.symbols.getName(symbol);
+    }
+    return result;
+}
+
+std::vector<SymbolId> tokenize(const CompactGrammar &grammar, std::string_view input)
+{
+    std::vector<SymbolId> result;
+    result.reserve(input.size());
+    for (size_t i = 0; i < input.size(); ++i)
+    {
+        auto id = grammar.symbols.find(input.substr(i, 1));
+        result.push_back(id != noSymbol && !grammar.symbols.isNonterm(id) ? id : noSymbol);
+    }
+    return result;
+}
+
+CompactGrammar toCompact(const Grammar &grammar, std::string_view start)
+{
+    auto result = toCompactWithoutStart(grammar);
+    if (grammar.empty())
+    {
+        return result;
+    }
+
+    result.start = result.symbols.find(start);
+    if (result.start == noSymbol || !result.symbols.isNonterm(result.start))
+    {
+        throw std::invalid_argument("toCompact: no nonterminal " + std::string(start));
+    }
+    return result;
+}
+
+CompactGrammar toCompactWithoutStart(const Grammar &grammar)
+{
+    CompactGrammar result;
+
+    std::set<size_t, std::greater<>> lengths;
+    for (auto &&[nonterm, _]: grammar)
+    {
+        result.symbols.intern(nonterm, true);
+        lengths.insert(nonterm.size());
+    }
+
+    std::vector<SymbolId> rhs;
+    for (auto &&[nonterm, rules]: grammar)
+    {
+        auto lhs = result.symbols.find(nonterm);
+        for (std::string_view rule: rules)
+        {
+            rhs.clear();
+
+            // the longest nonterminal name wins, anything else is a one-char terminal
+            for (size_t pos = 0; rule != epsilon && pos < rule.size();)
+            {
+                auto id = noSymbol;
+                for (auto &&length: lengths)
+                {
+                    if (pos + length <= rule.size())
+                    {
+                        id = result.symbols.find(rule.substr(pos, length));
+                        if (id != noSymbol && result.symbols.isNonterm(id))
+                        {
+                            pos += length;
+                            break;
+                        }
+                        id = noSymbol;
+                    }
+                }
+
+                if (id == noSymbol)
+                {
+                    id = result.symbols.intern(rule.substr(pos, 1), false);
+                    ++pos;
+                }
+                rhs.push_back(id);
+            }
+
+            result.addProduction(lhs, rhs);
+        }
+    }
+
+    return result;
+}
+
+Grammar toGrammar(const CompactGrammar &grammar)
+{
+    Grammar result;
+    for (auto &&production: grammar.productions)
+    {
+        auto rhs = grammar.getRhs(production);
+        result[grammar.symbols.getName(production.lhs)].insert(
+            rhs.empty() ? epsilon : toString(grammar, rhs));
+    }
+    return result;
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+using SymbolId = std::uint32_t;
+
+inline constexpr SymbolId noSymbol = static_cast<SymbolId>(-1);
+
+// interned grammar symbols, names never move so lookups go by string_view
+class SymbolTable
+{
+public:
+    SymbolTable() = default;
+    SymbolTable(const SymbolTable &other);
+    SymbolTable(SymbolTable &&other) = default;
+    SymbolTable &operator=(const SymbolTable &other);
+    SymbolTable &operator=(SymbolTable &&other) = default;
+
+    SymbolId intern(std::string_view name, bool nonterm);
+    SymbolId find(std::string_view name) const;
+
+    // new nonterminal named after base with enough "'" appended to be unique,
+    // counting on from the last name made for base since names are never removed
+    SymbolId fresh(SymbolId base);
+
+    const std::string &getName(SymbolId id) const;
+    bool isNonterm(SymbolId id) const;
+    size_t size() const;
+
+private:
+    std::deque<std::string> names;
+    std::vector<bool> nonterms;
+    std::unordered_map<std::string_view, SymbolId> ids;
+    std::vector<std::uint32_t> primes;  // "'" count of the last fresh name by base
+};
+
+struct Production
+{
+    SymbolId lhs;
+    std::uint32_t begin;  // offset of the right side in CompactGrammar::arena
+    std::uint32_t size;
+};
+
+// right side of a production, valid until the arena grows
+struct Rhs
+{
+    using value_type = SymbolId;
+    using const_iterator = const SymbolId *;
+
+    const SymbolId *first;
+    const SymbolId *last;
+
+    const SymbolId *begin() const
+    {
+        return first;
+    }
+
+    const SymbolId *end() const
+    {
+        return last;
+    }
+
+    size_t size() const
+    {
+        return static_cast<size_t>(last - first);
+    }
+
+    bool empty() const
+    {
+        return first == last;
+    }
+
+    SymbolId operator[](size_t i) const
+    {
+        return first[i];
+    }
+};
+
+/*
+ * Grammar with interned symbols: every right side lives in one flat arena,
+ * an empty right side is an epsilon rule
+ */
+struct CompactGrammar
+{
+    SymbolTable symbols;
+    SymbolId start = noSymbol;
+    std::vector<Production> productions;
+    std::vector<SymbolId> arena;
+
+    void addProduction(SymbolId lhs, const SymbolId *first, const SymbolId *last);
+
+    template<typename Container>
+    void addProduction(SymbolId lhs, const Container &rhs)
+    {
+        addProduction(lhs, std::data(rhs), std::data(rhs) + std::size(rhs));
+    }
+
+    Rhs getRhs(const Production &production) const;
+
+    // production indices of every nonterminal, indexed by symbol id
+    std::vector<std::vector<std::uint32_t>> groupByLhs() const;
+
+    // sorts productions by left side and right side, drops duplicates and compacts the arena
+    void normalize();
+
+    // keeps the productions with keep[i] set in their order and compacts the arena
+    void retain(const std::vector<bool> &keep);
+};
+
+// same symbols and start, no productions
+CompactGrammar makeEmptyCopy(const CompactGrammar &grammar);
+
+// concatenated symbol names of a right side
+std::string toString(const CompactGrammar &grammar, Rhs rhs);
+
+// one token per terminal symbol, noSymbol for characters the grammar does not know
+std::vector<SymbolId> tokenize(const CompactGrammar &grammar, std::string_view input);
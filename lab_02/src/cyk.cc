@@ -0,0 +1,230 @@
+#include "cyk.h"
+
+#include <algorithm>
+#include <tuple>
+
+#include "chomskyutils.h"
+#include "parallel.h"
+
+static constexpr std::uint32_t noIndex = static_cast<std::uint32_t>(-1);
+
+CykParser::CykParser(const CompactGrammar &grammar, size_t threads)
+    : grammar(toChomskyNormalForm(grammar)), threads(threads)
+{
+    const auto &symbols = this->grammar.symbols;
+
+    indices.assign(symbols.size(), noIndex);
+    for (SymbolId id = 0; id < symbols.size(); ++id)
+    {
+        if (symbols.isNonterm(id))
+        {
+            indices[id] = static_cast<std::uint32_t>(nonterms.size());
+            nonterms.push_back(id);
+        }
+    }
+
+    terminalRules.resize(symbols.size());
+    const auto &productions = this->grammar.productions;
+    for (std::uint32_t p = 0; p < productions.size(); ++p)
+    {
+        auto lhs = indices[productions[p].lhs];
+        auto rhs = this->grammar.getRhs(productions[p]);
+
+        if (rhs.size() == 2)
+        {
+            binaryRules.push_back({lhs, indices[rhs[0]], indices[rhs[1]], p});
+        }
+        else if (rhs.size() == 1)
+        {
+            terminalRules[rhs[0]].emplace_back(lhs, p);
+        }
+        else
+        {
+            acceptsEmpty = true;
+        }
+    }
+
+    std::sort(std::begin(binaryRules), std::end(binaryRules), [](auto &&a, auto &&b) {
+        return std::tie(a.left, a.right, a.lhs) < std::tie(b.left, b.right, b.lhs);
+    });
+
+    firstByLeft.assign(nonterms.size() + 1, 0);
+    rulesByLhs.resize(nonterms.size());
+    for (std::uint32_t i = 0; i < binaryRules.size(); ++i)
+    {
+        ++firstByLeft[binaryRules[i].left + 1];
+        rulesByLhs[binaryRules[i].lhs].push_back(i);
+    }
+    for (size_t i = 1; i < firstByLeft.size(); ++i)
+    {
+        firstByLeft[i] += firstByLeft[i - 1];
+    }
+}
+
+bool CykParser::spans(std::uint32_t nonterm, size_t begin, size_t end) const
+{
+    return ends[begin * nonterms.size() + nonterm].test(end);
+}
+
+bool CykParser::fill(const std::vector<SymbolId> &tokens)
+{
+    const auto count = nonterms.size();
+
+    if (length != tokens.size() || ends.size() != (tokens.size() + 1) * count)
+    {
+        length = tokens.size();
+        ends.assign((length + 1) * count, Bitset(length + 1));
+        starts.assign((length + 1) * count, Bitset(length + 1));
+    }
+    else
+    {
+        for (auto &&set: ends)
+        {
+            set.reset();
+        }
+        for (auto &&set: starts)
+        {
+            set.reset();
+        }
+    }
+
+    for (size_t i = 0; i < length; ++i)
+    {
+        if (tokens[i] >= terminalRules.size() || grammar.symbols.isNonterm(tokens[i]))
+        {
+            return false;
+        }
+
+        for (auto &&[lhs, _]: terminalRules[tokens[i]])
+        {
+            ends[i * count + lhs].set(i + 1);
+            starts[(i + 1) * count + lhs].set(i);
+        }
+    }
+
+    // a cell [i, i + span) only writes sets of start i and end i + span, no other
+    // cell of the same span touches them
+    for (size_t span = 2; span <= length; ++span)
+    {
+        parallelFor(length - span + 1, threads, [&](size_t i) {
+            auto j = i + span;
+            for (std::uint32_t left = 0; left < count; ++left)
+            {
+                const auto &leftEnds = ends[i * count + left];
+                if (firstByLeft[left] == firstByLeft[left + 1] ||
+                    !leftEnds.intersects(leftEnds, i + 1, j))
+                {
+                    continue;
+                }
+
+                for (auto r = firstByLeft[left]; r < firstByLeft[left + 1]; ++r)
+                {
+                    const auto &rule = binaryRules[r];
+                    auto &lhsEnds = ends[i * count + rule.lhs];
+                    if (!lhsEnds.test(j) &&
+                        leftEnds.intersects(starts[j * count + rule.right], i + 1, j))
+                    {
+                        lhsEnds.set(j);
+                        starts[j * count + rule.lhs].set(i);
+                    }
+                }
+            }
+        });
+    }
+    return true;
+}
+
+bool CykParser::recognize(const std::vector<SymbolId> &tokens)
+{
+    if (grammar.start == noSymbol || !fill(tokens))
+    {
+        return false;
+    }
+    return tokens.empty() ? acceptsEmpty : spans(indices[grammar.start], 0, tokens.size());
+}
+
+ParseResult CykParser::parse(std::string_view input)
+{
+    return parse(tokenize(grammar, input));
+}
+
+ParseResult CykParser::parse(const std::vector<SymbolId> &tokens)
+{
+    ParseResult result;
+    result.accepted = recognize(tokens);
+    if (!result.accepted)
+    {
+        auto it = std::find(std::begin(tokens), std::end(tokens), noSymbol);
+        result.errorPosition = static_cast<size_t>(it - std::begin(tokens));
+        return result;
+    }
+
+    result.errorPosition = tokens.size();
+    derive(tokens, result);
+    return result;
+}
+
+void CykParser::derive(const std::vector<SymbolId> &tokens, ParseResult &result) const
+{
+    if (tokens.empty())
+    {
+        for (auto &&production: grammar.productions)
+        {
+            if (production.lhs == grammar.start && production.size == 0)
+            {
+                result.derivation.push_back(
+                    static_cast<std::uint32_t>(&production - grammar.productions.data()));
+            }
+        }
+        return;
+    }
+
+    // the right part is pushed first so productions come out in leftmost order
+    std::vector<std::tuple<std::uint32_t, size_t, size_t>> pending = {
+        {indices[grammar.start], 0, tokens.size()}};
+
+    while (!pending.empty())
+    {
+        auto [nonterm, begin, end] = pending.back();
+        pending.pop_back();
+
+        if (end - begin == 1)
+        {
+            for (auto &&[lhs, production]: terminalRules[tokens[begin]])
+            {
+                if (lhs == nonterm)
+                {
+                    result.derivation.push_back(production);
+                    break;
+                }
+            }
+            continue;
+        }
+
+        bool found = false;
+        for (auto &&r: rulesByLhs[nonterm])
+        {
+            const auto &rule = binaryRules[r];
+            for (auto split = begin + 1; split < end && !found; ++split)
+            {
+                if (spans(rule.left, begin, split) && spans(rule.right, split, end))
+                {
+                    result.derivation.push_back(rule.production);
+                    pending.emplace_back(rule.right, split, end);
+                    pending.emplace_back(rule.left, begin, split);
+                    found = true;
+                }
+            }
+
+            if (found)
+            {
+                break;
+            }
+        }
+    }
+}
+
+const CompactGrammar &CykParser::getGrammar() const
+{
+    return grammar;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include "bitset.h"
+#include "compactgrammar.h"
+#include "parseresult.h"
+
+/*
+ * CYK over the Chomsky normal form of a grammar. For every start position and
+ * nonterminal the recognizer keeps the set of end positions it spans, and for every
+ * end position the set of starts, so A -> BC holds on [i, j) iff ends of B from i
+ * intersect starts of C before j: one word-parallel Bitset intersection instead
+ * of a loop over split points. Cells of one span length are independent and are
+ * filled in parallel
+ */
+class CykParser
+{
+public:
+    explicit CykParser(const CompactGrammar &grammar, size_t threads = 1);
+
+    bool recognize(const std::vector<SymbolId> &tokens);
+
+    // derivation holds the productions of one leftmost derivation in the normal form
+    ParseResult parse(const std::vector<SymbolId> &tokens);
+    ParseResult parse(std::string_view input);
+
+    const CompactGrammar &getGrammar() const;
+
+private:
+    struct BinaryRule
+    {
+        std::uint32_t lhs;
+        std::uint32_t left;
+        std::uint32_t right;
+        std::uint32_t production;
+    };
+
+    // fills the tables, false if a token is not a terminal of the grammar
+    bool fill(const std::vector<SymbolId> &tokens);
+
+    bool spans(std::uint32_t nonterm, size_t begin, size_t end) const;
+    void derive(const std::vector<SymbolId> &tokens, ParseResult &result) const;
+
+private:
+    CompactGrammar grammar;
+    size_t threads;
+
+    // nonterminals are numbered densely
+    std::vector<std::uint32_t> indices;
+    std::vector<SymbolId> nonterms;
+
+    std::vector<BinaryRule> binaryRules;  // sorted by left
+    std::vector<std::uint32_t> firstByLeft;
+    std::vector<std::vector<std::uint32_t>> rulesByLhs;
+    std::vector<std::vector<std::pair<std::uint32_t, std::uint32_t>>> terminalRules;
+    bool acceptsEmpty = false;
+
+    size_t length = 0;
+    std::vector<Bitset> ends;    // [begin * nonterms + A], bit end
+    std::vector<Bitset> starts;  // [end * nonterms + A], bit begin
+};
@@ -0,0 +1,690 @@
+#include "earley.h"
+
+#include <algorithm>
+#include <limits>
+
+#include "utils.h"
+
+static std::uint64_t makeKey(std::uint32_t high, std::uint32_t low)
+{
+    return std::uint64_t(high) << 32 | low;
+}
+
+void Sppf::clear(std::uint32_t symbolCount)
+{
+    nodes.clear();
+    families.clear();
+    this->symbolCount = symbolCount;
+    root = noNode;
+}
+
+std::uint32_t Sppf::addNode(std::uint32_t label, std::uint32_t begin, std::uint32_t end)
+{
+    nodes.push_back({label, begin, end});
+    return static_cast<std::uint32_t>(nodes.size() - 1);
+}
+
+bool Sppf::addFamily(
+    std::uint32_t node, std::uint32_t left, std::uint32_t right, std::uint32_t production)
+{
+    // appended, so the first family is the oldest one and never refers back to its node
+    auto *link = &nodes[node].families;
+    for (; *link != noNode; link = &families[*link].next)
+    {
+        const auto &family = families[*link];
+        if (family.left == left && family.right == right && family.production == production)
+        {
+            return false;
+        }
+    }
+
+    *link = static_cast<std::uint32_t>(families.size());
+    families.push_back({left, right, production, noNode});
+    return true;
+}
+
+const SppfNode &Sppf::getNode(std::uint32_t node) const
+{
+    return nodes[node];
+}
+
+const SppfFamily &Sppf::getFamily(std::uint32_t family) const
+{
+    return families[family];
+}
+
+size_t Sppf::getNodeCount() const
+{
+    return nodes.size();
+}
+
+size_t Sppf::getFamilyCount() const
+{
+    return families.size();
+}
+
+std::uint32_t Sppf::getRoot() const
+{
+    return root;
+}
+
+void Sppf::setRoot(std::uint32_t node)
+{
+    root = node;
+}
+
+bool Sppf::isIntermediate(std::uint32_t node) const
+{
+    return nodes[node].label >= symbolCount;
+}
+
+std::vector<std::uint32_t> Sppf::getChildren(std::uint32_t family) const
+{
+    std::vector<std::uint32_t> result;
+    while (true)
+    {
+        const auto &current = families[family];
+        if (current.right != noNode)
+        {
+            result.push_back(current.right);
+        }
+        if (current.left == noNode)
+        {
+            break;
+        }
+        if (!isIntermediate(current.left))
+        {
+            result.push_back(current.left);
+            break;
+        }
+
+        family = nodes[current.left].families;
+    }
+
+    std::reverse(std::begin(result), std::end(result));
+    return result;
+}
+
+size_t Sppf::countTrees() const
+{
+    constexpr size_t infinite = std::numeric_limits<size_t>::max();
+    if (root == noNode)
+    {
+        return 0;
+    }
+
+    auto add = [](size_t a, size_t b) { return a > infinite - b ? infinite : a + b; };
+    auto multiply = [](size_t a, size_t b) {
+        return a != 0 && b > infinite / a ? infinite : a * b;
+    };
+
+    // post order over the forest, a node met again while open closes a cycle
+    enum class State : std::uint8_t
+    {
+        New,
+        Open,
+        Done,
+    };
+
+    std::vector<State> states(nodes.size(), State::New);
+    std::vector<size_t> counts(nodes.size(), 0);
+    std::vector<std::pair<std::uint32_t, bool>> pending = {{root, false}};
+
+    while (!pending.empty())
+    {
+        auto [node, expanded] = pending.back();
+        pending.pop_back();
+
+        if (expanded)
+        {
+            size_t count = nodes[node].families == noNode ? 1 : 0;
+            for (auto i = nodes[node].families; i != noNode; i = families[i].next)
+            {
+                size_t product = 1;
+                for (auto &&child: {families[i].left, families[i].right})
+                {
+                    if (child != noNode)
+                    {
+                        product = multiply(product, counts[child]);
+                    }
+                }
+                count = add(count, product);
+            }
+            counts[node] = count;
+            states[node] = State::Done;
+            continue;
+        }
+
+        if (states[node] != State::New)
+        {
+            continue;
+        }
+
+        states[node] = State::Open;
+        pending.emplace_back(node, true);
+        for (auto i = nodes[node].families; i != noNode; i = families[i].next)
+        {
+            for (auto &&child: {families[i].left, families[i].right})
+            {
+                if (child == noNode)
+                {
+                    continue;
+                }
+                if (states[child] == State::Open)
+                {
+                    return infinite;
+                }
+                pending.emplace_back(child, false);
+            }
+        }
+    }
+    return counts[root];
+}
+
+void EarleyParser::ItemSet::clear()
+{
+    for (auto &&slot: used)
+    {
+        slots[slot] = noNode;
+    }
+    used.clear();
+}
+
+bool EarleyParser::ItemSet::insert(const std::vector<Item> &chart, std::uint32_t index)
+{
+    auto hash = [&](std::uint32_t i) {
+        const auto &item = chart[i];
+        std::uint64_t h = makeKey(item.item, item.origin) * 0x9e3779b97f4a7c15ull;
+        return (h ^ item.node) * 0xff51afd7ed558ccdull >> 20;
+    };
+
+    if (used.size() * 2 >= slots.size())
+    {
+        std::vector<std::uint32_t> old;
+        old.reserve(used.size());
+        for (auto &&slot: used)
+        {
+            old.push_back(slots[slot]);
+        }
+
+        slots.assign(std::max<size_t>(slots.size() * 2, 64), noNode);
+        used.clear();
+        for (auto &&i: old)
+        {
+            auto slot = hash(i) & (slots.size() - 1);
+            while (slots[slot] != noNode)
+            {
+                slot = (slot + 1) & (slots.size() - 1);
+            }
+            slots[slot] = i;
+            used.push_back(static_cast<std::uint32_t>(slot));
+        }
+    }
+
+    const auto &item = chart[index];
+    auto slot = hash(index) & (slots.size() - 1);
+    for (; slots[slot] != noNode; slot = (slot + 1) & (slots.size() - 1))
+    {
+        const auto &other = chart[slots[slot]];
+        if (other.item == item.item && other.origin == item.origin && other.node == item.node)
+        {
+            return false;
+        }
+    }
+
+    slots[slot] = index;
+    used.push_back(static_cast<std::uint32_t>(slot));
+    return true;
+}
+
+EarleyParser::EarleyParser(const CompactGrammar &grammar)
+    : grammar(grammar), byLhs(grammar.groupByLhs()), nullable(findEpsilonNonterms(grammar))
+{
+    for (std::uint32_t p = 0; p < grammar.productions.size(); ++p)
+    {
+        itemBase.push_back(static_cast<std::uint32_t>(itemProduction.size()));
+        for (std::uint32_t dot = 0; dot <= grammar.productions[p].size; ++dot)
+        {
+            itemProduction.push_back(p);
+        }
+    }
+}
+
+SymbolId EarleyParser::getNext(std::uint32_t item) const
+{
+    auto p = itemProduction[item];
+    auto dot = item - itemBase[p];
+    const auto &production = grammar.productions[p];
+    return dot == production.size ? noSymbol : grammar.arena[production.begin + dot];
+}
+
+void EarleyParser::startSet()
+{
+    setOffsets.push_back(static_cast<std::uint32_t>(chart.size()));
+    seen.clear();
+}
+
+void EarleyParser::add(Item item)
+{
+    chart.push_back(item);
+    if (!seen.insert(chart, static_cast<std::uint32_t>(chart.size() - 1)))
+    {
+        chart.pop_back();
+    }
+}
+
+void EarleyParser::finishSet(std::uint32_t set)
+{
+    auto first = waiting.size();
+    for (auto i = setOffsets[set]; i < chart.size(); ++i)
+    {
+        auto next = getNext(chart[i].item);
+        if (next != noSymbol)
+        {
+            waiting.emplace_back(next, i);
+        }
+    }
+    std::sort(std::begin(waiting) + first, std::end(waiting));
+    waitingOffsets.push_back(static_cast<std::uint32_t>(waiting.size()));
+}
+
+std::uint32_t EarleyParser::makeNode(std::uint32_t item, std::uint32_t begin, std::uint32_t end,
+    std::uint32_t left, std::uint32_t right)
+{
+    auto p = itemProduction[item];
+    auto dot = item - itemBase[p];
+    auto size = grammar.productions[p].size;
+
+    // B ::= x . y needs no node of its own, x's node stands for the prefix
+    if (dot == 1 && dot < size)
+    {
+        return right;
+    }
+
+    auto label = dot == size ? grammar.productions[p].lhs :
+                               static_cast<std::uint32_t>(grammar.symbols.size()) + item;
+
+    auto [it, inserted] = current.try_emplace(makeKey(label, begin), noNode);
+    if (inserted)
+    {
+        it->second = forest.addNode(label, begin, end);
+    }
+
+    forest.addFamily(it->second, left, right, p);
+    return it->second;
+}
+
+ParseResult EarleyParser::parse(std::string_view input)
+{
+    return parse(tokenize(grammar, input));
+}
+
+ParseResult EarleyParser::parse(const std::vector<SymbolId> &tokens)
+{
+    ParseResult result;
+    const auto n = static_cast<std::uint32_t>(tokens.size());
+
+    chart.clear();
+    setOffsets.clear();
+    waiting.clear();
+    waitingOffsets = {0};
+    current.clear();
+    forest.clear(static_cast<std::uint32_t>(grammar.symbols.size()));
+
+    if (grammar.start == noSymbol)
+    {
+        return result;
+    }
+
+    // items whose next symbol is a terminal wait for the scan in these
+    std::vector<Item> scans;
+    std::vector<Item> nextScans;
+
+    // completed nullable nonterminals of the current set and their nodes
+    std::vector<std::pair<SymbolId, std::uint32_t>> completedEmpty;
+
+    std::vector<std::uint32_t> predicted(grammar.symbols.size(), noNode);
+
+    auto place = [&](Item item, std::uint32_t i) {
+        auto next = getNext(item.item);
+        if (next == noSymbol || grammar.symbols.isNonterm(next))
+        {
+            add(item);
+        }
+        else if (i < n && next == tokens[i])
+        {
+            nextScans.push_back(item);
+        }
+    };
+
+    startSet();
+    for (auto &&p: byLhs[grammar.start])
+    {
+        place({itemBase[p], 0, noNode}, 0);
+    }
+
+    for (std::uint32_t i = 0; i <= n; ++i)
+    {
+        completedEmpty.clear();
+
+        for (auto r = setOffsets[i]; r < chart.size(); ++r)
+        {
+            auto item = chart[r];
+            auto next = getNext(item.item);
+
+            if (next != noSymbol)
+            {
+                if (predicted[next] != i)
+                {
+                    predicted[next] = i;
+                    for (auto &&p: byLhs[next])
+                    {
+                        place({itemBase[p], i, noNode}, i);
+                    }
+                }
+
+                // the nonterminal may already have been completed empty here
+                for (auto &&[nonterm, node]: completedEmpty)
+                {
+                    if (nonterm == next)
+                    {
+                        auto y = makeNode(item.item + 1, item.origin, i, item.node, node);
+                        place({item.item + 1, item.origin, y}, i);
+                    }
+                }
+                continue;
+            }
+
+            auto lhs = grammar.productions[itemProduction[item.item]].lhs;
+            auto node = item.node;
+            if (node == noNode)
+            {
+                auto [it, inserted] = current.try_emplace(makeKey(lhs, i), noNode);
+                if (inserted)
+                {
+                    it->second = forest.addNode(lhs, i, i);
+                }
+                node = it->second;
+                forest.addFamily(node, noNode, noNode, itemProduction[item.item]);
+            }
+
+            if (item.origin == i)
+            {
+                auto entry = std::make_pair(lhs, node);
+                if (std::find(std::begin(completedEmpty), std::end(completedEmpty), entry) !=
+                    std::end(completedEmpty))
+                {
+                    continue;
+                }
+
+                completedEmpty.push_back(entry);
+                for (auto w = setOffsets[i]; w < chart.size(); ++w)
+                {
+                    auto waiter = chart[w];
+                    if (getNext(waiter.item) == lhs)
+                    {
+                        auto y = makeNode(waiter.item + 1, waiter.origin, i, waiter.node, node);
+                        place({waiter.item + 1, waiter.origin, y}, i);
+                    }
+                }
+                continue;
+            }
+
+            auto first = std::begin(waiting) + waitingOffsets[item.origin];
+            auto last = std::begin(waiting) + waitingOffsets[item.origin + 1];
+            auto range = std::equal_range(first, last, std::make_pair(lhs, std::uint32_t(0)),
+                [](auto &&a, auto &&b) { return a.first < b.first; });
+
+            for (auto it = range.first; it != range.second; ++it)
+            {
+                auto waiter = chart[it->second];
+                auto y = makeNode(waiter.item + 1, waiter.origin, i, waiter.node, node);
+                place({waiter.item + 1, waiter.origin, y}, i);
+            }
+        }
+
+        finishSet(i);
+        if (i == n)
+        {
+            break;
+        }
+
+        // nextScans collected every item of this set waiting for tokens[i]
+        std::swap(scans, nextScans);
+        nextScans.clear();
+        if (scans.empty())
+        {
+            result.errorPosition = i;
+            return result;
+        }
+
+        current.clear();
+        startSet();
+
+        auto token = forest.addNode(tokens[i], i, i + 1);
+        for (auto &&item: scans)
+        {
+            auto y = makeNode(item.item + 1, item.origin, i + 1, item.node, token);
+            place({item.item + 1, item.origin, y}, i + 1);
+        }
+    }
+
+    auto root = current.find(makeKey(grammar.start, 0));
+    if (root == std::end(current))
+    {
+        result.errorPosition = n;
+        return result;
+    }
+
+    forest.setRoot(root->second);
+    result.accepted = true;
+    result.errorPosition = n;
+
+    // leftmost derivation along the first family of every node
+    std::vector<std::uint32_t> pending = {root->second};
+    while (!pending.empty())
+    {
+        auto node = pending.back();
+        pending.pop_back();
+
+        auto label = forest.getNode(node).label;
+        if (!grammar.symbols.isNonterm(label))
+        {
+            continue;
+        }
+
+        auto family = forest.getNode(node).families;
+        result.derivation.push_back(forest.getFamily(family).production);
+
+        auto children = forest.getChildren(family);
+        pending.insert(std::end(pending), children.rbegin(), children.rend());
+    }
+    return result;
+}
+
+bool EarleyParser::recognize(std::string_view input)
+{
+    return recognize(tokenize(grammar, input));
+}
+
+std::uint32_t EarleyParser::findLeo(std::uint32_t set, SymbolId nonterm)
+{
+    // marks the entry while the chain above it is followed
+    constexpr std::uint32_t open = noNode - 1;
+
+    auto [it, inserted] = leo.try_emplace(makeKey(set, nonterm), open);
+    if (!inserted)
+    {
+        return it->second;
+    }
+
+    auto first = std::begin(waiting) + waitingOffsets[set];
+    auto last = std::begin(waiting) + waitingOffsets[set + 1];
+    auto range = std::equal_range(first, last, std::make_pair(nonterm, std::uint32_t(0)),
+        [](auto &&a, auto &&b) { return a.first < b.first; });
+
+    // a single waiting item with the nonterminal last is deterministic
+    if (std::distance(range.first, range.second) != 1 ||
+        getNext(chart[range.first->second].item + 1) != noSymbol)
+    {
+        it->second = noNode;
+        return noNode;
+    }
+
+    auto waiter = chart[range.first->second];
+    auto lhs = grammar.productions[itemProduction[waiter.item]].lhs;
+
+    // the chain stops at a completed start symbol, acceptance looks for it in the set;
+    // the map may rehash meanwhile, so the entry is looked up again below
+    auto above = lhs == grammar.start && waiter.origin == 0 ? noNode : findLeo(waiter.origin, lhs);
+
+    // a chain looping back to an open entry has no topmost item, the item that
+    // closes the loop gets none and the ones below it stop right there
+    std::uint32_t result = above;
+    if (above == open)
+    {
+        result = noNode;
+    }
+    else if (above == noNode)
+    {
+        result = static_cast<std::uint32_t>(leoItems.size());
+        leoItems.push_back({waiter.item + 1, waiter.origin, noNode});
+    }
+
+    leo[makeKey(set, nonterm)] = result;
+    return result;
+}
+
+bool EarleyParser::recognize(const std::vector<SymbolId> &tokens)
+{
+    const auto n = static_cast<std::uint32_t>(tokens.size());
+
+    chart.clear();
+    setOffsets.clear();
+    waiting.clear();
+    waitingOffsets = {0};
+    leo.clear();
+    leoItems.clear();
+
+    if (grammar.start == noSymbol)
+    {
+        return false;
+    }
+
+    std::vector<bool> predicted(grammar.symbols.size(), false);
+
+    startSet();
+    for (auto &&p: byLhs[grammar.start])
+    {
+        add({itemBase[p], 0, noNode});
+    }
+
+    for (std::uint32_t i = 0;; ++i)
+    {
+        std::fill(std::begin(predicted), std::end(predicted), false);
+
+        for (auto r = setOffsets[i]; r < chart.size(); ++r)
+        {
+            auto item = chart[r];
+            auto next = getNext(item.item);
+
+            if (next != noSymbol)
+            {
+                if (!grammar.symbols.isNonterm(next))
+                {
+                    continue;
+                }
+
+                if (!predicted[next])
+                {
+                    predicted[next] = true;
+                    for (auto &&p: byLhs[next])
+                    {
+                        add({itemBase[p], i, noNode});
+                    }
+                }
+
+                // Aycock and Horspool: a nullable nonterminal may be skipped right away
+                if (nullable[next])
+                {
+                    add({item.item + 1, item.origin, noNode});
+                }
+                continue;
+            }
+
+            auto lhs = grammar.productions[itemProduction[item.item]].lhs;
+            if (item.origin == i)
+            {
+                // an empty completion, the waiting items of this set were advanced
+                // over the nullable nonterminal when they were met
+                continue;
+            }
+
+            if (auto top = findLeo(item.origin, lhs); top != noNode)
+            {
+                add(leoItems[top]);
+                continue;
+            }
+
+            auto first = std::begin(waiting) + waitingOffsets[item.origin];
+            auto last = std::begin(waiting) + waitingOffsets[item.origin + 1];
+            auto range = std::equal_range(first, last, std::make_pair(lhs, std::uint32_t(0)),
+                [](auto &&a, auto &&b) { return a.first < b.first; });
+
+            for (auto it = range.first; it != range.second; ++it)
+            {
+                const auto &waiter = chart[it->second];
+                add({waiter.item + 1, waiter.origin, noNode});
+            }
+        }
+
+        finishSet(i);
+        if (i == n)
+        {
+            break;
+        }
+
+        auto first = std::begin(waiting) + waitingOffsets[i];
+        auto last = std::begin(waiting) + waitingOffsets[i + 1];
+        auto range = std::equal_range(first, last, std::make_pair(tokens[i], std::uint32_t(0)),
+            [](auto &&a, auto &&b) { return a.first < b.first; });
+
+        startSet();
+        for (auto it = range.first; it != range.second; ++it)
+        {
+            const auto &waiter = chart[it->second];
+            add({waiter.item + 1, waiter.origin, noNode});
+        }
+
+        if (setOffsets.back() == chart.size())
+        {
+            return false;
+        }
+    }
+
+    for (auto r = setOffsets[n]; r < chart.size(); ++r)
+    {
+        const auto &item = chart[r];
+        if (item.origin == 0 && getNext(item.item) == noSymbol &&
+            grammar.productions[itemProduction[item.item]].lhs == grammar.start)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+const Sppf &EarleyParser::getForest() const
+{
+    return forest;
+}
+
+const CompactGrammar &EarleyParser::getGrammar() const
+{
+    return grammar;
+}
+
+size_t EarleyParser::getChartSize() const
+{
+    return chart.size();
+}
@@ -0,0 +1,153 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "compactgrammar.h"
+#include "parseresult.h"
+
+inline constexpr std::uint32_t noNode = static_cast<std::uint32_t>(-1);
+
+/*
+ * Shared packed parse forest. A node is labelled with a symbol, or with an item
+ * for the intermediate nodes that binarise long rules. Every family of a node is
+ * one way to derive it: up to two children (left may be noNode) and the production
+ */
+struct SppfNode
+{
+    std::uint32_t label;
+    std::uint32_t begin;
+    std::uint32_t end;
+    std::uint32_t families = noNode;  // first family, the others follow through next
+};
+
+struct SppfFamily
+{
+    std::uint32_t left;
+    std::uint32_t right;
+    std::uint32_t production;
+    std::uint32_t next;
+};
+
+class Sppf
+{
+public:
+    void clear(std::uint32_t symbolCount);
+
+    std::uint32_t addNode(std::uint32_t label, std::uint32_t begin, std::uint32_t end);
+
+    // false if the node already has this family
+    bool addFamily(std::uint32_t node, std::uint32_t left, std::uint32_t right,
+        std::uint32_t production);
+
+    const SppfNode &getNode(std::uint32_t node) const;
+    const SppfFamily &getFamily(std::uint32_t family) const;
+    size_t getNodeCount() const;
+    size_t getFamilyCount() const;
+
+    std::uint32_t getRoot() const;
+    void setRoot(std::uint32_t node);
+
+    // labels from symbolCount up are items
+    bool isIntermediate(std::uint32_t node) const;
+
+    // number of parse trees under the root, saturated and infinite for cyclic grammars
+    size_t countTrees() const;
+
+    // symbol children of a family, intermediate nodes flattened along their first family
+    std::vector<std::uint32_t> getChildren(std::uint32_t family) const;
+
+private:
+    std::vector<SppfNode> nodes;
+    std::vector<SppfFamily> families;
+    std::uint32_t symbolCount = 0;
+    std::uint32_t root = noNode;
+};
+
+/*
+ * Earley parser for any context free grammar, epsilon rules included (nullable
+ * nonterminals are advanced over when predicted). parse() follows Scott's algorithm
+ * and builds the forest of all derivations in O(n^3); recognize() skips the
+ * forest and uses Leo's transitive items, so right recursion stays linear.
+ * Chart items of all sets live in one arena and are deduplicated per set
+ */
+class EarleyParser
+{
+public:
+    explicit EarleyParser(const CompactGrammar &grammar);
+
+    bool recognize(const std::vector<SymbolId> &tokens);
+    bool recognize(std::string_view input);
+
+    // derivation holds one leftmost derivation, getForest() all of them
+    ParseResult parse(const std::vector<SymbolId> &tokens);
+    ParseResult parse(std::string_view input);
+
+    const Sppf &getForest() const;
+    const CompactGrammar &getGrammar() const;
+
+    // chart items created by the last call
+    size_t getChartSize() const;
+
+private:
+    struct Item
+    {
+        std::uint32_t item;
+        std::uint32_t origin;
+        std::uint32_t node;
+    };
+
+    // open addressing set over chart indices of the set being built
+    class ItemSet
+    {
+    public:
+        void clear();
+
+        // false if an equal item is already in the set
+        bool insert(const std::vector<Item> &chart, std::uint32_t index);
+
+    private:
+        std::vector<std::uint32_t> slots;
+        std::vector<std::uint32_t> used;
+    };
+
+    void startSet();
+    void add(Item item);
+    void finishSet(std::uint32_t set);
+
+    SymbolId getNext(std::uint32_t item) const;
+
+    std::uint32_t makeNode(std::uint32_t item, std::uint32_t begin, std::uint32_t end,
+        std::uint32_t left, std::uint32_t right);
+
+    std::uint32_t findLeo(std::uint32_t set, SymbolId nonterm);
+
+private:
+    CompactGrammar grammar;
+    std::vector<std::vector<std::uint32_t>> byLhs;
+    std::vector<bool> nullable;
+
+    // items of production p are itemBase[p] .. itemBase[p] + size
+    std::vector<std::uint32_t> itemBase;
+    std::vector<std::uint32_t> itemProduction;
+
+    std::vector<Item> chart;
+    std::vector<std::uint32_t> setOffsets;
+    ItemSet seen;
+
+    // chart indices of every finished set sorted by the symbol after the dot
+    std::vector<std::pair<SymbolId, std::uint32_t>> waiting;
+    std::vector<std::uint32_t> waitingOffsets;
+
+    // nodes ending at the current position by (label, begin)
+    std::unordered_map<std::uint64_t, std::uint32_t> current;
+
+    // Leo's topmost items by (set, nonterminal), an index into leoItems or noNode
+    std::unordered_map<std::uint64_t, std::uint32_t> leo;
+    std::vector<Item> leoItems;
+
+    Sppf forest;
+};
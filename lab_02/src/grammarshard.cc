@@ -0,0 +1,40 @@
+#include "grammarshard.h"
+
+GrammarShard::GrammarShard(SymbolId firstFresh) : firstFresh(firstFresh)
+{
+}
+
+SymbolId GrammarShard::fresh(SymbolId base)
+{
+    bases.push_back(base);
+    return firstFresh + static_cast<SymbolId>(bases.size() - 1);
+}
+
+void GrammarShard::addProduction(SymbolId lhs, const SymbolId *first, const SymbolId *last)
+{
+    auto begin = static_cast<std::uint32_t>(arena.size());
+    arena.insert(std::end(arena), first, last);
+    productions.push_back({lhs, begin, static_cast<std::uint32_t>(last - first)});
+}
+
+void GrammarShard::mergeInto(CompactGrammar &grammar) const
+{
+    std::vector<SymbolId> names(bases.size());
+    auto name = [&](SymbolId symbol) {
+        return symbol < firstFresh ? symbol : names[symbol - firstFresh];
+    };
+
+    for (size_t i = 0; i < bases.size(); ++i)
+    {
+        names[i] = grammar.symbols.fresh(name(bases[i]));
+    }
+
+    std::vector<SymbolId> rhs;
+    for (auto &&production: productions)
+    {
+        rhs.clear();
+        std::transform(arena.data() + production.begin,
+            arena.data() + production.begin + production.size, std::back_inserter(rhs), name);
+        grammar.addProduction(name(production.lhs), rhs);
+    }
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <vector>
+
+#include "compactgrammar.h"
+#include "parallel.h"
+
+/*
+ * Productions built by one worker of a parallel pass while the shared symbol table
+ * is only read. Nonterminals the worker makes are numbered from firstFresh on and
+ * get their names when shards are merged in order, so the output of any number of
+ * threads is named exactly as a sequential run names it
+ */
+class GrammarShard
+{
+public:
+    explicit GrammarShard(SymbolId firstFresh);
+
+    // base may be a nonterminal of this shard as well
+    SymbolId fresh(SymbolId base);
+
+    void addProduction(SymbolId lhs, const SymbolId *first, const SymbolId *last);
+
+    template<typename Container>
+    void addProduction(SymbolId lhs, const Container &rhs)
+    {
+        addProduction(lhs, std::data(rhs), std::data(rhs) + std::size(rhs));
+    }
+
+    // adds the productions to grammar, fresh nonterminals are named in creation order
+    void mergeInto(CompactGrammar &grammar) const;
+
+private:
+    SymbolId firstFresh;
+    std::vector<SymbolId> bases;
+    std::vector<Production> productions;
+    std::vector<SymbolId> arena;
+};
+
+/*
+ * Splits [0, count) into contiguous ranges, f(shard, begin, end) fills the shard of
+ * one range on some thread and the shards are merged into grammar in range order.
+ * The range split only affects speed, never the result
+ */
+template<typename F>
+void runSharded(CompactGrammar &grammar, size_t count, size_t threads, F &&f)
+{
+    threads = std::max<size_t>(threads, 1);
+    auto chunks = std::min(count, threads == 1 ? 1 : threads * 4);
+
+    std::vector<GrammarShard> shards(chunks, GrammarShard(grammar.symbols.size()));
+    parallelFor(chunks, threads, [&](size_t chunk) {
+        f(shards[chunk], count * chunk / chunks, count * (chunk + 1) / chunks);
+    });
+
+    for (auto &&shard: shards)
+    {
+        shard.mergeInto(grammar);
+    }
+}
@@ -0,0 +1,719 @@
+#include "lalr.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <unordered_map>
+
+#include "analysis.h"
+#include "bitset.h"
+#include "parallel.h"
+
+// actions are packed as kind in the low two bits and value above them
+static std::uint32_t encode(LrAction action)
+{
+    return action.value << 2 | static_cast<std::uint32_t>(action.kind);
+}
+
+static LrAction decode(std::uint32_t code)
+{
+    return {static_cast<LrActionKind>(code & 3), code >> 2};
+}
+
+namespace
+{
+struct Transition
+{
+    SymbolId symbol;
+    StateId target;
+    std::uint32_t nonterm;  // index among nonterminal transitions, noIndex on terminals
+};
+
+// transitions and completed productions of one state, computed from its kernel alone
+struct Expansion
+{
+    std::vector<std::pair<SymbolId, std::vector<std::uint32_t>>> successors;
+    std::vector<std::uint32_t> reductions;
+};
+
+constexpr std::uint32_t noIndex = static_cast<std::uint32_t>(-1);
+
+/*
+ * LR(0) automaton. An item is a number: items of production p are
+ * itemBase[p] .. itemBase[p] + size, one per dot position
+ */
+class Lr0Automaton
+{
+public:
+    Lr0Automaton(const CompactGrammar &grammar, std::uint32_t augmented, size_t threads)
+        : grammar(grammar), byLhs(grammar.groupByLhs())
+    {
+        for (std::uint32_t p = 0; p < grammar.productions.size(); ++p)
+        {
+            itemBase.push_back(static_cast<std::uint32_t>(itemProduction.size()));
+            for (std::uint32_t dot = 0; dot <= grammar.productions[p].size; ++dot)
+            {
+                itemProduction.push_back(p);
+            }
+        }
+
+        intern({itemBase[augmented]});
+        for (size_t begin = 0; begin < getStateCount();)
+        {
+            size_t end = getStateCount();
+
+            std::vector<Expansion> expansions(end - begin);
+            parallelFor(expansions.size(), threads,
+                [&](size_t i) { expansions[i] = expand(static_cast<StateId>(begin + i)); });
+
+            transitions.resize(end);
+            reductions.resize(end);
+            for (size_t i = 0; i < expansions.size(); ++i)
+            {
+                auto state = begin + i;
+                for (auto &&[symbol, kernel]: expansions[i].successors)
+                {
+                    transitions[state].push_back({symbol, intern(kernel), noIndex});
+                }
+                reductions[state] = std::move(expansions[i].reductions);
+            }
+            begin = end;
+        }
+    }
+
+    size_t getStateCount() const
+    {
+        return kernelOffsets.size() - 1;
+    }
+
+    StateId getTarget(StateId state, SymbolId symbol) const
+    {
+        const auto *transition = find(state, symbol);
+        return transition ? transition->target : noState;
+    }
+
+    const Transition *find(StateId state, SymbolId symbol) const
+    {
+        const auto &list = transitions[state];
+        auto it = std::lower_bound(std::begin(list), std::end(list), symbol,
+            [](auto &&transition, SymbolId x) { return transition.symbol < x; });
+        return it != std::end(list) && it->symbol == symbol ? &*it : nullptr;
+    }
+
+public:
+    std::vector<std::vector<Transition>> transitions;
+    std::vector<std::vector<std::uint32_t>> reductions;
+
+private:
+    StateId intern(const std::vector<std::uint32_t> &kernel)
+    {
+        std::uint64_t hash = 14695981039346656037ull;
+        for (auto &&item: kernel)
+        {
+            hash = (hash ^ item) * 1099511628211ull;
+        }
+
+        auto &bucket = states[hash];
+        for (auto &&state: bucket)
+        {
+            auto first = std::begin(kernels) + kernelOffsets[state];
+            auto last = std::begin(kernels) + kernelOffsets[state + 1];
+            if (std::equal(first, last, std::begin(kernel), std::end(kernel)))
+            {
+                return state;
+            }
+        }
+
+        auto state = static_cast<StateId>(getStateCount());
+        kernels.insert(std::end(kernels), std::begin(kernel), std::end(kernel));
+        kernelOffsets.push_back(static_cast<std::uint32_t>(kernels.size()));
+        bucket.push_back(state);
+        return state;
+    }
+
+    // closes the kernel and groups the advanced items by the symbol after the dot
+    Expansion expand(StateId state) const
+    {
+        Expansion result;
+        std::vector<std::pair<SymbolId, std::uint32_t>> advanced;
+
+        std::vector<bool> closed(grammar.symbols.size(), false);
+        std::vector<SymbolId> pending;
+
+        auto visit = [&](std::uint32_t item) {
+            auto p = itemProduction[item];
+            auto dot = item - itemBase[p];
+            auto rhs = grammar.getRhs(grammar.productions[p]);
+
+            if (dot == rhs.size())
+            {
+                result.reductions.push_back(p);
+                return;
+            }
+
+            auto symbol = rhs[dot];
+            advanced.emplace_back(symbol, item + 1);
+            if (grammar.symbols.isNonterm(symbol) && !closed[symbol])
+            {
+                closed[symbol] = true;
+                pending.push_back(symbol);
+            }
+        };
+
+        for (auto i = kernelOffsets[state]; i < kernelOffsets[state + 1]; ++i)
+        {
+            visit(kernels[i]);
+        }
+        while (!pending.empty())
+        {
+            auto nonterm = pending.back();
+            pending.pop_back();
+            for (auto &&p: byLhs[nonterm])
+            {
+                visit(itemBase[p]);
+            }
+        }
+
+        std::sort(std::begin(advanced), std::end(advanced));
+        for (size_t i = 0; i < advanced.size();)
+        {
+            auto &[symbol, kernel] = result.successors.emplace_back();
+            symbol = advanced[i].first;
+            for (; i < advanced.size() && advanced[i].first == symbol; ++i)
+            {
+                kernel.push_back(advanced[i].second);
+            }
+        }
+
+        std::sort(std::begin(result.reductions), std::end(result.reductions));
+        return result;
+    }
+
+private:
+    const CompactGrammar &grammar;
+    std::vector<std::vector<std::uint32_t>> byLhs;
+
+    std::vector<std::uint32_t> itemBase;
+    std::vector<std::uint32_t> itemProduction;
+
+    // sorted kernel items of every state, flattened
+    std::vector<std::uint32_t> kernels;
+    std::vector<std::uint32_t> kernelOffsets = {0};
+    std::unordered_map<std::uint64_t, std::vector<StateId>> states;
+};
+
+/*
+ * DeRemer and Pennello's digraph: F(x) becomes the union of F(y) over every y
+ * reachable from x, strongly connected components share one set
+ */
+void digraph(std::vector<Bitset> &sets, const std::vector<std::vector<std::uint32_t>> &edges)
+{
+    constexpr std::uint32_t done = static_cast<std::uint32_t>(-1);
+
+    struct Frame
+    {
+        std::uint32_t node;
+        std::uint32_t edge;
+        std::uint32_t depth;
+    };
+
+    std::vector<std::uint32_t> depths(sets.size(), 0);
+    std::vector<std::uint32_t> stack;
+    std::vector<Frame> calls;
+
+    auto enter = [&](std::uint32_t node) {
+        stack.push_back(node);
+        depths[node] = static_cast<std::uint32_t>(stack.size());
+        calls.push_back({node, 0, depths[node]});
+    };
+
+    auto merge = [&](std::uint32_t x, std::uint32_t y) {
+        depths[x] = std::min(depths[x], depths[y]);
+        sets[x].unite(sets[y]);
+    };
+
+    for (std::uint32_t root = 0; root < sets.size(); ++root)
+    {
+        if (depths[root] != 0)
+        {
+            continue;
+        }
+
+        enter(root);
+        while (!calls.empty())
+        {
+            auto x = calls.back().node;
+            if (calls.back().edge < edges[x].size())
+            {
+                auto y = edges[x][calls.back().edge++];
+                if (depths[y] == 0)
+                {
+                    enter(y);
+                }
+                else
+                {
+                    merge(x, y);
+                }
+                continue;
+            }
+
+            auto depth = calls.back().depth;
+            calls.pop_back();
+
+            if (depths[x] == depth)
+            {
+                std::uint32_t top;
+                do
+                {
+                    top = stack.back();
+                    stack.pop_back();
+                    depths[top] = done;
+                    if (top != x)
+                    {
+                        sets[top] = sets[x];
+                    }
+                } while (top != x);
+            }
+
+            if (!calls.empty())
+            {
+                merge(calls.back().node, x);
+            }
+        }
+    }
+}
+}  // namespace
+
+LalrTable::LalrTable(CompactGrammar grammar, size_t threads) : grammar(std::move(grammar))
+{
+    auto &g = this->grammar;
+    if (g.start == noSymbol)
+    {
+        throw std::invalid_argument("LalrTable: the grammar has no start symbol");
+    }
+
+    // S' -> S, accepted on the end marker instead of being reduced
+    auto start = g.start;
+    auto augmentedStart = g.symbols.fresh(start);
+    auto augmented = static_cast<std::uint32_t>(g.productions.size());
+    g.addProduction(augmentedStart, std::vector<SymbolId>{start});
+
+    GrammarAnalysis analysis(g);
+    Lr0Automaton automaton(g, augmented, threads);
+    stateCount = automaton.getStateCount();
+
+    columns.assign(g.symbols.size(), noColumn);
+    for (size_t i = 0; i < analysis.getTerminalCount(); ++i)
+    {
+        columns[analysis.getTerminal(i)] = i;
+    }
+    columnCount = analysis.getTerminalCount() + 1;
+
+    // nonterminal transitions, the nodes of the reads and includes relations
+    std::vector<std::pair<StateId, SymbolId>> nonterms;
+    for (StateId state = 0; state < stateCount; ++state)
+    {
+        for (auto &&transition: automaton.transitions[state])
+        {
+            if (g.symbols.isNonterm(transition.symbol))
+            {
+                transition.nonterm = static_cast<std::uint32_t>(nonterms.size());
+                nonterms.emplace_back(state, transition.symbol);
+            }
+        }
+    }
+
+    // direct reads: terminals shifted right after the transition
+    std::vector<Bitset> follow(nonterms.size(), Bitset(columnCount));
+    std::vector<std::vector<std::uint32_t>> reads(nonterms.size());
+
+    for (std::uint32_t i = 0; i < nonterms.size(); ++i)
+    {
+        auto [state, nonterm] = nonterms[i];
+        auto target = automaton.getTarget(state, nonterm);
+
+        for (auto &&transition: automaton.transitions[target])
+        {
+            if (!g.symbols.isNonterm(transition.symbol))
+            {
+                follow[i].set(columns[transition.symbol]);
+            }
+            else if (analysis.isNullable(transition.symbol))
+            {
+                reads[i].push_back(transition.nonterm);
+            }
+        }
+
+        if (state == 0 && nonterm == start)
+        {
+            follow[i].set(getEndColumn());
+        }
+    }
+
+    digraph(follow, reads);
+
+    // (p, A) includes (p', B) for B -> x A y with nullable y and p' --x--> p,
+    // a reduction of B -> w in q looks back to (p', B) with p' --w--> q
+    std::vector<std::vector<std::uint32_t>> includes(nonterms.size());
+    std::vector<std::vector<std::pair<std::uint32_t, std::uint32_t>>> lookbacks(stateCount);
+
+    auto byLhs = g.groupByLhs();
+    for (std::uint32_t i = 0; i < nonterms.size(); ++i)
+    {
+        auto [from, lhs] = nonterms[i];
+        for (auto &&p: byLhs[lhs])
+        {
+            auto rhs = g.getRhs(g.productions[p]);
+
+            auto state = from;
+            for (size_t dot = 0; dot < rhs.size(); ++dot)
+            {
+                const auto *transition = automaton.find(state, rhs[dot]);
+                if (transition->nonterm != noIndex &&
+                    analysis.isNullable(Rhs{rhs.begin() + dot + 1, rhs.end()}))
+                {
+                    includes[transition->nonterm].push_back(i);
+                }
+                state = transition->target;
+            }
+
+            lookbacks[state].emplace_back(p, i);
+        }
+    }
+
+    digraph(follow, includes);
+
+    // action rows, equal rows are stored once
+    std::unordered_map<std::uint64_t, std::vector<std::uint32_t>> rowsByHash;
+    std::vector<std::uint32_t> row(columnCount);
+
+    for (StateId state = 0; state < stateCount; ++state)
+    {
+        std::fill(std::begin(row), std::end(row), encode({}));
+
+        auto put = [&](size_t column, LrAction action) {
+            auto current = decode(row[column]);
+            if (current.kind == LrActionKind::Error)
+            {
+                row[column] = encode(action);
+                return;
+            }
+
+            bool replace = current.kind == LrActionKind::Reduce &&
+                (action.kind == LrActionKind::Shift || action.value < current.value);
+            auto terminal = column == getEndColumn() ? noSymbol : analysis.getTerminal(column);
+            if (replace)
+            {
+                std::swap(action, current);
+                row[column] = encode(current);
+            }
+            conflicts.push_back({state, terminal, current, action});
+        };
+
+        for (auto &&transition: automaton.transitions[state])
+        {
+            if (!g.symbols.isNonterm(transition.symbol))
+            {
+                put(columns[transition.symbol], {LrActionKind::Shift, transition.target});
+            }
+        }
+
+        for (auto &&p: automaton.reductions[state])
+        {
+            if (p == augmented)
+            {
+                put(getEndColumn(), {LrActionKind::Accept, 0});
+                continue;
+            }
+
+            Bitset lookahead(columnCount);
+            for (auto &&[production, nonterm]: lookbacks[state])
+            {
+                if (production == p)
+                {
+                    lookahead.unite(follow[nonterm]);
+                }
+            }
+            lookahead.forEach([&](size_t column) { put(column, {LrActionKind::Reduce, p}); });
+        }
+
+        std::uint64_t hash = 14695981039346656037ull;
+        for (auto &&code: row)
+        {
+            hash = (hash ^ code) * 1099511628211ull;
+        }
+
+        auto &bucket = rowsByHash[hash];
+        auto it = std::find_if(std::begin(bucket), std::end(bucket), [&](auto &&index) {
+            auto first = std::begin(actions) + index * columnCount;
+            return std::equal(std::begin(row), std::end(row), first);
+        });
+
+        if (it != std::end(bucket))
+        {
+            actionRows.push_back(*it);
+        }
+        else
+        {
+            auto index = static_cast<std::uint32_t>(actions.size() / columnCount);
+            actions.insert(std::end(actions), std::begin(row), std::end(row));
+            bucket.push_back(index);
+            actionRows.push_back(index);
+        }
+    }
+
+    // gotos grouped by nonterminal, sorted by source state since states are visited in order
+    gotoOffsets.assign(g.symbols.size() + 1, 0);
+    for (auto &&[state, nonterm]: nonterms)
+    {
+        ++gotoOffsets[nonterm + 1];
+    }
+    for (size_t i = 1; i < gotoOffsets.size(); ++i)
+    {
+        gotoOffsets[i] += gotoOffsets[i - 1];
+    }
+
+    gotos.resize(nonterms.size());
+    auto next = gotoOffsets;
+    for (auto &&[state, nonterm]: nonterms)
+    {
+        gotos[next[nonterm]++] = {state, automaton.getTarget(state, nonterm)};
+    }
+}
+
+LrAction LalrTable::getAction(StateId state, size_t column) const
+{
+    return decode(actions[actionRows[state] * columnCount + column]);
+}
+
+StateId LalrTable::getGoto(StateId state, SymbolId nonterm) const
+{
+    auto first = std::begin(gotos) + gotoOffsets[nonterm];
+    auto last = std::begin(gotos) + gotoOffsets[nonterm + 1];
+    auto it = std::lower_bound(
+        first, last, state, [](auto &&entry, StateId x) { return entry.first < x; });
+    return it != last && it->first == state ? it->second : noState;
+}
+
+size_t LalrTable::getColumn(SymbolId terminal) const
+{
+    return terminal < columns.size() ? columns[terminal] : noColumn;
+}
+
+size_t LalrTable::getEndColumn() const
+{
+    return columnCount - 1;
+}
+
+size_t LalrTable::getStateCount() const
+{
+    return stateCount;
+}
+
+size_t LalrTable::getActionRowCount() const
+{
+    return actions.size() / columnCount;
+}
+
+const std::vector<LalrConflict> &LalrTable::getConflicts() const
+{
+    return conflicts;
+}
+
+bool LalrTable::isLalr() const
+{
+    return conflicts.empty();
+}
+
+const CompactGrammar &LalrTable::getGrammar() const
+{
+    return grammar;
+}
+
+std::string LalrTable::toString(const LalrConflict &conflict) const
+{
+    auto action = [this](LrAction action) -> std::string {
+        switch (action.kind)
+        {
+            case LrActionKind::Shift:
+                return "shift " + std::to_string(action.value);
+            case LrActionKind::Reduce:
+            {
+                const auto &production = grammar.productions[action.value];
+                auto rhs = grammar.getRhs(production);
+                return "reduce " + grammar.symbols.getName(production.lhs) + " -> " +
+                    (rhs.empty() ? epsilon : ::toString(grammar, rhs));
+            }
+            case LrActionKind::Accept:
+                return "accept";
+            default:
+                return "error";
+        }
+    };
+
+    return "state " + std::to_string(conflict.state) + " on " +
+        (conflict.terminal == noSymbol ? endMarker : grammar.symbols.getName(conflict.terminal)) +
+        ": " + action(conflict.kept) + " vs " + action(conflict.dropped);
+}
+
+void LalrTable::write(BinaryWriter &writer) const
+{
+    writeGrammar(writer, grammar);
+    writer.writeIndices(columns);
+    writer.writeVarint(columnCount);
+    writer.writeVarint(stateCount);
+    writer.writeIndices(actionRows);
+    writer.writeIndices(actions);
+    writer.writeIndices(gotoOffsets);
+
+    writer.writeVarint(gotos.size());
+    for (auto &&[from, to]: gotos)
+    {
+        writer.writeVarint(from);
+        writer.writeVarint(to);
+    }
+
+    writer.writeVarint(conflicts.size());
+    for (auto &&conflict: conflicts)
+    {
+        writer.writeVarint(conflict.state);
+        writer.writeIndex(conflict.terminal);
+        writer.writeVarint(encode(conflict.kept));
+        writer.writeVarint(encode(conflict.dropped));
+    }
+}
+
+LalrTable LalrTable::read(BinaryReader &reader)
+{
+    auto check = [](bool condition) {
+        if (!condition)
+        {
+            throw std::runtime_error("LalrTable::read: inconsistent table");
+        }
+    };
+
+    LalrTable table;
+    table.grammar = readGrammar(reader);
+    table.columns = reader.readIndices<size_t>();
+    table.columnCount = static_cast<size_t>(reader.readVarint());
+    table.stateCount = static_cast<size_t>(reader.readVarint());
+    table.actionRows = reader.readIndices<std::uint32_t>();
+    table.actions = reader.readIndices<std::uint32_t>();
+    table.gotoOffsets = reader.readIndices<std::uint32_t>();
+
+    auto symbolCount = table.grammar.symbols.size();
+    auto productionCount = table.grammar.productions.size();
+    check(table.columns.size() == symbolCount && table.columnCount > 0);
+    check(table.actionRows.size() == table.stateCount);
+    check(table.actions.size() % table.columnCount == 0);
+    for (auto &&column: table.columns)
+    {
+        check(column == noColumn || column < table.columnCount);
+    }
+    for (auto &&row: table.actionRows)
+    {
+        check(row < table.actions.size() / table.columnCount);
+    }
+
+    auto valid = [&](LrAction action) {
+        switch (action.kind)
+        {
+            case LrActionKind::Shift:
+                return action.value < table.stateCount;
+            case LrActionKind::Reduce:
+                return action.value < productionCount;
+            default:
+                return true;
+        }
+    };
+    for (auto &&code: table.actions)
+    {
+        check(valid(decode(code)));
+    }
+
+    auto gotoCount = reader.readCount();
+    check(table.gotoOffsets.size() == symbolCount + 1 && table.gotoOffsets.front() == 0 &&
+        table.gotoOffsets.back() == gotoCount &&
+        std::is_sorted(std::begin(table.gotoOffsets), std::end(table.gotoOffsets)));
+    for (size_t i = 0; i < gotoCount; ++i)
+    {
+        auto from = static_cast<StateId>(reader.readVarint());
+        auto to = static_cast<StateId>(reader.readVarint());
+        check(from < table.stateCount && to < table.stateCount);
+        table.gotos.emplace_back(from, to);
+    }
+
+    for (auto count = reader.readCount(); count > 0; --count)
+    {
+        auto &conflict = table.conflicts.emplace_back();
+        conflict.state = static_cast<StateId>(reader.readVarint());
+        conflict.terminal = reader.readIndex<SymbolId>();
+        conflict.kept = decode(static_cast<std::uint32_t>(reader.readVarint()));
+        conflict.dropped = decode(static_cast<std::uint32_t>(reader.readVarint()));
+        check(conflict.state < table.stateCount &&
+            (conflict.terminal == noSymbol || conflict.terminal < symbolCount) &&
+            valid(conflict.kept) && valid(conflict.dropped));
+    }
+    return table;
+}
+
+LalrTable makeLalrTable(const Grammar &grammar, std::string_view start, size_t threads)
+{
+    return LalrTable(toCompact(grammar, start), threads);
+}
+
+LalrParser::LalrParser(const LalrTable &table) : table(table)
+{
+    if (!table.isLalr())
+    {
+        throw std::invalid_argument(
+            "LalrParser: " + table.toString(table.getConflicts().front()));
+    }
+}
+
+ParseResult LalrParser::parse(std::string_view input)
+{
+    return parse(tokenize(table.getGrammar(), input));
+}
+
+ParseResult LalrParser::parse(const std::vector<SymbolId> &tokens)
+{
+    const auto &grammar = table.getGrammar();
+    ParseResult result;
+
+    stack.clear();
+    stack.push_back(0);
+
+    size_t pos = 0;
+    while (true)
+    {
+        auto column = pos == tokens.size() ? table.getEndColumn() : table.getColumn(tokens[pos]);
+        result.errorPosition = pos;
+
+        if (column == LalrTable::noColumn)
+        {
+            return result;
+        }
+
+        auto action = table.getAction(stack.back(), column);
+        switch (action.kind)
+        {
+            case LrActionKind::Shift:
+                stack.push_back(action.value);
+                ++pos;
+                break;
+            case LrActionKind::Reduce:
+            {
+                const auto &production = grammar.productions[action.value];
+                stack.resize(stack.size() - production.size);
+                stack.push_back(table.getGoto(stack.back(), production.lhs));
+                result.derivation.push_back(action.value);
+                break;
+            }
+            case LrActionKind::Accept:
+                result.accepted = true;
+                return result;
+            default:
+                return result;
+        }
+    }
+}
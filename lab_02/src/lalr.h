@@ -0,0 +1,117 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "binaryio.h"
+#include "compactgrammar.h"
+#include "parseresult.h"
+#include "utils.h"
+
+using StateId = std::uint32_t;
+
+inline constexpr StateId noState = static_cast<StateId>(-1);
+
+enum class LrActionKind : std::uint8_t
+{
+    Error,
+    Shift,   // value is the target state
+    Reduce,  // value is the production index
+    Accept,
+};
+
+struct LrAction
+{
+    LrActionKind kind = LrActionKind::Error;
+    std::uint32_t value = 0;
+};
+
+struct LalrConflict
+{
+    StateId state;
+    SymbolId terminal;  // noSymbol for the end marker
+    LrAction kept;
+    LrAction dropped;
+};
+
+/*
+ * LALR(1) tables of a grammar: the LR(0) automaton with kernels interned by hash,
+ * lookaheads by DeRemer and Pennello (reads and includes relations). States of
+ * one breadth first level are closed in parallel and numbered in a fixed order,
+ * so the tables do not depend on the number of threads.
+ *
+ * Conflicts are resolved as yacc does, shift over reduce and the earlier
+ * production over the later one, and recorded. Equal action rows are stored once,
+ * gotos are kept per nonterminal as sorted (from, to) pairs
+ */
+class LalrTable
+{
+public:
+    // throws std::invalid_argument for a grammar without a start symbol
+    explicit LalrTable(CompactGrammar grammar, size_t threads = 1);
+
+    LrAction getAction(StateId state, size_t column) const;
+    StateId getGoto(StateId state, SymbolId nonterm) const;
+
+    // column of a terminal, noColumn for anything the grammar does not know
+    size_t getColumn(SymbolId terminal) const;
+    size_t getEndColumn() const;
+
+    size_t getStateCount() const;
+    size_t getActionRowCount() const;
+
+    const std::vector<LalrConflict> &getConflicts() const;
+    bool isLalr() const;
+
+    // the grammar with the augmented start production S' -> S appended
+    const CompactGrammar &getGrammar() const;
+
+    std::string toString(const LalrConflict &conflict) const;
+
+    // read throws std::runtime_error on data that is not a table
+    void write(BinaryWriter &writer) const;
+    static LalrTable read(BinaryReader &reader);
+
+    static constexpr size_t noColumn = static_cast<size_t>(-1);
+
+private:
+    LalrTable() = default;
+
+private:
+    CompactGrammar grammar;
+
+    std::vector<size_t> columns;
+    size_t columnCount = 0;
+    size_t stateCount = 0;
+
+    std::vector<std::uint32_t> actionRows;  // row of every state
+    std::vector<std::uint32_t> actions;     // encoded actions, columnCount per row
+
+    std::vector<std::uint32_t> gotoOffsets;  // by nonterminal, into gotos
+    std::vector<std::pair<StateId, StateId>> gotos;
+
+    std::vector<LalrConflict> conflicts;
+};
+
+LalrTable makeLalrTable(const Grammar &grammar, std::string_view start = "S", size_t threads = 1);
+
+/*
+ * Shift-reduce parser over a conflict free table, a table with conflicts is
+ * rejected with std::invalid_argument
+ */
+class LalrParser
+{
+public:
+    explicit LalrParser(const LalrTable &table);
+
+    // derivation holds the reduced productions in order, the reversed rightmost derivation
+    ParseResult parse(const std::vector<SymbolId> &tokens);
+    ParseResult parse(std::string_view input);
+
+private:
+    const LalrTable &table;
+
+    std::vector<StateId> stack;
+};
@@ -1,88 +1,349 @@
 #include "leftutils.h"
 
-Grammar eliminateLeftRecursion(const Grammar &grammar)
-{
-    auto newGrammar = removeEpsilonNonterms(grammar);
-    std::vector<std::string> nonterms;
+#include <functional>
+#include <queue>
+#include <unordered_map>
+#include <unordered_set>
 
-    std::transform(std::begin(newGrammar), std::end(newGrammar), std::back_inserter(nonterms),
-        [](auto &&kv) { return kv.first; });
+#include "grammarshard.h"
 
-    for (size_t i = 0; i < nonterms.size(); ++i)
-    {
-        auto &&nontermI = nonterms[i];
-        auto &&rulesI = newGrammar[nontermI];
-        for (size_t j = 0; j < i; ++j)
-        {
-            auto &&nontermJ = nonterms[j];
-            auto &&rulesJ = newGrammar[nontermJ];
+using Rule = std::vector<SymbolId>;
 
-            std::vector<std::string> filteredRules;
-            std::copy_if(std::begin(rulesI), std::end(rulesI), std::back_inserter(filteredRules),
-                [&](auto &&rule) { return isRecursiveRule(rule, nontermJ); });
+static constexpr std::uint32_t noIndex = static_cast<std::uint32_t>(-1);
 
-            for (auto &&rule: filteredRules)
-            {
-                rulesI.erase(rule);
-                auto term = rule.substr(nontermJ.size());
+namespace
+{
+/*
+ * Right sides merged by common prefixes, one root per nonterminal. Children are
+ * found through one hash map and listed in insertion order, so building and
+ * walking the trie is linear in the total length of the rules
+ */
+class RuleTrie
+{
+public:
+    std::uint32_t addRoot()
+    {
+        nodes.push_back({noSymbol});
+        return static_cast<std::uint32_t>(nodes.size() - 1);
+    }
 
-                std::for_each(std::begin(rulesJ), std::end(rulesJ),
-                    [&](auto &&x) { rulesI.insert(x + term); });
+    void insert(std::uint32_t root, Rhs rule)
+    {
+        auto node = root;
+        for (auto &&symbol: rule)
+        {
+            auto key = (static_cast<std::uint64_t>(node) << 32) | symbol;
+            auto [it, inserted] = children.emplace(key, static_cast<std::uint32_t>(nodes.size()));
+            if (inserted)
+            {
+                nodes.push_back({symbol});
+                auto &parent = nodes[node];
+                (parent.firstChild == noIndex ? parent.firstChild : nodes[parent.lastChild].next) =
+                    it->second;
+                parent.lastChild = it->second;
             }
+            node = it->second;
         }
+        nodes[node].ends = true;
+    }
 
-        std::set<std::string> changedRules;
-        std::set<std::string> newNontermRules;
-        auto newNonterm = generateNewNonterm(newGrammar, nontermI);
+    // every branching node below the root becomes a new nonterminal, all levels in one walk
+    void factor(std::uint32_t root, SymbolId nonterm, GrammarShard &shard)
+    {
+        std::vector<std::pair<std::uint32_t, SymbolId>> pending = {{root, nonterm}};
+        Rule rule;
 
-        for (auto &&rule: rulesI)
+        while (!pending.empty())
         {
-            if (isRecursiveRule(rule, nontermI))
+            auto [node, lhs] = pending.back();
+            pending.pop_back();
+
+            if (nodes[node].ends)
             {
-                auto term = rule.substr(nontermI.size());
-                newNontermRules.insert({term + newNonterm, term});
+                shard.addProduction(lhs, Rule());
             }
-            else
+
+            for (auto child = nodes[node].firstChild; child != noIndex; child = nodes[child].next)
             {
-                changedRules.insert({rule + newNonterm, rule});
+                // a chain without branches is the common prefix
+                rule.assign(1, nodes[child].symbol);
+                auto last = child;
+                while (!nodes[last].ends && nodes[last].firstChild != noIndex &&
+                    nodes[last].firstChild == nodes[last].lastChild)
+                {
+                    last = nodes[last].firstChild;
+                    rule.push_back(nodes[last].symbol);
+                }
+
+                if (nodes[last].firstChild != noIndex)
+                {
+                    auto newNonterm = shard.fresh(nonterm);
+                    rule.push_back(newNonterm);
+                    pending.emplace_back(last, newNonterm);
+                }
+                shard.addProduction(lhs, rule);
             }
         }
+    }
+
+private:
+    struct Node
+    {
+        SymbolId symbol;
+        std::uint32_t firstChild = noIndex;
+        std::uint32_t lastChild = noIndex;
+        std::uint32_t next = noIndex;
+        bool ends = false;
+    };
+
+    std::vector<Node> nodes;
+    std::unordered_map<std::uint64_t, std::uint32_t> children;
+};
 
-        if (!newNontermRules.empty())
+// productions hashed by left and right side, looked up through the grammar as it grows
+struct ProductionHash
+{
+    const CompactGrammar *grammar;
+
+    size_t operator()(std::uint32_t i) const
+    {
+        const auto &production = grammar->productions[i];
+        std::uint64_t hash = 14695981039346656037ull ^ production.lhs;
+        for (auto &&symbol: grammar->getRhs(production))
         {
-            newGrammar[nontermI] = std::move(changedRules);
-            newGrammar[newNonterm] = std::move(newNontermRules);
+            hash = (hash ^ symbol) * 1099511628211ull;
         }
+        return static_cast<size_t>(hash);
     }
+};
 
-    return newGrammar;
+struct ProductionEqual
+{
+    const CompactGrammar *grammar;
+
+    bool operator()(std::uint32_t a, std::uint32_t b) const
+    {
+        const auto &x = grammar->productions[a];
+        const auto &y = grammar->productions[b];
+        auto rx = grammar->getRhs(x);
+        auto ry = grammar->getRhs(y);
+        return x.lhs == y.lhs && std::equal(rx.begin(), rx.end(), ry.begin(), ry.end());
+    }
+};
+}  // namespace
+
+Grammar eliminateLeftRecursion(const Grammar &grammar)
+{
+    return toGrammar(eliminateLeftRecursion(toCompactWithoutStart(grammar)));
 }
 
 Grammar leftFactoring(const Grammar &grammar)
+{
+    return toGrammar(leftFactoring(toCompactWithoutStart(grammar)));
+}
+
+CompactGrammar eliminateLeftRecursion(const CompactGrammar &grammar)
 {
     auto newGrammar = grammar;
+    eliminateLeftRecursionInPlace(newGrammar);
+    return newGrammar;
+}
+
+LeftRecursionStats eliminateLeftRecursionInPlace(CompactGrammar &grammar)
+{
+    grammar = removeUselessSymbols(std::move(grammar));
+    auto nullable = findEpsilonNonterms(grammar);
+    grammar = removeEpsilonNonterms(std::move(grammar), nullable);
+
+    std::vector<SymbolId> touched;
+    return substituteLeftRecursion(grammar, touched);
+}
+
+LeftRecursionStats substituteLeftRecursion(CompactGrammar &grammar, std::vector<SymbolId> &touched)
+{
+    LeftRecursionStats stats;
+    stats.productionsBefore = grammar.productions.size();
+
+    auto byLhs = grammar.groupByLhs();
+    std::vector<SymbolId> nonterms;
+    std::vector<std::uint32_t> order(grammar.symbols.size(), noIndex);
+    for (SymbolId id = 0; id < byLhs.size(); ++id)
+    {
+        if (!byLhs[id].empty())
+        {
+            order[id] = static_cast<std::uint32_t>(nonterms.size());
+            nonterms.push_back(id);
+        }
+    }
 
-    for (auto &&[nonterm, rules]: grammar)
+    // one set over every production, substituted copies of existing rules are dropped
+    std::unordered_set<std::uint32_t, ProductionHash, ProductionEqual> present(
+        grammar.productions.size() * 2, ProductionHash{&grammar}, ProductionEqual{&grammar});
+    std::vector<bool> dead(grammar.productions.size(), false);
+    for (std::uint32_t i = 0; i < grammar.productions.size(); ++i)
     {
-        if (rules.size() > 1)
+        present.insert(i);
+    }
+
+    // the arena may move on every add, right sides are copied out first
+    Rule rhs;
+    auto add = [&](SymbolId lhs) {
+        auto index = static_cast<std::uint32_t>(grammar.productions.size());
+        grammar.addProduction(lhs, rhs);
+        if (!present.insert(index).second)
+        {
+            grammar.productions.pop_back();
+            grammar.arena.resize(grammar.arena.size() - rhs.size());
+            return noIndex;
+        }
+
+        dead.push_back(false);
+        byLhs[lhs].push_back(index);
+        return index;
+    };
+    // every nonterminal whose rules change loses one of them
+    auto remove = [&](std::uint32_t i) {
+        touched.push_back(grammar.productions[i].lhs);
+        present.erase(i);
+        dead[i] = true;
+    };
+
+    // rules of nonterms[i] starting with an earlier nonterminal by its order, a rule
+    // substituted for the one of order j only starts with a later one or is left as is
+    using Pending = std::pair<std::uint32_t, std::uint32_t>;
+    std::priority_queue<Pending, std::vector<Pending>, std::greater<>> pending;
+    std::vector<std::uint32_t> batch;
+    std::vector<std::uint32_t> rules;
+
+    for (std::uint32_t i = 0, size = static_cast<std::uint32_t>(nonterms.size()); i < size; ++i)
+    {
+        auto nonterm = nonterms[i];
+        auto schedule = [&](std::uint32_t p, std::uint32_t after) {
+            auto rule = grammar.getRhs(grammar.productions[p]);
+            auto first = rule.size() > 1 ? order[rule[0]] : noIndex;
+            if (first < i && (after == noIndex || first > after))
+            {
+                pending.emplace(first, p);
+            }
+        };
+
+        for (auto &&p: byLhs[nonterm])
         {
-            for (auto &&prefix: findAllCommonPrefixes(rules))
+            schedule(p, noIndex);
+        }
+
+        while (!pending.empty())
+        {
+            auto j = pending.top().first;
+            batch.clear();
+            while (!pending.empty() && pending.top().first == j)
             {
-                auto newNonterm = generateNewNonterm(newGrammar, nonterm);
-                newGrammar[nonterm].insert(prefix + newNonterm);
+                batch.push_back(pending.top().second);
+                pending.pop();
+            }
 
-                for (auto &&rule: rules)
+            for (auto &&p: batch)
+            {
+                remove(p);
+                ++stats.substitutions;
+
+                for (auto &&q: byLhs[nonterms[j]])
                 {
-                    if (auto pos = rule.find(prefix); pos == 0)
+                    if (dead[q])
                     {
-                        auto expr = rule.substr(prefix.size());
-                        newGrammar[newNonterm].insert(expr.empty() ? epsilon : expr);
-                        newGrammar[nonterm].erase(rule);
+                        continue;
+                    }
+
+                    auto rule = grammar.getRhs(grammar.productions[q]);
+                    auto tail = grammar.getRhs(grammar.productions[p]);
+                    rhs.assign(rule.begin(), rule.end());
+                    rhs.insert(std::end(rhs), tail.begin() + 1, tail.end());
+
+                    if (auto index = add(nonterm); index != noIndex)
+                    {
+                        ++stats.substituted;
+                        schedule(index, j);
+                    }
+                    else
+                    {
+                        ++stats.duplicates;
                     }
                 }
             }
         }
+
+        auto isRecursive = [&](std::uint32_t p) {
+            auto rule = grammar.getRhs(grammar.productions[p]);
+            return rule.size() > 1 && rule[0] == nonterm;
+        };
+
+        rules.clear();
+        std::copy_if(std::begin(byLhs[nonterm]), std::end(byLhs[nonterm]),
+            std::back_inserter(rules), [&](auto &&p) { return !dead[p]; });
+        if (std::none_of(std::begin(rules), std::end(rules), isRecursive))
+        {
+            continue;
+        }
+
+        auto newNonterm = grammar.symbols.fresh(nonterm);
+        byLhs.resize(grammar.symbols.size());
+        order.resize(grammar.symbols.size(), noIndex);
+        ++stats.newNonterms;
+
+        for (auto &&p: rules)
+        {
+            auto rule = grammar.getRhs(grammar.productions[p]);
+            rhs.assign(rule.begin(), rule.end());
+            if (isRecursive(p))
+            {
+                remove(p);
+                rhs.erase(std::begin(rhs));
+                add(newNonterm);
+                rhs.push_back(newNonterm);
+                add(newNonterm);
+            }
+            else
+            {
+                rhs.push_back(newNonterm);
+                add(nonterm);
+            }
+        }
     }
 
+    std::vector<bool> keep(dead.size());
+    std::transform(std::begin(dead), std::end(dead), std::begin(keep), std::logical_not<>());
+    grammar.retain(keep);
+    grammar.normalize();
+
+    stats.productionsAfter = grammar.productions.size();
+    return stats;
+}
+
+CompactGrammar leftFactoring(const CompactGrammar &grammar, size_t threads)
+{
+    auto newGrammar = makeEmptyCopy(grammar);
+    auto byLhs = grammar.groupByLhs();
+
+    // one trie per range of nonterminals
+    runSharded(newGrammar, byLhs.size(), threads,
+        [&](GrammarShard &shard, size_t begin, size_t end) {
+            RuleTrie trie;
+            for (auto nonterm = static_cast<SymbolId>(begin); nonterm < end; ++nonterm)
+            {
+                if (byLhs[nonterm].empty())
+                {
+                    continue;
+                }
+
+                auto root = trie.addRoot();
+                for (auto &&i: byLhs[nonterm])
+                {
+                    trie.insert(root, grammar.getRhs(grammar.productions[i]));
+                }
+                trie.factor(root, nonterm, shard);
+            }
+        });
+
+    newGrammar.normalize();
     return newGrammar;
 }
@@ -4,3 +4,30 @@
 
 Grammar eliminateLeftRecursion(const Grammar &grammar);
 Grammar leftFactoring(const Grammar &grammar);
+
+CompactGrammar eliminateLeftRecursion(const CompactGrammar &grammar);
+
+// growth of the grammar during left recursion elimination
+struct LeftRecursionStats
+{
+    size_t productionsBefore = 0;  // once useless symbols and epsilon rules are gone
+    size_t productionsAfter = 0;
+    size_t substitutions = 0;  // rules A -> B x replaced by the rules of an earlier B
+    size_t substituted = 0;    // rules those substitutions added
+    size_t duplicates = 0;     // substituted rules that were already there
+    size_t newNonterms = 0;
+};
+
+/*
+ * The same elimination done on grammar itself: substituted rules are appended to
+ * its arena, deduplicated through one hash set over all productions, and replaced
+ * rules are dropped in a single compaction at the end
+ */
+LeftRecursionStats eliminateLeftRecursionInPlace(CompactGrammar &grammar);
+
+// the substitutions alone, grammar must be free of useless symbols and epsilon rules;
+// left sides whose rules changed go to touched, new nonterminals are not listed
+LeftRecursionStats substituteLeftRecursion(CompactGrammar &grammar, std::vector<SymbolId> &touched);
+
+// threads only change the speed, names of new nonterminals do not depend on them
+CompactGrammar leftFactoring(const CompactGrammar &grammar, size_t threads = 1);
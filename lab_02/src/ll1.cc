@@ -0,0 +1,250 @@
+#include "ll1.h"
+
+#include <iterator>
+#include <stdexcept>
+
+#include "analysis.h"
+#include "leftutils.h"
+
+Ll1Table::Ll1Table(CompactGrammar grammar)
+    : grammar(std::move(grammar)),
+      rows(this->grammar.symbols.size(), noColumn),
+      columns(this->grammar.symbols.size(), noColumn)
+{
+    const auto &symbols = this->grammar.symbols;
+    GrammarAnalysis analysis(this->grammar);
+
+    size_t rowCount = 0;
+    for (SymbolId id = 0; id < symbols.size(); ++id)
+    {
+        if (symbols.isNonterm(id))
+        {
+            rows[id] = rowCount++;
+        }
+        else
+        {
+            columns[id] = analysis.getTerminalIndex(id);
+        }
+    }
+
+    // analysis numbers terminals the same way and puts the end marker last
+    columnCount = analysis.getTerminalCount() + 1;
+    cells.assign(rowCount * columnCount, noProduction);
+
+    const auto &productions = this->grammar.productions;
+    for (std::uint32_t i = 0; i < productions.size(); ++i)
+    {
+        auto lhs = productions[i].lhs;
+        auto rhs = this->grammar.getRhs(productions[i]);
+
+        auto predict = analysis.getFirst(rhs);
+        if (analysis.isNullable(rhs))
+        {
+            predict.unite(analysis.getFollow(lhs));
+        }
+
+        predict.forEach([&](size_t column) {
+            auto &cell = cells[rows[lhs] * columnCount + column];
+            if (cell == noProduction)
+            {
+                cell = i;
+            }
+            else if (cell != i)
+            {
+                auto isEnd = column == analysis.getEndMarkerIndex();
+                auto terminal = isEnd ? noSymbol : analysis.getTerminal(column);
+                conflicts.push_back({lhs, terminal, cell, i});
+            }
+        });
+    }
+}
+
+std::uint32_t Ll1Table::getProduction(SymbolId nonterm, SymbolId terminal) const
+{
+    auto column = terminal == noSymbol ? getEndColumn() : getColumn(terminal);
+    return column == noColumn ? noProduction : getCell(nonterm, column);
+}
+
+std::uint32_t Ll1Table::getCell(SymbolId nonterm, size_t column) const
+{
+    return cells[rows[nonterm] * columnCount + column];
+}
+
+const std::vector<Ll1Conflict> &Ll1Table::getConflicts() const
+{
+    return conflicts;
+}
+
+bool Ll1Table::isLl1() const
+{
+    return conflicts.empty();
+}
+
+const CompactGrammar &Ll1Table::getGrammar() const
+{
+    return grammar;
+}
+
+size_t Ll1Table::getColumn(SymbolId terminal) const
+{
+    return terminal < columns.size() ? columns[terminal] : noColumn;
+}
+
+size_t Ll1Table::getEndColumn() const
+{
+    return columnCount - 1;
+}
+
+std::string Ll1Table::toString(const Ll1Conflict &conflict) const
+{
+    auto rule = [this](std::uint32_t i) {
+        auto rhs = grammar.getRhs(grammar.productions[i]);
+        return grammar.symbols.getName(grammar.productions[i].lhs) + " -> " +
+            (rhs.empty() ? epsilon : ::toString(grammar, rhs));
+    };
+
+    return grammar.symbols.getName(conflict.nonterm) + " on " +
+        (conflict.terminal == noSymbol ? endMarker : grammar.symbols.getName(conflict.terminal)) +
+        ": " + rule(conflict.kept) + " vs " + rule(conflict.dropped);
+}
+
+void Ll1Table::write(BinaryWriter &writer) const
+{
+    writeGrammar(writer, grammar);
+    writer.writeIndices(rows);
+    writer.writeIndices(columns);
+    writer.writeVarint(columnCount);
+    writer.writeIndices(cells);
+
+    writer.writeVarint(conflicts.size());
+    for (auto &&conflict: conflicts)
+    {
+        writer.writeVarint(conflict.nonterm);
+        writer.writeIndex(conflict.terminal);
+        writer.writeVarint(conflict.kept);
+        writer.writeVarint(conflict.dropped);
+    }
+}
+
+Ll1Table Ll1Table::read(BinaryReader &reader)
+{
+    auto check = [](bool condition) {
+        if (!condition)
+        {
+            throw std::runtime_error("Ll1Table::read: inconsistent table");
+        }
+    };
+
+    Ll1Table table;
+    table.grammar = readGrammar(reader);
+    table.rows = reader.readIndices<size_t>();
+    table.columns = reader.readIndices<size_t>();
+    table.columnCount = static_cast<size_t>(reader.readVarint());
+    table.cells = reader.readIndices<std::uint32_t>();
+
+    auto symbolCount = table.grammar.symbols.size();
+    auto productionCount = table.grammar.productions.size();
+    check(table.rows.size() == symbolCount && table.columns.size() == symbolCount);
+    check(table.columnCount > 0 && table.cells.size() % table.columnCount == 0);
+    for (auto &&row: table.rows)
+    {
+        check(row == noColumn || row < table.cells.size() / table.columnCount);
+    }
+    for (auto &&column: table.columns)
+    {
+        check(column == noColumn || column < table.columnCount);
+    }
+    for (auto &&cell: table.cells)
+    {
+        check(cell == noProduction || cell < productionCount);
+    }
+
+    for (auto count = reader.readCount(); count > 0; --count)
+    {
+        auto &conflict = table.conflicts.emplace_back();
+        conflict.nonterm = static_cast<SymbolId>(reader.readVarint());
+        conflict.terminal = reader.readIndex<SymbolId>();
+        conflict.kept = static_cast<std::uint32_t>(reader.readVarint());
+        conflict.dropped = static_cast<std::uint32_t>(reader.readVarint());
+        check(conflict.nonterm < symbolCount &&
+            (conflict.terminal == noSymbol || conflict.terminal < symbolCount) &&
+            conflict.kept < productionCount && conflict.dropped < productionCount);
+    }
+    return table;
+}
+
+Ll1Table makeLl1Table(const Grammar &grammar, std::string_view start)
+{
+    return Ll1Table(leftFactoring(eliminateLeftRecursion(toCompact(grammar, start))));
+}
+
+Ll1Parser::Ll1Parser(const Ll1Table &table) : table(table)
+{
+    if (!table.isLl1())
+    {
+        throw std::invalid_argument("Ll1Parser: " + table.toString(table.getConflicts().front()));
+    }
+}
+
+ParseResult Ll1Parser::parse(std::string_view input)
+{
+    return parse(tokenize(table.getGrammar(), input));
+}
+
+ParseResult Ll1Parser::parse(const std::vector<SymbolId> &tokens)
+{
+    const auto &grammar = table.getGrammar();
+    ParseResult result;
+
+    if (grammar.start == noSymbol)
+    {
+        return result;
+    }
+
+    // noSymbol at the bottom stands for the end marker
+    stack.clear();
+    stack.push_back(noSymbol);
+    stack.push_back(grammar.start);
+
+    size_t pos = 0;
+    while (true)
+    {
+        auto top = stack.back();
+        auto column = pos == tokens.size() ? table.getEndColumn() : table.getColumn(tokens[pos]);
+        result.errorPosition = pos;
+
+        if (column == Ll1Table::noColumn)
+        {
+            return result;
+        }
+
+        if (top == noSymbol)
+        {
+            result.accepted = pos == tokens.size();
+            return result;
+        }
+
+        if (!grammar.symbols.isNonterm(top))
+        {
+            if (pos == tokens.size() || top != tokens[pos])
+            {
+                return result;
+            }
+            stack.pop_back();
+            ++pos;
+            continue;
+        }
+
+        auto production = table.getCell(top, column);
+        if (production == noProduction)
+        {
+            return result;
+        }
+
+        stack.pop_back();
+        auto rhs = grammar.getRhs(grammar.productions[production]);
+        stack.insert(std::end(stack), std::make_reverse_iterator(rhs.end()),
+            std::make_reverse_iterator(rhs.begin()));
+        result.derivation.push_back(production);
+    }
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "binaryio.h"
+#include "compactgrammar.h"
+#include "parseresult.h"
+#include "utils.h"
+
+inline constexpr std::uint32_t noProduction = static_cast<std::uint32_t>(-1);
+
+// two productions that both predict nonterm on the same lookahead terminal
+struct Ll1Conflict
+{
+    SymbolId nonterm;
+    SymbolId terminal;  // noSymbol for the end marker
+    std::uint32_t kept;
+    std::uint32_t dropped;
+};
+
+/*
+ * Predictive parse table: one row per nonterminal, one column per terminal plus
+ * the end marker, every cell holds a production index or noProduction.
+ * On a conflict the production that comes first wins and the conflict is recorded
+ */
+class Ll1Table
+{
+public:
+    explicit Ll1Table(CompactGrammar grammar);
+
+    // terminal noSymbol looks up the end marker column
+    std::uint32_t getProduction(SymbolId nonterm, SymbolId terminal) const;
+    const std::vector<Ll1Conflict> &getConflicts() const;
+    bool isLl1() const;
+
+    const CompactGrammar &getGrammar() const;
+
+    // column of a terminal, noColumn for anything the grammar does not know
+    size_t getColumn(SymbolId terminal) const;
+    size_t getEndColumn() const;
+    std::uint32_t getCell(SymbolId nonterm, size_t column) const;
+
+    std::string toString(const Ll1Conflict &conflict) const;
+
+    // read throws std::runtime_error on data that is not a table
+    void write(BinaryWriter &writer) const;
+    static Ll1Table read(BinaryReader &reader);
+
+    static constexpr size_t noColumn = static_cast<size_t>(-1);
+
+private:
+    Ll1Table() = default;
+
+private:
+    CompactGrammar grammar;
+
+    std::vector<size_t> rows;
+    std::vector<size_t> columns;
+    size_t columnCount = 0;
+
+    std::vector<std::uint32_t> cells;
+    std::vector<Ll1Conflict> conflicts;
+};
+
+// removes left recursion, factors the result and builds its table
+Ll1Table makeLl1Table(const Grammar &grammar, std::string_view start = "S");
+
+/*
+ * Table driven parser with an explicit stack, O(n) in the number of tokens.
+ * Works on any token stream of terminal ids. A table with conflicts may come
+ * from a left recursive grammar the parser would never finish on, so it is
+ * rejected with std::invalid_argument
+ */
+class Ll1Parser
+{
+public:
+    explicit Ll1Parser(const Ll1Table &table);
+
+    // derivation holds the productions of the leftmost derivation
+    ParseResult parse(const std::vector<SymbolId> &tokens);
+    ParseResult parse(std::string_view input);
+
+private:
+    const Ll1Table &table;
+
+    // kept between calls so repeated parses do not allocate
+    std::vector<SymbolId> stack;
+};
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+inline size_t defaultThreads()
+{
+    return std::max<size_t>(std::thread::hardware_concurrency(), 1);
+}
+
+/*
+ * Calls f(i) for every i in [0, count) on up to threads threads, the calling
+ * thread included. Indices are handed out one at a time, f must not throw
+ */
+template<typename F>
+void parallelFor(size_t count, size_t threads, F &&f)
+{
+    threads = std::min(std::max<size_t>(threads, 1), count);
+    if (threads <= 1)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            f(i);
+        }
+        return;
+    }
+
+    std::atomic<size_t> next{0};
+    auto worker = [&] {
+        for (size_t i; (i = next.fetch_add(1, std::memory_order_relaxed)) < count;)
+        {
+            f(i);
+        }
+    };
+
+    std::vector<std::thread> pool;
+    pool.reserve(threads - 1);
+    for (size_t i = 1; i < threads; ++i)
+    {
+        pool.emplace_back(worker);
+    }
+    worker();
+
+    for (auto &thread: pool)
+    {
+        thread.join();
+    }
+}
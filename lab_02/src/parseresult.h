@@ -0,0 +1,11 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+struct ParseResult
+{
+    bool accepted = false;
+    size_t errorPosition = 0;  // token the parser stopped at if not accepted
+    std::vector<std::uint32_t> derivation;
+};
@@ -0,0 +1,357 @@
+#include "passmanager.h"
+
+#include <algorithm>
+
+#include "chomskyutils.h"
+#include "leftutils.h"
+
+static constexpr std::uint32_t noIndex = static_cast<std::uint32_t>(-1);
+
+PassManager::PassManager(CompactGrammar grammar) : grammar(std::move(grammar))
+{
+    invalidateAll();
+}
+
+PassManager &PassManager::run(const Pass &pass)
+{
+    std::vector<SymbolId> touched;
+    pass(*this, grammar, touched);
+    invalidate(touched);
+    return *this;
+}
+
+PassManager &PassManager::run(CompactGrammar (*pass)(const CompactGrammar &))
+{
+    grammar = pass(grammar);
+    invalidateAll();
+    return *this;
+}
+
+PassManager &PassManager::removeUselessSymbols()
+{
+    std::vector<SymbolId> touched;
+    std::vector<bool> keep(grammar.productions.size());
+
+    auto generating = findGeneratingSymbols(grammar);
+    for (size_t i = 0; i < keep.size(); ++i)
+    {
+        auto rhs = grammar.getRhs(grammar.productions[i]);
+        keep[i] = generating[grammar.productions[i].lhs] &&
+            std::all_of(rhs.begin(), rhs.end(), [&](auto &&symbol) { return generating[symbol]; });
+    }
+    filter(keep, touched);
+    invalidate(touched);
+
+    if (grammar.start == noSymbol)
+    {
+        return *this;
+    }
+
+    touched.clear();
+    keep.resize(grammar.productions.size());
+    const auto &reachable = getReachable();
+    for (size_t i = 0; i < keep.size(); ++i)
+    {
+        keep[i] = reachable[grammar.productions[i].lhs];
+    }
+    filter(keep, touched);
+    invalidate(touched);
+    return *this;
+}
+
+PassManager &PassManager::removeEpsilonNonterms()
+{
+    const auto &nullable = getNullable();
+
+    // rules without nullable symbols come out the same
+    std::vector<SymbolId> touched;
+    for (auto &&production: grammar.productions)
+    {
+        auto rhs = grammar.getRhs(production);
+        if (rhs.empty() ||
+            std::any_of(rhs.begin(), rhs.end(), [&](auto &&symbol) { return nullable[symbol]; }))
+        {
+            touched.push_back(production.lhs);
+        }
+    }
+
+    // checked before the grammar is moved into the pass, it is lost if the pass throws
+    checkEpsilonExpansion(grammar, nullable);
+    grammar = ::removeEpsilonNonterms(std::move(grammar), nullable);
+    invalidate(touched);
+    return *this;
+}
+
+PassManager &PassManager::deleteLongRules()
+{
+    removeUselessSymbols();
+
+    // short rules are copied as they are, new nonterminals come after the known ones
+    std::vector<SymbolId> touched;
+    for (auto &&production: grammar.productions)
+    {
+        if (production.size > longRuleSize)
+        {
+            touched.push_back(production.lhs);
+        }
+    }
+
+    grammar = ::deleteLongRules(grammar);
+    invalidate(touched);
+    return *this;
+}
+
+PassManager &PassManager::eliminateLeftRecursion()
+{
+    removeUselessSymbols().removeEpsilonNonterms();
+    return run([](PassManager &, CompactGrammar &grammar, std::vector<SymbolId> &touched) {
+        substituteLeftRecursion(grammar, touched);
+    });
+}
+
+const std::vector<bool> &PassManager::getNullable()
+{
+    update();
+    return nullable;
+}
+
+const std::vector<bool> &PassManager::getReachable()
+{
+    if (!reachableValid)
+    {
+        reachable = findReachableSymbols(grammar);
+        reachableValid = true;
+    }
+    return reachable;
+}
+
+const Bitset &PassManager::getFirst(SymbolId nonterm)
+{
+    update();
+    return first[nonterm];
+}
+
+std::uint32_t PassManager::getTerminalIndex(SymbolId terminal)
+{
+    update();
+    return terminals[terminal];
+}
+
+const CompactGrammar &PassManager::getGrammar() const
+{
+    return grammar;
+}
+
+CompactGrammar PassManager::release()
+{
+    auto result = std::move(grammar);
+    grammar = CompactGrammar();
+    invalidateAll();
+    return result;
+}
+
+size_t PassManager::getRecomputedCount() const
+{
+    return recomputed;
+}
+
+void PassManager::invalidate(const std::vector<SymbolId> &touched)
+{
+    indexed = false;
+    reachableValid = false;
+
+    // facts of a nonterminal depend on the ones its rules mention, so users go stale too;
+    // symbols created by the pass are picked up by update()
+    auto pending = touched;
+    while (!pending.empty())
+    {
+        auto nonterm = pending.back();
+        pending.pop_back();
+
+        if (nonterm >= isStale.size() || isStale[nonterm])
+        {
+            continue;
+        }
+
+        isStale[nonterm] = true;
+        stale.push_back(nonterm);
+        pending.insert(std::end(pending), std::begin(users[nonterm]), std::end(users[nonterm]));
+    }
+}
+
+void PassManager::invalidateAll()
+{
+    indexed = false;
+    reachableValid = false;
+
+    // with no symbols known every one is new to update()
+    users.clear();
+    terminals.clear();
+    terminalCount = 0;
+    stale.clear();
+    isStale.clear();
+    nullable.clear();
+    first.clear();
+}
+
+void PassManager::update()
+{
+    const auto &symbols = grammar.symbols;
+    if (!indexed)
+    {
+        byLhs = grammar.groupByLhs();
+        indexed = true;
+    }
+
+    if (terminals.size() < symbols.size())
+    {
+        auto known = static_cast<SymbolId>(terminals.size());
+        bool newTerminals = false;
+        for (auto id = known; id < symbols.size(); ++id)
+        {
+            terminals.push_back(symbols.isNonterm(id) ? noIndex : terminalCount++);
+            newTerminals = newTerminals || !symbols.isNonterm(id);
+        }
+
+        users.resize(symbols.size());
+        isStale.resize(symbols.size(), false);
+        nullable.resize(symbols.size(), false);
+        first.resize(symbols.size());
+
+        // a new terminal widens every FIRST set
+        for (auto id = newTerminals ? 0 : known; id < symbols.size(); ++id)
+        {
+            if (symbols.isNonterm(id) && !isStale[id])
+            {
+                isStale[id] = true;
+                stale.push_back(id);
+            }
+        }
+    }
+
+    if (stale.empty())
+    {
+        return;
+    }
+
+    for (auto &&nonterm: stale)
+    {
+        nullable[nonterm] = false;
+        first[nonterm] = Bitset(terminalCount);
+
+        for (auto &&i: byLhs[nonterm])
+        {
+            for (auto &&symbol: grammar.getRhs(grammar.productions[i]))
+            {
+                auto &symbolUsers = users[symbol];
+                if (symbols.isNonterm(symbol) &&
+                    (symbolUsers.empty() || symbolUsers.back() != nonterm))
+                {
+                    symbolUsers.push_back(nonterm);
+                }
+            }
+        }
+    }
+
+    // facts only grow from here, every stale nonterminal is revisited when one it uses grows
+    auto pending = stale;
+    while (!pending.empty())
+    {
+        auto nonterm = pending.back();
+        pending.pop_back();
+
+        if (nullable[nonterm])
+        {
+            continue;
+        }
+
+        for (auto &&i: byLhs[nonterm])
+        {
+            auto rhs = grammar.getRhs(grammar.productions[i]);
+            if (std::all_of(
+                    rhs.begin(), rhs.end(), [&](auto &&symbol) { return nullable[symbol]; }))
+            {
+                nullable[nonterm] = true;
+                break;
+            }
+        }
+
+        if (nullable[nonterm])
+        {
+            for (auto &&user: users[nonterm])
+            {
+                if (isStale[user] && !nullable[user])
+                {
+                    pending.push_back(user);
+                }
+            }
+        }
+    }
+
+    std::vector<bool> queued(symbols.size(), false);
+    pending = stale;
+    for (auto &&nonterm: pending)
+    {
+        queued[nonterm] = true;
+    }
+
+    while (!pending.empty())
+    {
+        auto nonterm = pending.back();
+        pending.pop_back();
+        queued[nonterm] = false;
+
+        bool changed = false;
+        for (auto &&i: byLhs[nonterm])
+        {
+            for (auto &&symbol: grammar.getRhs(grammar.productions[i]))
+            {
+                if (!symbols.isNonterm(symbol))
+                {
+                    changed = changed || !first[nonterm].test(terminals[symbol]);
+                    first[nonterm].set(terminals[symbol]);
+                    break;
+                }
+                if (symbol != nonterm)
+                {
+                    changed = first[nonterm].unite(first[symbol]) || changed;
+                }
+                if (!nullable[symbol])
+                {
+                    break;
+                }
+            }
+        }
+
+        if (changed)
+        {
+            for (auto &&user: users[nonterm])
+            {
+                if (isStale[user] && !queued[user])
+                {
+                    queued[user] = true;
+                    pending.push_back(user);
+                }
+            }
+        }
+    }
+
+    recomputed += stale.size();
+    for (auto &&nonterm: stale)
+    {
+        isStale[nonterm] = false;
+    }
+    stale.clear();
+}
+
+void PassManager::filter(const std::vector<bool> &keep, std::vector<SymbolId> &touched)
+{
+    for (size_t i = 0; i < grammar.productions.size(); ++i)
+    {
+        if (!keep[i])
+        {
+            touched.push_back(grammar.productions[i].lhs);
+        }
+    }
+    grammar.retain(keep);
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "bitset.h"
+#include "compactgrammar.h"
+
+/*
+ * Runs grammar passes one after another on a grammar it owns, so nothing is copied
+ * between them. Nullable flags and FIRST sets are cached per nonterminal: a pass
+ * lists the nonterminals whose productions it changed and only those, plus the
+ * ones whose rules mention them (transitively), are recomputed on the next query.
+ * Reachability is one linear walk and is recomputed whole after any change
+ */
+class PassManager
+{
+public:
+    // a pass edits the grammar in place and appends the nonterminals it changed to touched,
+    // nonterminals it creates count as changed without being listed
+    using Pass = std::function<void(
+        PassManager &manager, CompactGrammar &grammar, std::vector<SymbolId> &touched)>;
+
+    explicit PassManager(CompactGrammar grammar);
+
+    PassManager &run(const Pass &pass);
+
+    // a pass of the copying API, every cached analysis is dropped
+    PassManager &run(CompactGrammar (*pass)(const CompactGrammar &));
+
+    // in place versions of the passes in utils.h, fed from the cache; a pass that throws
+    // leaves the grammar as it was
+    PassManager &removeUselessSymbols();
+    PassManager &removeEpsilonNonterms();
+
+    // the passes of chomskyutils.h and leftutils.h, useless symbols and epsilon rules
+    // are removed through the two above so their cached flags are not computed again
+    PassManager &deleteLongRules();
+    PassManager &eliminateLeftRecursion();
+
+    // indexed by symbol id
+    const std::vector<bool> &getNullable();
+    const std::vector<bool> &getReachable();
+
+    // FIRST of a nonterminal, bits are terminal indices
+    const Bitset &getFirst(SymbolId nonterm);
+    std::uint32_t getTerminalIndex(SymbolId terminal);
+
+    const CompactGrammar &getGrammar() const;
+    CompactGrammar release();
+
+    // nonterminals whose nullable flag and FIRST set were computed, repeats included
+    size_t getRecomputedCount() const;
+
+private:
+    void invalidate(const std::vector<SymbolId> &touched);
+    void invalidateAll();
+    void update();
+
+    // keeps the productions with keep set, left sides of the others go to touched
+    void filter(const std::vector<bool> &keep, std::vector<SymbolId> &touched);
+
+private:
+    CompactGrammar grammar;
+
+    // production indices by left side, rebuilt after every pass
+    std::vector<std::vector<std::uint32_t>> byLhs;
+    bool indexed = false;
+
+    // nonterminals mentioning a symbol on a right side, may hold stale entries
+    std::vector<std::vector<SymbolId>> users;
+
+    std::vector<std::uint32_t> terminals;  // terminal index by symbol id
+    size_t terminalCount = 0;
+
+    std::vector<SymbolId> stale;
+    std::vector<bool> isStale;
+    std::vector<bool> nullable;
+    std::vector<Bitset> first;
+
+    std::vector<bool> reachable;
+    bool reachableValid = false;
+
+    size_t recomputed = 0;
+};
@@ -0,0 +1,622 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "compactgrammar.h"
+
+/*
+ * Grammars known at compile time. Everything here is constexpr and lives in fixed
+ * size arrays, so a grammar, its analyses and its LL(1) table can be
+ * static constexpr objects built by the compiler with no heap and no startup work:
+ *
+ *     static constexpr auto table = StaticLl1Table(
+ *         eliminateStaticLeftRecursion(parseStaticGrammar("E -> E+T | T; ...")));
+ *     static_assert(table.isLl1() && table.accepts("i+i"));
+ *
+ * Symbols are single characters as in Grammar, nonterminals made by a pass are
+ * named after their base with primes. Running out of capacity or bad input
+ * throws, which at compile time is a compile error
+ */
+
+using StaticSymbol = std::uint8_t;
+
+inline constexpr StaticSymbol noStaticSymbol = static_cast<StaticSymbol>(-1);
+inline constexpr std::uint16_t noStaticProduction = static_cast<std::uint16_t>(-1);
+
+struct StaticSymbolInfo
+{
+    char name = 0;
+    std::uint8_t primes = 0;
+    bool nonterm = false;
+};
+
+struct StaticProduction
+{
+    StaticSymbol lhs = noStaticSymbol;
+    std::uint16_t begin = 0;  // offset of the right side in arena
+    std::uint16_t size = 0;
+};
+
+// sets of symbols are 64 bit masks, bit 63 stands for the end marker
+template<size_t MaxSymbols = 63, size_t MaxProductions = 128, size_t MaxArena = 512>
+struct StaticGrammar
+{
+    static_assert(MaxSymbols < 64, "StaticGrammar: symbol sets are 64 bit masks");
+    static_assert(MaxProductions < noStaticProduction && MaxArena <= noStaticProduction,
+        "StaticGrammar: productions are indexed by 16 bits");
+
+    static constexpr size_t maxSymbols = MaxSymbols;
+    static constexpr size_t maxProductions = MaxProductions;
+    static constexpr size_t maxArena = MaxArena;
+
+    std::array<StaticSymbolInfo, MaxSymbols> symbols{};
+    size_t symbolCount = 0;
+    StaticSymbol start = noStaticSymbol;
+
+    std::array<StaticProduction, MaxProductions> productions{};
+    size_t productionCount = 0;
+    std::array<StaticSymbol, MaxArena> arena{};
+    size_t arenaSize = 0;
+
+    constexpr StaticSymbol find(char name, std::uint8_t primes = 0) const
+    {
+        for (size_t i = 0; i < symbolCount; ++i)
+        {
+            if (symbols[i].name == name && symbols[i].primes == primes)
+            {
+                return static_cast<StaticSymbol>(i);
+            }
+        }
+        return noStaticSymbol;
+    }
+
+    constexpr StaticSymbol intern(char name, bool nonterm, std::uint8_t primes = 0)
+    {
+        if (auto symbol = find(name, primes); symbol != noStaticSymbol)
+        {
+            return symbol;
+        }
+        if (symbolCount == MaxSymbols)
+        {
+            throw std::length_error("StaticGrammar: too many symbols");
+        }
+
+        symbols[symbolCount] = {name, primes, nonterm};
+        return static_cast<StaticSymbol>(symbolCount++);
+    }
+
+    // new nonterminal with one prime more than any symbol named as base
+    constexpr StaticSymbol fresh(StaticSymbol base)
+    {
+        std::uint8_t primes = 0;
+        for (size_t i = 0; i < symbolCount; ++i)
+        {
+            if (symbols[i].name == symbols[base].name && symbols[i].primes >= primes)
+            {
+                primes = static_cast<std::uint8_t>(symbols[i].primes + 1);
+            }
+        }
+        return intern(symbols[base].name, true, primes);
+    }
+
+    constexpr bool isNonterm(StaticSymbol symbol) const
+    {
+        return symbols[symbol].nonterm;
+    }
+
+    constexpr void addProduction(StaticSymbol lhs, const StaticSymbol *rhs, size_t size)
+    {
+        if (productionCount == MaxProductions || arenaSize + size > MaxArena)
+        {
+            throw std::length_error("StaticGrammar: too many productions");
+        }
+
+        productions[productionCount++] = {lhs,
+            static_cast<std::uint16_t>(arenaSize), static_cast<std::uint16_t>(size)};
+        for (size_t i = 0; i < size; ++i)
+        {
+            arena[arenaSize++] = rhs[i];
+        }
+    }
+
+    // symbol i of the right side of a production
+    constexpr StaticSymbol at(size_t production, size_t i) const
+    {
+        return arena[productions[production].begin + i];
+    }
+
+    constexpr size_t size(size_t production) const
+    {
+        return productions[production].size;
+    }
+
+    constexpr bool hasProduction(StaticSymbol lhs, const StaticSymbol *rhs, size_t size) const
+    {
+        for (size_t p = 0; p < productionCount; ++p)
+        {
+            bool equal = productions[p].lhs == lhs && productions[p].size == size;
+            for (size_t i = 0; equal && i < size; ++i)
+            {
+                equal = at(p, i) == rhs[i];
+            }
+            if (equal)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // same symbols and start, no productions
+    constexpr StaticGrammar emptyCopy() const
+    {
+        StaticGrammar copy;
+        copy.symbols = symbols;
+        copy.symbolCount = symbolCount;
+        copy.start = start;
+        return copy;
+    }
+};
+
+/*
+ * Rules as in "E -> E+T | T; F -> (E) | i", separated by ';' or new lines.
+ * Spaces are ignored, every character with a rule is a nonterminal, '?' is epsilon
+ * and the first left side is the start symbol.
+ * Throws std::invalid_argument on a rule without "->"
+ */
+template<size_t MaxSymbols = 63, size_t MaxProductions = 128, size_t MaxArena = 512>
+constexpr StaticGrammar<MaxSymbols, MaxProductions, MaxArena> parseStaticGrammar(
+    std::string_view text)
+{
+    StaticGrammar<MaxSymbols, MaxProductions, MaxArena> grammar;
+    auto isSpace = [](char c) { return c == ' ' || c == '\t' || c == '\r'; };
+    auto isEnd = [](char c) { return c == ';' || c == '\n'; };
+
+    // left sides first, so a nonterminal used before its rule is known as one
+    for (size_t pass = 0; pass < 2; ++pass)
+    {
+        size_t i = 0;
+        while (i < text.size())
+        {
+            while (i < text.size() && (isSpace(text[i]) || isEnd(text[i])))
+            {
+                ++i;
+            }
+            if (i == text.size())
+            {
+                break;
+            }
+
+            auto lhs = grammar.intern(text[i++], true);
+            grammar.start = grammar.start == noStaticSymbol ? lhs : grammar.start;
+
+            while (i < text.size() && isSpace(text[i]))
+            {
+                ++i;
+            }
+            if (i + 1 >= text.size() || text[i] != '-' || text[i + 1] != '>')
+            {
+                throw std::invalid_argument("parseStaticGrammar: expected \"->\"");
+            }
+            i += 2;
+
+            std::array<StaticSymbol, MaxArena> rhs{};
+            size_t size = 0;
+            for (; i <= text.size(); ++i)
+            {
+                if (i == text.size() || isEnd(text[i]) || text[i] == '|')
+                {
+                    if (pass == 1)
+                    {
+                        grammar.addProduction(lhs, rhs.data(), size);
+                    }
+                    size = 0;
+                    if (i == text.size() || isEnd(text[i]))
+                    {
+                        break;
+                    }
+                }
+                else if (!isSpace(text[i]) && text[i] != '?' && pass == 1)
+                {
+                    if (size == MaxArena)
+                    {
+                        throw std::length_error("parseStaticGrammar: rule is too long");
+                    }
+                    rhs[size++] = grammar.intern(text[i], false);
+                }
+            }
+        }
+    }
+    return grammar;
+}
+
+/*
+ * Nullable flags, FIRST and FOLLOW sets by fixed point iteration. FIRST of a terminal
+ * is its own bit, FOLLOW of the start symbol holds the end marker
+ */
+template<typename GrammarType>
+struct StaticAnalysis
+{
+    static constexpr size_t endMarker = 63;
+
+    std::array<bool, GrammarType::maxSymbols> nullable{};
+    std::array<std::uint64_t, GrammarType::maxSymbols> first{};
+    std::array<std::uint64_t, GrammarType::maxSymbols> follow{};
+
+    constexpr explicit StaticAnalysis(const GrammarType &grammar)
+    {
+        for (size_t symbol = 0; symbol < grammar.symbolCount; ++symbol)
+        {
+            first[symbol] = grammar.isNonterm(static_cast<StaticSymbol>(symbol))
+                ? 0
+                : std::uint64_t(1) << symbol;
+        }
+
+        for (bool changed = true; changed;)
+        {
+            changed = false;
+            for (size_t p = 0; p < grammar.productionCount; ++p)
+            {
+                auto lhs = grammar.productions[p].lhs;
+                auto added = firstOf(grammar, p, 0) & ~first[lhs];
+                auto becomesNullable = !nullable[lhs] && isNullable(grammar, p, 0);
+                first[lhs] |= added;
+                nullable[lhs] = nullable[lhs] || becomesNullable;
+                changed = changed || added != 0 || becomesNullable;
+            }
+        }
+
+        if (grammar.start != noStaticSymbol)
+        {
+            follow[grammar.start] = std::uint64_t(1) << endMarker;
+        }
+        for (bool changed = true; changed;)
+        {
+            changed = false;
+            for (size_t p = 0; p < grammar.productionCount; ++p)
+            {
+                auto lhs = grammar.productions[p].lhs;
+                for (size_t i = 0; i < grammar.size(p); ++i)
+                {
+                    auto symbol = grammar.at(p, i);
+                    if (!grammar.isNonterm(symbol))
+                    {
+                        continue;
+                    }
+
+                    auto set = firstOf(grammar, p, i + 1) |
+                        (isNullable(grammar, p, i + 1) ? follow[lhs] : 0);
+                    changed = changed || (set & ~follow[symbol]) != 0;
+                    follow[symbol] |= set;
+                }
+            }
+        }
+    }
+
+    // FIRST and nullability of the right side of a production from symbol from on
+    constexpr std::uint64_t firstOf(
+        const GrammarType &grammar, size_t production, size_t from) const
+    {
+        std::uint64_t set = 0;
+        for (auto i = from; i < grammar.size(production); ++i)
+        {
+            auto symbol = grammar.at(production, i);
+            set |= first[symbol];
+            if (!nullable[symbol])
+            {
+                break;
+            }
+        }
+        return set;
+    }
+
+    constexpr bool isNullable(const GrammarType &grammar, size_t production, size_t from) const
+    {
+        for (auto i = from; i < grammar.size(production); ++i)
+        {
+            if (!nullable[grammar.at(production, i)])
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+/*
+ * Every production with nullable symbols becomes all its versions with some of
+ * them left out, epsilon rules go except one for a nullable start symbol
+ */
+template<typename GrammarType>
+constexpr GrammarType removeStaticEpsilonRules(const GrammarType &grammar)
+{
+    StaticAnalysis<GrammarType> analysis(grammar);
+    auto result = grammar.emptyCopy();
+
+    for (size_t p = 0; p < grammar.productionCount; ++p)
+    {
+        std::array<size_t, 64> positions{};
+        size_t count = 0;
+        for (size_t i = 0; i < grammar.size(p); ++i)
+        {
+            if (analysis.nullable[grammar.at(p, i)])
+            {
+                if (count == 16)
+                {
+                    throw std::length_error("removeStaticEpsilonRules: too many nullable symbols");
+                }
+                positions[count++] = i;
+            }
+        }
+
+        for (std::uint32_t mask = 0; mask < (std::uint32_t(1) << count); ++mask)
+        {
+            std::array<StaticSymbol, GrammarType::maxArena> rhs{};
+            size_t size = 0;
+            for (size_t i = 0, k = 0; i < grammar.size(p); ++i)
+            {
+                bool dropped = k < count && positions[k] == i && (mask >> k++ & 1);
+                if (!dropped)
+                {
+                    rhs[size++] = grammar.at(p, i);
+                }
+            }
+
+            auto lhs = grammar.productions[p].lhs;
+            if (size > 0 && !result.hasProduction(lhs, rhs.data(), size))
+            {
+                result.addProduction(lhs, rhs.data(), size);
+            }
+        }
+    }
+
+    if (grammar.start != noStaticSymbol && analysis.nullable[grammar.start])
+    {
+        result.addProduction(grammar.start, nullptr, 0);
+    }
+    return result;
+}
+
+/*
+ * Paull's algorithm on the epsilon free grammar: nonterminals in id order, rules of
+ * Ai starting with an earlier Aj get the rules of Aj substituted, then direct
+ * recursion Ai -> Ai a | b becomes Ai -> b Ai', Ai' -> a Ai' | ?
+ */
+template<typename GrammarType>
+constexpr GrammarType eliminateStaticLeftRecursion(const GrammarType &input)
+{
+    auto grammar = removeStaticEpsilonRules(input);
+    std::array<bool, GrammarType::maxProductions> dead{};
+
+    auto copyRhs = [&](auto &rhs, size_t size, size_t production, size_t from) {
+        for (auto i = from; i < grammar.size(production); ++i)
+        {
+            if (size == GrammarType::maxArena)
+            {
+                throw std::length_error("eliminateStaticLeftRecursion: rule is too long");
+            }
+            rhs[size++] = grammar.at(production, i);
+        }
+        return size;
+    };
+
+    auto nontermCount = grammar.symbolCount;
+    for (size_t i = 0; i < nontermCount; ++i)
+    {
+        auto nonterm = static_cast<StaticSymbol>(i);
+        if (!grammar.isNonterm(nonterm))
+        {
+            continue;
+        }
+
+        for (size_t j = 0; j < i; ++j)
+        {
+            auto earlier = static_cast<StaticSymbol>(j);
+            for (size_t p = 0, count = grammar.productionCount; p < count; ++p)
+            {
+                if (dead[p] || grammar.productions[p].lhs != nonterm || grammar.size(p) == 0 ||
+                    grammar.at(p, 0) != earlier)
+                {
+                    continue;
+                }
+
+                dead[p] = true;
+                for (size_t q = 0; q < count; ++q)
+                {
+                    if (!dead[q] && grammar.productions[q].lhs == earlier)
+                    {
+                        std::array<StaticSymbol, GrammarType::maxArena> rhs{};
+                        auto size = copyRhs(rhs, copyRhs(rhs, 0, q, 0), p, 1);
+                        grammar.addProduction(nonterm, rhs.data(), size);
+                    }
+                }
+            }
+        }
+
+        bool recursive = false;
+        for (size_t p = 0; p < grammar.productionCount; ++p)
+        {
+            recursive = recursive || (!dead[p] && grammar.productions[p].lhs == nonterm &&
+                grammar.size(p) > 0 && grammar.at(p, 0) == nonterm);
+        }
+        if (!recursive)
+        {
+            continue;
+        }
+
+        auto tail = grammar.fresh(nonterm);
+        for (size_t p = 0, count = grammar.productionCount; p < count; ++p)
+        {
+            if (dead[p] || grammar.productions[p].lhs != nonterm)
+            {
+                continue;
+            }
+
+            dead[p] = true;
+            bool isRecursive = grammar.size(p) > 0 && grammar.at(p, 0) == nonterm;
+            if (isRecursive && grammar.size(p) == 1)
+            {
+                continue;
+            }
+
+            std::array<StaticSymbol, GrammarType::maxArena> rhs{};
+            auto size = copyRhs(rhs, 0, p, isRecursive ? 1 : 0);
+            if (size == GrammarType::maxArena)
+            {
+                throw std::length_error("eliminateStaticLeftRecursion: rule is too long");
+            }
+            rhs[size++] = tail;
+            grammar.addProduction(isRecursive ? tail : nonterm, rhs.data(), size);
+        }
+        grammar.addProduction(tail, nullptr, 0);
+    }
+
+    auto result = grammar.emptyCopy();
+    for (size_t p = 0; p < grammar.productionCount; ++p)
+    {
+        if (!dead[p])
+        {
+            result.addProduction(grammar.productions[p].lhs,
+                grammar.arena.data() + grammar.productions[p].begin, grammar.size(p));
+        }
+    }
+    return result;
+}
+
+/*
+ * Predictive table with a row per symbol id and a column per terminal id plus the
+ * end marker. On a conflict the earlier production stays and isLl1() is false
+ */
+template<typename GrammarType>
+class StaticLl1Table
+{
+public:
+    constexpr explicit StaticLl1Table(const GrammarType &grammar) : grammar(grammar)
+    {
+        for (auto &&row: cells)
+        {
+            for (auto &&cell: row)
+            {
+                cell = noStaticProduction;
+            }
+        }
+
+        StaticAnalysis<GrammarType> analysis(grammar);
+        for (size_t p = 0; p < grammar.productionCount; ++p)
+        {
+            auto lookahead = analysis.firstOf(grammar, p, 0);
+            if (analysis.isNullable(grammar, p, 0))
+            {
+                lookahead |= analysis.follow[grammar.productions[p].lhs];
+            }
+
+            for (size_t terminal = 0; terminal < 64; ++terminal)
+            {
+                if (!(lookahead >> terminal & 1))
+                {
+                    continue;
+                }
+
+                auto column = terminal == analysis.endMarker ? GrammarType::maxSymbols : terminal;
+                auto &cell = cells[grammar.productions[p].lhs][column];
+                conflicts = conflicts || cell != noStaticProduction;
+                cell = cell == noStaticProduction ? static_cast<std::uint16_t>(p) : cell;
+            }
+        }
+    }
+
+    // terminal noStaticSymbol looks up the end marker column
+    constexpr std::uint16_t getProduction(StaticSymbol nonterm, StaticSymbol terminal) const
+    {
+        return cells[nonterm][terminal == noStaticSymbol ? GrammarType::maxSymbols : terminal];
+    }
+
+    constexpr bool isLl1() const
+    {
+        return !conflicts;
+    }
+
+    constexpr const GrammarType &getGrammar() const
+    {
+        return grammar;
+    }
+
+    // one token per character, at most Depth symbols on the stack
+    template<size_t Depth = 256>
+    constexpr bool accepts(std::string_view input) const
+    {
+        std::array<StaticSymbol, Depth> stack{};
+        size_t size = 0;
+        stack[size++] = grammar.start;
+
+        size_t position = 0;
+        while (size > 0)
+        {
+            auto top = stack[--size];
+            auto token = noStaticSymbol;
+            if (position < input.size())
+            {
+                token = grammar.find(input[position]);
+                if (token == noStaticSymbol || grammar.isNonterm(token))
+                {
+                    return false;
+                }
+            }
+
+            if (!grammar.isNonterm(top))
+            {
+                if (top != token)
+                {
+                    return false;
+                }
+                ++position;
+                continue;
+            }
+
+            auto production = getProduction(top, token);
+            if (production == noStaticProduction || size + grammar.size(production) > Depth)
+            {
+                return false;
+            }
+            for (auto i = grammar.size(production); i-- > 0;)
+            {
+                stack[size++] = grammar.at(production, i);
+            }
+        }
+        return position == input.size();
+    }
+
+private:
+    GrammarType grammar;
+    // a row per symbol, the last column is the end marker
+    using Row = std::array<std::uint16_t, GrammarType::maxSymbols + 1>;
+    std::array<Row, GrammarType::maxSymbols> cells{};
+    bool conflicts = false;
+};
+
+// the runtime form, for the passes and parsers working on CompactGrammar
+template<size_t MaxSymbols, size_t MaxProductions, size_t MaxArena>
+CompactGrammar toCompact(const StaticGrammar<MaxSymbols, MaxProductions, MaxArena> &grammar)
+{
+    CompactGrammar result;
+    for (size_t i = 0; i < grammar.symbolCount; ++i)
+    {
+        const auto &symbol = grammar.symbols[i];
+        result.symbols.intern(
+            std::string(1, symbol.name) + std::string(symbol.primes, '\''), symbol.nonterm);
+    }
+    result.start = grammar.start == noStaticSymbol ? noSymbol : grammar.start;
+
+    for (size_t p = 0; p < grammar.productionCount; ++p)
+    {
+        const auto *rhs = grammar.arena.data() + grammar.productions[p].begin;
+        std::vector<SymbolId> symbols(rhs, rhs + grammar.size(p));
+        result.addProduction(grammar.productions[p].lhs, symbols);
+    }
+    return result;
+}
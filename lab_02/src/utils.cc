@@ -1,6 +1,9 @@
 #include "utils.h"
 
-#include <queue>
+#include <limits>
+#include <stdexcept>
+
+#include "grammarshard.h"
 
 bool ruleHasTerms(const Grammar &grammar, std::string rule)
 {
@@ -17,56 +20,17 @@ bool ruleHasTerms(const Grammar &grammar, std::string rule)
 
 std::set<std::string> findEpsilonNonterms(const Grammar &grammar)
 {
-    std::queue<std::string> epsilonNonterms;
-    std::map<std::string, std::string> reversedGrammar;
-    std::map<std::string, size_t> rulesCounters;
-    std::map<std::string, std::set<std::string>> concernedRules;
-
-    for (auto &&[nontermI, rulesI]: grammar)
-    {
-        for (auto &&[nontermJ, rulesJ]: grammar)
-        {
-            for (auto &&rule: rulesJ)
-            {
-                if (!ruleHasTerms(grammar, rule) && rule.find(nontermI) != std::string::npos)
-                {
-                    concernedRules[nontermI].insert(rule);
-                    ++rulesCounters[rule];
-                }
-            }
-        }
-
-        for (auto &&rule: rulesI)
-        {
-            if (rule == epsilon)
-            {
-                epsilonNonterms.push(nontermI);
-            }
-            else
-            {
-                reversedGrammar.emplace(rule, nontermI);
-            }
-        }
-    }
+    auto compactGrammar = toCompactWithoutStart(grammar);
+    auto nullable = findEpsilonNonterms(compactGrammar);
 
     std::set<std::string> result;
-    for (; !epsilonNonterms.empty();)
+    for (SymbolId id = 0; id < nullable.size(); ++id)
     {
-        auto nonterm = epsilonNonterms.front();
-        epsilonNonterms.pop();
-
-        for (auto &&rule: concernedRules[nonterm])
+        if (nullable[id])
         {
-            auto &&counter = --rulesCounters[rule];
-            if (counter == 0)
-            {
-                epsilonNonterms.push(reversedGrammar[rule]);
-            }
+            result.insert(compactGrammar.symbols.getName(id));
         }
-
-        result.insert(nonterm);
     }
-
     return result;
 }
 
@@ -124,20 +88,441 @@ std::set<std::string> findAllPermutations(
 
 Grammar removeEpsilonNonterms(const Grammar &grammar)
 {
-    Grammar newGrammar;
-    auto epsilonNonterms = findEpsilonNonterms(grammar);
+    return toGrammar(removeEpsilonNonterms(toCompactWithoutStart(grammar)));
+}
+
+/*
+ * Nonterminals with a production whose symbols are all in the set, by a counter of
+ * missing symbols per production. Terminals are in the set when withTerms is set,
+ * otherwise a production with a terminal never counts
+ */
+static std::vector<bool> closeOverProductions(const CompactGrammar &grammar, bool withTerms)
+{
+    const auto &productions = grammar.productions;
+    const auto &symbols = grammar.symbols;
+    std::vector<bool> result(symbols.size(), false);
+
+    // nonterminals of a production not yet known to be in the set
+    std::vector<std::uint32_t> counters(productions.size());
+
+    // productions every nonterminal occurs in, flattened: occurrences of symbol x
+    // are occurrences[offsets[x]] .. occurrences[offsets[x + 1]]
+    std::vector<std::uint32_t> offsets(symbols.size() + 1, 0);
+    std::vector<std::uint32_t> occurrences;
+
+    auto counts = [&](auto &&rhs) {
+        return withTerms || std::all_of(rhs.begin(), rhs.end(),
+            [&](auto &&symbol) { return symbols.isNonterm(symbol); });
+    };
+
+    for (std::uint32_t i = 0; i < productions.size(); ++i)
+    {
+        auto rhs = grammar.getRhs(productions[i]);
+        if (!counts(rhs))
+        {
+            continue;
+        }
+
+        for (auto &&symbol: rhs)
+        {
+            if (symbols.isNonterm(symbol))
+            {
+                ++counters[i];
+                ++offsets[symbol + 1];
+            }
+        }
+    }
+
+    for (size_t i = 1; i < offsets.size(); ++i)
+    {
+        offsets[i] += offsets[i - 1];
+    }
+
+    occurrences.resize(offsets.back());
+    auto next = offsets;
+
+    std::vector<SymbolId> queue;
+    for (std::uint32_t i = 0; i < productions.size(); ++i)
+    {
+        auto rhs = grammar.getRhs(productions[i]);
+        if (!counts(rhs))
+        {
+            continue;
+        }
+
+        if (counters[i] == 0 && !result[productions[i].lhs])
+        {
+            result[productions[i].lhs] = true;
+            queue.push_back(productions[i].lhs);
+        }
+        for (auto &&symbol: rhs)
+        {
+            if (symbols.isNonterm(symbol))
+            {
+                occurrences[next[symbol]++] = i;
+            }
+        }
+    }
+
+    while (!queue.empty())
+    {
+        auto nonterm = queue.back();
+        queue.pop_back();
+
+        for (auto i = offsets[nonterm]; i < offsets[nonterm + 1]; ++i)
+        {
+            auto &&production = productions[occurrences[i]];
+            if (--counters[occurrences[i]] == 0 && !result[production.lhs])
+            {
+                result[production.lhs] = true;
+                queue.push_back(production.lhs);
+            }
+        }
+    }
+
+    if (withTerms)
+    {
+        for (SymbolId id = 0; id < symbols.size(); ++id)
+        {
+            result[id] = result[id] || !symbols.isNonterm(id);
+        }
+    }
+    return result;
+}
+
+std::vector<bool> findEpsilonNonterms(const CompactGrammar &grammar)
+{
+    return closeOverProductions(grammar, false);
+}
+
+std::vector<bool> findGeneratingSymbols(const CompactGrammar &grammar)
+{
+    return closeOverProductions(grammar, true);
+}
+
+std::vector<bool> findReachableSymbols(const CompactGrammar &grammar)
+{
+    std::vector<bool> reachable(grammar.symbols.size(), false);
+    if (grammar.start == noSymbol)
+    {
+        return reachable;
+    }
+
+    auto byLhs = grammar.groupByLhs();
+    std::vector<SymbolId> queue = {grammar.start};
+    reachable[grammar.start] = true;
+
+    while (!queue.empty())
+    {
+        auto nonterm = queue.back();
+        queue.pop_back();
+
+        for (auto &&i: byLhs[nonterm])
+        {
+            for (auto &&symbol: grammar.getRhs(grammar.productions[i]))
+            {
+                if (!reachable[symbol])
+                {
+                    reachable[symbol] = true;
+                    queue.push_back(symbol);
+                }
+            }
+        }
+    }
+    return reachable;
+}
+
+Grammar removeUselessSymbols(const Grammar &grammar, std::string_view start)
+{
+    if (grammar.count(std::string(start)) == 0)
+    {
+        return toGrammar(removeUselessSymbols(toCompactWithoutStart(grammar)));
+    }
+    return toGrammar(removeUselessSymbols(toCompact(grammar, start)));
+}
+
+CompactGrammar removeUselessSymbols(CompactGrammar grammar)
+{
+    // non-generating first: dropping them can make more symbols unreachable, not vice versa
+    auto generating = findGeneratingSymbols(grammar);
+    std::vector<bool> keep(grammar.productions.size());
+    for (size_t i = 0; i < keep.size(); ++i)
+    {
+        auto rhs = grammar.getRhs(grammar.productions[i]);
+        keep[i] = generating[grammar.productions[i].lhs] &&
+            std::all_of(rhs.begin(), rhs.end(), [&](auto &&symbol) { return generating[symbol]; });
+    }
+    grammar.retain(keep);
+    if (grammar.start == noSymbol)
+    {
+        return grammar;
+    }
+
+    auto reachable = findReachableSymbols(grammar);
+    keep.resize(grammar.productions.size());
+    for (size_t i = 0; i < keep.size(); ++i)
+    {
+        keep[i] = reachable[grammar.productions[i].lhs];
+    }
+    grammar.retain(keep);
+    return grammar;
+}
+
+static size_t countNullable(Rhs rule, const std::vector<bool> &nullable)
+{
+    return std::count_if(rule.begin(), rule.end(), [&](auto &&x) { return nullable[x]; });
+}
+
+// productions a rule with k nullable occurrences expands to, saturated instead of overflowing
+static size_t expansionSize(size_t k)
+{
+    constexpr size_t bits = std::numeric_limits<size_t>::digits - 1;
+    return k >= bits ? std::numeric_limits<size_t>::max() : size_t(1) << k;
+}
+
+static size_t saturatingAdd(size_t a, size_t b)
+{
+    return a > std::numeric_limits<size_t>::max() - b ? std::numeric_limits<size_t>::max() : a + b;
+}
+
+// newGrammar is a CompactGrammar or a GrammarShard
+template<typename Output>
+static void addPermutations(
+    Output &newGrammar, SymbolId lhs, Rhs rule, const std::vector<bool> &nullable)
+{
+    std::vector<size_t> positions;
+    for (size_t i = 0; i < rule.size(); ++i)
+    {
+        if (nullable[rule[i]])
+        {
+            positions.push_back(i);
+        }
+    }
+
+    // every subset of nullable occurrences may be dropped, except all symbols at once
+    std::vector<SymbolId> rhs;
+    for (size_t mask = 0; mask < (size_t(1) << positions.size()); ++mask)
+    {
+        rhs.clear();
+        for (size_t i = 0, next = 0; i < rule.size(); ++i)
+        {
+            if (next < positions.size() && positions[next] == i)
+            {
+                if (mask & (size_t(1) << next++))
+                {
+                    continue;
+                }
+            }
+            rhs.push_back(rule[i]);
+        }
+
+        if (!rhs.empty())
+        {
+            newGrammar.addProduction(lhs, rhs);
+        }
+    }
+}
+
+/*
+ * Helper nonterminal H(i) derives every nonempty word of the rule suffix starting
+ * at i with nullable occurrences optionally dropped:
+ *   H(i) -> X(i) H(i+1) | X(i) if the rest may vanish | H(i+1) if X(i) is nullable
+ * so a rule grows into O(length) productions of length <= 2 instead of 2^k rules.
+ * Helpers are keyed by the suffix itself and shared by every rule ending with it
+ */
+class SuffixExpander
+{
+public:
+    SuffixExpander(CompactGrammar &newGrammar, const std::vector<bool> &nullable)
+        : newGrammar(newGrammar), nullable(nullable)
+    {
+    }
+
+    void expand(SymbolId lhs, Rhs rule)
+    {
+        rhs.assign(rule.begin(), rule.end());
+
+        vanishing.assign(rhs.size() + 1, true);
+        last = 0;
+        for (size_t i = rhs.size(); i-- > 0;)
+        {
+            vanishing[i] = vanishing[i + 1] && nullable[rhs[i]];
+            if (nullable[rhs[i]] && last == 0)
+            {
+                last = i;
+            }
+        }
+
+        // symbols before the first nullable occurrence always stay
+        size_t first = 0;
+        while (!nullable[rhs[first]])
+        {
+            ++first;
+        }
+
+        emit(lhs, std::vector<SymbolId>(std::begin(rhs), std::begin(rhs) + first), first);
+    }
+
+private:
+    void emit(SymbolId lhs, const std::vector<SymbolId> &prefix, size_t i)
+    {
+        for (bool keep: {true, false})
+        {
+            if (!keep && !nullable[rhs[i]])
+            {
+                continue;
+            }
+
+            auto newPrefix = prefix;
+            if (keep)
+            {
+                newPrefix.push_back(rhs[i]);
+            }
+
+            if (i + 1 == rhs.size())
+            {
+                if (!newPrefix.empty())
+                {
+                    newGrammar.addProduction(lhs, newPrefix);
+                }
+            }
+            else if (i + 1 > last)
+            {
+                // nothing nullable is left, the suffix is copied as is
+                newPrefix.insert(std::end(newPrefix), std::begin(rhs) + i + 1, std::end(rhs));
+                newGrammar.addProduction(lhs, newPrefix);
+            }
+            else
+            {
+                if (vanishing[i + 1] && !newPrefix.empty())
+                {
+                    newGrammar.addProduction(lhs, newPrefix);
+                }
+                newPrefix.push_back(helper(lhs, i + 1));
+                newGrammar.addProduction(lhs, newPrefix);
+            }
+        }
+    }
+
+    SymbolId helper(SymbolId base, size_t i)
+    {
+        std::vector<SymbolId> suffix(std::begin(rhs) + i, std::end(rhs));
+        if (auto it = helpers.find(suffix); it != std::end(helpers))
+        {
+            return it->second;
+        }
+
+        auto id = newGrammar.symbols.fresh(base);
+        helpers.emplace(std::move(suffix), id);
+        emit(id, {}, i);
+        return id;
+    }
+
+private:
+    CompactGrammar &newGrammar;
+    const std::vector<bool> &nullable;
+    std::map<std::vector<SymbolId>, SymbolId> helpers;
+
+    std::vector<SymbolId> rhs;
+    std::vector<bool> vanishing;
+    size_t last = 0;
+};
+
+size_t estimateEpsilonExpansion(const CompactGrammar &grammar)
+{
+    auto nullable = findEpsilonNonterms(grammar);
 
-    for (auto &&[nonterm, rules]: grammar)
+    size_t result = 0;
+    for (auto &&production: grammar.productions)
     {
-        for (auto &&rule: rules)
+        auto rule = grammar.getRhs(production);
+        if (!rule.empty())
         {
-            if (rule != epsilon)
+            result = saturatingAdd(result, expansionSize(countNullable(rule, nullable)));
+        }
+    }
+    return result;
+}
+
+void checkEpsilonExpansion(
+    const CompactGrammar &grammar, const std::vector<bool> &nullable, size_t limit)
+{
+    // only the 2^k of one rule can explode, rules without nullable symbols stay one each
+    for (auto &&production: grammar.productions)
+    {
+        auto rule = grammar.getRhs(production);
+        auto size = expansionSize(countNullable(rule, nullable));
+        if (size > limit)
+        {
+            throw std::length_error("removeEpsilonNonterms: " +
+                grammar.symbols.getName(production.lhs) + " -> " + toString(grammar, rule) +
+                " has " + std::to_string(countNullable(rule, nullable)) +
+                " nullable symbols, " + std::to_string(size) +
+                " productions exceed the limit of " + std::to_string(limit));
+        }
+    }
+}
+
+CompactGrammar removeEpsilonNonterms(const CompactGrammar &grammar)
+{
+    return removeEpsilonNonterms(grammar, EpsilonElimination::Permutations);
+}
+
+CompactGrammar removeEpsilonNonterms(
+    const CompactGrammar &input, EpsilonElimination mode, size_t limit, size_t threads)
+{
+    auto grammar = removeUselessSymbols(input);
+    auto nullable = findEpsilonNonterms(grammar);
+    return removeEpsilonNonterms(std::move(grammar), nullable, mode, limit, threads);
+}
+
+CompactGrammar removeEpsilonNonterms(CompactGrammar grammar,
+    const std::vector<bool> &nullable,
+    EpsilonElimination mode,
+    size_t limit,
+    size_t threads)
+{
+    if (mode == EpsilonElimination::Permutations)
+    {
+        checkEpsilonExpansion(grammar, nullable, limit);
+    }
+
+    // old rules are read from the moved out arena while new ones go into the grammar
+    auto productions = std::move(grammar.productions);
+    auto arena = std::move(grammar.arena);
+    grammar.productions.clear();
+    grammar.arena.clear();
+
+    auto getRhs = [&](const Production &production) {
+        return Rhs{arena.data() + production.begin,
+            arena.data() + production.begin + production.size};
+    };
+    auto expands = [&](Rhs rule) {
+        return mode == EpsilonElimination::Helpers && countNullable(rule, nullable) > 1;
+    };
+
+    // permutations of every rule are independent, helpers are shared and made in order
+    runSharded(grammar, productions.size(), threads,
+        [&](GrammarShard &shard, size_t begin, size_t end) {
+            for (auto i = begin; i < end; ++i)
             {
-                auto permutations = findAllPermutations(epsilonNonterms, rule);
-                newGrammar[nonterm].insert(std::begin(permutations), std::end(permutations));
+                auto rule = getRhs(productions[i]);
+                if (!rule.empty() && !expands(rule))
+                {
+                    addPermutations(shard, productions[i].lhs, rule, nullable);
+                }
             }
+        });
+
+    SuffixExpander expander(grammar, nullable);
+    for (auto &&production: productions)
+    {
+        if (auto rule = getRhs(production); !rule.empty() && expands(rule))
+        {
+            expander.expand(production.lhs, rule);
         }
     }
 
-    return newGrammar;
+    grammar.normalize();
+    return grammar;
 }
@@ -1,10 +1,15 @@
 #pragma once
 
+#include <algorithm>
 #include <map>
 #include <set>
 #include <vector>
 #include <string>
+#include <string_view>
 #include <iostream>
+#include <iterator>
+
+#include "compactgrammar.h"
 
 using Grammar = std::map<std::string, std::set<std::string>>;
 
@@ -81,9 +86,64 @@ constexpr auto findAllCommonPrefixes = [](auto &&container) {
     return prefixes;
 };
 
+// nonterminals are the keys of grammar, rules are split by the longest nonterminal name;
+// throws std::invalid_argument if a nonempty grammar has no nonterminal start
+CompactGrammar toCompact(const Grammar &grammar, std::string_view start = "S");
+
+// a Grammar names no start, with none the passes drop no production as unreachable
+CompactGrammar toCompactWithoutStart(const Grammar &grammar);
+Grammar toGrammar(const CompactGrammar &grammar);
+
 bool ruleHasTerms(const Grammar &grammar, std::string rule);
 
 std::set<std::string> findEpsilonNonterms(const Grammar &grammar);
 std::set<std::string> findAllPermutations(
     const std::set<std::string> &epsilonNonterms, std::string rule);
 Grammar removeEpsilonNonterms(const Grammar &grammar);
+
+enum class EpsilonElimination
+{
+    Permutations,  // every subset of nullable occurrences, 2^k productions per rule
+    Helpers,       // helper nonterminals per rule suffix, linear growth, may add chain rules
+};
+
+// productions Permutations may make of a single rule, 16 nullable symbols
+inline constexpr size_t maxEpsilonExpansion = 1 << 16;
+
+// nullable flags indexed by symbol id
+std::vector<bool> findEpsilonNonterms(const CompactGrammar &grammar);
+
+// flags indexed by symbol id, terminals always generate and nothing is reachable without a start
+std::vector<bool> findGeneratingSymbols(const CompactGrammar &grammar);
+std::vector<bool> findReachableSymbols(const CompactGrammar &grammar);
+
+/*
+ * Drops productions of nonterminals that derive no terminal string or that the start
+ * never reaches, without a start only the former. removeEpsilonNonterms and
+ * deleteLongRules (and eliminateLeftRecursion through the former) run it first
+ */
+Grammar removeUselessSymbols(const Grammar &grammar, std::string_view start = "S");
+CompactGrammar removeUselessSymbols(CompactGrammar grammar);
+
+// productions Permutations would make in total, cheap to check before the pass
+size_t estimateEpsilonExpansion(const CompactGrammar &grammar);
+
+// throws std::length_error if Permutations would make more than limit productions of a rule
+void checkEpsilonExpansion(const CompactGrammar &grammar,
+    const std::vector<bool> &nullable,
+    size_t limit = maxEpsilonExpansion);
+
+// checked as above in Permutations mode,
+// threads expand rules in parallel without changing the result
+CompactGrammar removeEpsilonNonterms(const CompactGrammar &grammar);
+CompactGrammar removeEpsilonNonterms(const CompactGrammar &grammar,
+    EpsilonElimination mode,
+    size_t limit = maxEpsilonExpansion,
+    size_t threads = 1);
+
+// the same pass reusing the symbols of grammar and its already known nullable flags
+CompactGrammar removeEpsilonNonterms(CompactGrammar grammar,
+    const std::vector<bool> &nullable,
+    EpsilonElimination mode = EpsilonElimination::Permutations,
+    size_t limit = maxEpsilonExpansion,
+    size_t threads = 1);
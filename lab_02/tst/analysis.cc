@@ -0,0 +1,104 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include "analysis.h"
+#include "utils.h"
+
+static const Grammar expressions = {
+    {"E", {"TX"}},
+    {"X", {"+TX", epsilon}},
+    {"T", {"FY"}},
+    {"Y", {"*FY", epsilon}},
+    {"F", {"(E)", "i"}},
+};
+
+TEST(GrammarAnalysis, TestsThatNullableNontermsAreFound)
+{
+    auto grammar = toCompact(expressions, "E");
+    GrammarAnalysis analysis(grammar);
+
+    ASSERT_FALSE(analysis.isNullable(grammar.symbols.find("E")));
+    ASSERT_TRUE(analysis.isNullable(grammar.symbols.find("X")));
+    ASSERT_TRUE(analysis.isNullable(grammar.symbols.find("Y")));
+    ASSERT_FALSE(analysis.isNullable(grammar.symbols.find("i")));
+}
+
+TEST(GrammarAnalysis, TestsThatFirstSetsAreComputed)
+{
+    auto grammar = toCompact(expressions, "E");
+    GrammarAnalysis analysis(grammar);
+
+    auto first = [&](auto &&name) {
+        return analysis.getNames(analysis.getFirst(grammar.symbols.find(name)));
+    };
+    ASSERT_THAT(first("E"), testing::UnorderedElementsAre("(", "i"));
+    ASSERT_THAT(first("T"), testing::UnorderedElementsAre("(", "i"));
+    ASSERT_THAT(first("X"), testing::UnorderedElementsAre("+"));
+    ASSERT_THAT(first("Y"), testing::UnorderedElementsAre("*"));
+    ASSERT_THAT(first("+"), testing::UnorderedElementsAre("+"));
+}
+
+TEST(GrammarAnalysis, TestsThatFollowSetsAreComputed)
+{
+    auto grammar = toCompact(expressions, "E");
+    GrammarAnalysis analysis(grammar);
+
+    auto follow = [&](auto &&name) {
+        return analysis.getNames(analysis.getFollow(grammar.symbols.find(name)));
+    };
+    ASSERT_THAT(follow("E"), testing::UnorderedElementsAre(")", "$"));
+    ASSERT_THAT(follow("X"), testing::UnorderedElementsAre(")", "$"));
+    ASSERT_THAT(follow("T"), testing::UnorderedElementsAre("+", ")", "$"));
+    ASSERT_THAT(follow("Y"), testing::UnorderedElementsAre("+", ")", "$"));
+    ASSERT_THAT(follow("F"), testing::UnorderedElementsAre("*", "+", ")", "$"));
+}
+
+TEST(GrammarAnalysis, TestsThatFirstOfRuleSkipsNullablePrefix)
+{
+    Grammar grammar = {
+        {"S", {"ABc"}},
+        {"A", {"a", epsilon}},
+        {"B", {"b", epsilon}},
+    };
+
+    auto compact = toCompact(grammar);
+    GrammarAnalysis analysis(compact);
+
+    auto rhs = compact.getRhs(compact.productions.back());
+    ASSERT_EQ(toString(compact, rhs), "ABc");
+    ASSERT_THAT(
+        analysis.getNames(analysis.getFirst(rhs)), testing::UnorderedElementsAre("a", "b", "c"));
+    ASSERT_FALSE(analysis.isNullable(rhs));
+    ASSERT_THAT(analysis.getNames(analysis.getFollow(compact.symbols.find("A"))),
+        testing::UnorderedElementsAre("b", "c"));
+}
+
+TEST(GrammarAnalysis, TestsThatLongChainsConverge)
+{
+    constexpr size_t count = 2000;
+
+    // N0 -> N1 a | ?, N1 -> N2 a | ?, ..., FIRST and FOLLOW flow through the whole chain
+    Grammar grammar;
+    for (size_t i = 0; i < count; ++i)
+    {
+        grammar["N" + std::to_string(i)] = {"N" + std::to_string(i + 1) + "a", epsilon};
+    }
+    grammar["N" + std::to_string(count)] = {"b"};
+
+    auto compact = toCompact(grammar, "N0");
+    GrammarAnalysis analysis(compact);
+
+    ASSERT_THAT(analysis.getNames(analysis.getFirst(compact.symbols.find("N0"))),
+        testing::UnorderedElementsAre("a", "b"));
+    ASSERT_THAT(
+        analysis.getNames(analysis.getFollow(compact.symbols.find("N" + std::to_string(count)))),
+        testing::UnorderedElementsAre("a"));
+    ASSERT_THAT(analysis.getNames(analysis.getFollow(compact.symbols.find("N0"))),
+        testing::UnorderedElementsAre("$"));
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
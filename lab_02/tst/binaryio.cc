@@ -0,0 +1,140 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "binaryio.h"
+#include "lalr.h"
+#include "ll1.h"
+
+static const Grammar expressions = {
+    {"E", {"E+T", "T"}},
+    {"T", {"T*F", "F"}},
+    {"F", {"(E)", "i"}},
+};
+
+TEST(BinaryIo, TestsThatNumbersRoundTrip)
+{
+    BinaryWriter writer;
+    writer.writeVarint(0);
+    writer.writeVarint(127);
+    writer.writeVarint(128);
+    writer.writeVarint(static_cast<std::uint64_t>(-1));
+    writer.writeIndex(noSymbol);
+    writer.writeIndex(static_cast<size_t>(-1));
+    writer.writeIndices(std::vector<std::uint32_t>{5, noSymbol, 0});
+    writer.writeString("name");
+
+    // one byte below 128, two from 128 on
+    EXPECT_EQ(writer.getData().substr(0, 4), std::string("\0\x7f\x80\x01", 4));
+
+    BinaryReader reader(writer.getData());
+    EXPECT_EQ(reader.readVarint(), 0);
+    EXPECT_EQ(reader.readVarint(), 127);
+    EXPECT_EQ(reader.readVarint(), 128);
+    EXPECT_EQ(reader.readVarint(), static_cast<std::uint64_t>(-1));
+    EXPECT_EQ(reader.readIndex<SymbolId>(), noSymbol);
+    EXPECT_EQ(reader.readIndex<size_t>(), static_cast<size_t>(-1));
+    EXPECT_EQ(reader.readIndices<std::uint32_t>(), (std::vector<std::uint32_t>{5, noSymbol, 0}));
+    EXPECT_EQ(reader.readString(), "name");
+    EXPECT_TRUE(reader.atEnd());
+    EXPECT_THROW(reader.readVarint(), std::runtime_error);
+}
+
+TEST(BinaryIo, TestsThatGrammarKeepsSymbolIds)
+{
+    auto grammar = toCompact(expressions, "E");
+    grammar.symbols.fresh(grammar.start);
+
+    BinaryWriter writer;
+    writeGrammar(writer, grammar);
+    BinaryReader reader(writer.getData());
+    auto copy = readGrammar(reader);
+
+    ASSERT_EQ(copy.symbols.size(), grammar.symbols.size());
+    for (SymbolId id = 0; id < grammar.symbols.size(); ++id)
+    {
+        EXPECT_EQ(copy.symbols.getName(id), grammar.symbols.getName(id));
+        EXPECT_EQ(copy.symbols.isNonterm(id), grammar.symbols.isNonterm(id));
+    }
+    EXPECT_EQ(copy.start, grammar.start);
+    EXPECT_EQ(copy.arena, grammar.arena);
+    EXPECT_EQ(toGrammar(copy), toGrammar(grammar));
+}
+
+TEST(BinaryIo, TestsThatDamagedDataThrows)
+{
+    BinaryWriter writer;
+    writeGrammar(writer, toCompact(expressions, "E"));
+    const auto &data = writer.getData();
+
+    for (size_t size = 0; size < data.size(); ++size)
+    {
+        BinaryReader reader(std::string_view(data).substr(0, size));
+        EXPECT_THROW(readGrammar(reader), std::runtime_error);
+    }
+
+    // a huge count fails before anything is allocated
+    BinaryWriter huge;
+    huge.writeVarint(std::uint64_t(1) << 40);
+    BinaryReader reader(huge.getData());
+    EXPECT_THROW(readGrammar(reader), std::runtime_error);
+}
+
+TEST(BinaryIo, TestsThatTablesParseTheSameAfterReading)
+{
+    auto ll1 = makeLl1Table(expressions, "E");
+    auto lalr = makeLalrTable(expressions, "E");
+
+    BinaryWriter writer;
+    ll1.write(writer);
+    lalr.write(writer);
+
+    BinaryReader reader(writer.getData());
+    auto ll1Copy = Ll1Table::read(reader);
+    auto lalrCopy = LalrTable::read(reader);
+    EXPECT_TRUE(reader.atEnd());
+
+    for (auto input: {"i+i*i", "(i+i)*i", "i+", "(i"})
+    {
+        auto ll1Result = Ll1Parser(ll1).parse(input);
+        auto ll1CopyResult = Ll1Parser(ll1Copy).parse(input);
+        EXPECT_EQ(ll1CopyResult.accepted, ll1Result.accepted);
+        EXPECT_EQ(ll1CopyResult.derivation, ll1Result.derivation);
+
+        auto lalrResult = LalrParser(lalr).parse(input);
+        auto lalrCopyResult = LalrParser(lalrCopy).parse(input);
+        EXPECT_EQ(lalrCopyResult.accepted, lalrResult.accepted);
+        EXPECT_EQ(lalrCopyResult.derivation, lalrResult.derivation);
+    }
+    EXPECT_EQ(lalrCopy.getStateCount(), lalr.getStateCount());
+}
+
+TEST(BinaryIo, TestsThatConflictsAreKept)
+{
+    Grammar grammar = {
+        {"S", {"aAd", "bBd", "aBe", "bAe"}},
+        {"A", {"c"}},
+        {"B", {"c"}},
+    };
+    auto table = makeLalrTable(grammar);
+
+    BinaryWriter writer;
+    table.write(writer);
+    BinaryReader reader(writer.getData());
+    auto copy = LalrTable::read(reader);
+
+    ASSERT_EQ(copy.getConflicts().size(), table.getConflicts().size());
+    for (size_t i = 0; i < table.getConflicts().size(); ++i)
+    {
+        EXPECT_EQ(copy.toString(copy.getConflicts()[i]), table.toString(table.getConflicts()[i]));
+    }
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
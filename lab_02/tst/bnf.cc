@@ -0,0 +1,119 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#include "bnf.h"
+#include "utils.h"
+
+static std::string write(const CompactGrammar &grammar)
+{
+    std::ostringstream out;
+    writeBnf(out, grammar);
+    return out.str();
+}
+
+TEST(parseBnf, TestsThatRulesMatchInitializerGrammar)
+{
+    auto grammar = parseBnf(
+        "# the grammar of main.cc\n"
+        "S -> a X b X | a Z\n"
+        "X -> a Y | b Y | ?\n"
+        "Y ::= X | c c ;\n"
+        "Z -> Z X\n");
+
+    Grammar expected = {
+        {"S", {"aXbX", "aZ"}},
+        {"X", {"aY", "bY", epsilon}},
+        {"Y", {"X", "cc"}},
+        {"Z", {"ZX"}},
+    };
+    EXPECT_EQ(grammar.symbols.getName(grammar.start), "S");
+    EXPECT_EQ(toGrammar(grammar), expected);
+}
+
+TEST(parseBnf, TestsThatQuotesAndBracketsForceSymbolKind)
+{
+    auto grammar = parseBnf(R"(<expr> -> term "+" <expr> | "\"" | <empty>)");
+
+    auto plus = grammar.symbols.find("+");
+    auto quote = grammar.symbols.find("\"");
+    auto term = grammar.symbols.find("term");
+    auto empty = grammar.symbols.find("empty");
+    ASSERT_NE(quote, noSymbol);
+    EXPECT_FALSE(grammar.symbols.isNonterm(plus));
+    EXPECT_FALSE(grammar.symbols.isNonterm(term));
+    EXPECT_TRUE(grammar.symbols.isNonterm(empty));
+    EXPECT_EQ(grammar.productions.size(), 3);
+}
+
+TEST(parseBnf, TestsThatEbnfGroupsBecomeHelpers)
+{
+    auto grammar = parseBnf("S -> a [ b ] { c | d } ( e | f )");
+
+    Grammar expected = {
+        {"S", {"aS'S''S'''"}},
+        {"S'", {"b", epsilon}},
+        {"S''", {"cS''", "dS''", epsilon}},
+        {"S'''", {"e", "f"}},
+    };
+    EXPECT_EQ(toGrammar(grammar), expected);
+}
+
+TEST(parseBnf, TestsThatErrorsReportLine)
+{
+    EXPECT_THROW(parseBnf("a b"), std::invalid_argument);
+    EXPECT_THROW(parseBnf("S -> a | -> b"), std::invalid_argument);
+    EXPECT_THROW(parseBnf("S -> \"S\""), std::invalid_argument);
+
+    try
+    {
+        parseBnf("S -> a\nA -> ( b\n");
+        FAIL();
+    }
+    catch (const std::invalid_argument &error)
+    {
+        EXPECT_THAT(error.what(), testing::HasSubstr("line 2"));
+    }
+}
+
+TEST(writeBnf, TestsThatOutputReadsBack)
+{
+    auto grammar = parseBnf(R"bnf(
+        E -> E "+" T | T
+        T -> "(" E ")" | <x y> | "?" | "a->b" | ?
+    )bnf");
+
+    auto text = write(grammar);
+    EXPECT_THAT(text, testing::StartsWith("E -> E + T | T\n"));
+    EXPECT_THAT(text, testing::HasSubstr(R"bnf(T -> "(" E ")" | <x y> | "?" | "a->b" | ?)bnf"));
+    EXPECT_EQ(write(parseBnf(text)), text);
+}
+
+TEST(writeBnf, TestsThatLargeGrammarRoundTrips)
+{
+    CompactGrammar grammar;
+    grammar.start = grammar.symbols.intern("N0", true);
+    auto a = grammar.symbols.intern("a", false);
+
+    for (size_t i = 0; i < 5000; ++i)
+    {
+        auto lhs = grammar.symbols.intern("N" + std::to_string(i), true);
+        auto next = grammar.symbols.intern("N" + std::to_string(i + 1), true);
+        grammar.addProduction(lhs, std::vector<SymbolId>{a, next});
+        grammar.addProduction(lhs, std::vector<SymbolId>{});
+    }
+
+    auto text = write(grammar);
+    auto loaded = parseBnf(text);
+    EXPECT_EQ(loaded.productions.size(), grammar.productions.size());
+    EXPECT_EQ(write(loaded), text);
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
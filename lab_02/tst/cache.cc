@@ -0,0 +1,194 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#include "cache.h"
+#include "chomskyutils.h"
+
+static const Grammar expressions = {
+    {"E", {"E+T", "T"}},
+    {"T", {"T*F", "F"}},
+    {"F", {"(E)", "i"}},
+};
+
+// a fresh directory per test, removed afterwards
+class GrammarCacheTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        directory = std::filesystem::temp_directory_path() /
+            ("lab_02_cache_" + std::string(
+                ::testing::UnitTest::GetInstance()->current_test_info()->name()));
+        std::filesystem::remove_all(directory);
+    }
+
+    void TearDown() override
+    {
+        std::filesystem::remove_all(directory);
+    }
+
+    size_t countFiles() const
+    {
+        auto it = std::filesystem::directory_iterator(directory);
+        return static_cast<size_t>(std::distance(begin(it), end(it)));
+    }
+
+    std::filesystem::path directory;
+};
+
+TEST(HashGrammar, TestsThatHashFollowsIdsAndOrder)
+{
+    CompactGrammar first;
+    auto a = first.symbols.intern("a", false);
+    auto s = first.symbols.intern("S", true);
+    first.start = s;
+    first.addProduction(s, std::vector<SymbolId>{a, s});
+    first.addProduction(s, std::vector<SymbolId>{a});
+    EXPECT_EQ(hashGrammar(first), hashGrammar(CompactGrammar(first)));
+
+    // the same productions in another order
+    auto reordered = makeEmptyCopy(first);
+    reordered.addProduction(s, std::vector<SymbolId>{a});
+    reordered.addProduction(s, std::vector<SymbolId>{a, s});
+    EXPECT_NE(hashGrammar(first), hashGrammar(reordered));
+
+    // the same names under other ids
+    CompactGrammar renumbered;
+    s = renumbered.symbols.intern("S", true);
+    a = renumbered.symbols.intern("a", false);
+    renumbered.start = s;
+    renumbered.addProduction(s, std::vector<SymbolId>{a, s});
+    renumbered.addProduction(s, std::vector<SymbolId>{a});
+    EXPECT_NE(hashGrammar(first), hashGrammar(renumbered));
+}
+
+TEST(HashGrammar, TestsThatDifferentGrammarsDiffer)
+{
+    auto hash = hashGrammar(expressions, "E");
+    EXPECT_NE(hash, hashGrammar(expressions, "T"));
+    EXPECT_NE(hash, hashGrammar(Grammar{{"E", {"E+T", "T"}}, {"T", {"F"}}, {"F", {"i"}}}, "E"));
+
+    // "ab" "c" and "a" "bc" as symbol names
+    CompactGrammar first;
+    auto s = first.symbols.intern("S", true);
+    first.start = s;
+    first.addProduction(s,
+        std::vector<SymbolId>{first.symbols.intern("ab", false), first.symbols.intern("c", false)});
+    CompactGrammar second;
+    s = second.symbols.intern("S", true);
+    second.start = s;
+    auto a = second.symbols.intern("a", false);
+    second.addProduction(s, std::vector<SymbolId>{a, second.symbols.intern("bc", false)});
+    EXPECT_NE(hashGrammar(first), hashGrammar(second));
+}
+
+TEST_F(GrammarCacheTest, TestsThatSecondRunSkipsPipeline)
+{
+    auto grammar = toCompact(expressions, "E");
+    size_t runs = 0;
+    auto pipeline = [&](const CompactGrammar &input) {
+        ++runs;
+        return toChomskyNormalForm(input);
+    };
+
+    GrammarCache cache(directory.string());
+    auto result = cache.transform(grammar, "chomsky", pipeline);
+    EXPECT_EQ(cache.getMisses(), 1);
+    EXPECT_EQ(countFiles(), 1);
+
+    // a new cache on the same directory, as the next build would make
+    GrammarCache next(directory.string());
+    auto cached = next.transform(grammar, "chomsky", pipeline);
+    EXPECT_EQ(next.getHits(), 1);
+    EXPECT_EQ(runs, 1);
+    EXPECT_EQ(toGrammar(cached), toGrammar(result));
+    EXPECT_EQ(cached.arena, result.arena);
+
+    // another pipeline name is another entry
+    next.transform(grammar, "chomsky/2", pipeline);
+    EXPECT_EQ(runs, 2);
+    EXPECT_EQ(countFiles(), 2);
+}
+
+TEST_F(GrammarCacheTest, TestsThatHitReturnsWhatPipelineReturns)
+{
+    Grammar grammar = {
+        {"S", {"ABC", "BCA"}},
+        {"A", {"a"}},
+        {"B", {"b"}},
+        {"C", {"c"}},
+    };
+    auto compact = toCompact(grammar);
+
+    // the same productions in the other order name the fresh nonterminals the other way
+    auto reordered = makeEmptyCopy(compact);
+    for (auto i = compact.productions.size(); i-- > 0;)
+    {
+        auto rhs = compact.getRhs(compact.productions[i]);
+        reordered.addProduction(compact.productions[i].lhs, rhs.begin(), rhs.end());
+    }
+
+    auto pipeline = [](const CompactGrammar &input) { return deleteLongRules(input); };
+    GrammarCache cache(directory.string());
+    for (auto &&input: {compact, reordered, compact, reordered})
+    {
+        auto cached = cache.transform(input, "long", pipeline);
+        auto direct = deleteLongRules(input);
+        EXPECT_EQ(toGrammar(cached), toGrammar(direct));
+        EXPECT_EQ(cached.arena, direct.arena);
+    }
+    EXPECT_EQ(cache.getMisses(), 2);
+    EXPECT_EQ(cache.getHits(), 2);
+}
+
+TEST_F(GrammarCacheTest, TestsThatTablesAreCached)
+{
+    GrammarCache cache(directory.string());
+    cache.getLl1Table(expressions, "E");
+    cache.getLalrTable(expressions, "E");
+    EXPECT_EQ(cache.getMisses(), 2);
+
+    auto ll1 = cache.getLl1Table(expressions, "E");
+    auto lalr = cache.getLalrTable(expressions, "E", 4);
+    EXPECT_EQ(cache.getHits(), 2);
+
+    EXPECT_TRUE(Ll1Parser(ll1).parse("i+i*i").accepted);
+    EXPECT_TRUE(LalrParser(lalr).parse("(i+i)*i").accepted);
+    EXPECT_FALSE(LalrParser(lalr).parse("i+").accepted);
+}
+
+TEST_F(GrammarCacheTest, TestsThatDamagedFileIsReplaced)
+{
+    GrammarCache cache(directory.string());
+    cache.getLalrTable(expressions, "E");
+
+    auto path = std::filesystem::directory_iterator(directory)->path();
+    auto size = std::filesystem::file_size(path);
+    {
+        std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(static_cast<std::streamoff>(size - 1));
+        file.put('\xff');
+    }
+
+    auto table = cache.getLalrTable(expressions, "E");
+    EXPECT_EQ(cache.getMisses(), 2);
+    EXPECT_TRUE(LalrParser(table).parse("i*i").accepted);
+
+    std::filesystem::resize_file(path, size / 2);
+    cache.getLalrTable(expressions, "E");
+    EXPECT_EQ(cache.getMisses(), 3);
+
+    cache.getLalrTable(expressions, "E");
+    EXPECT_EQ(cache.getHits(), 1);
+    EXPECT_EQ(countFiles(), 1);
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -30,12 +30,27 @@ TEST(deleteLongRules, TestsEliminationOfLongRules2)
     };
 
     auto newGrammar = deleteLongRules(grammar);
-    ASSERT_THAT(newGrammar["S"], testing::ElementsAre("aS'", "aZ"));
+    ASSERT_THAT(newGrammar["S"], testing::ElementsAre("aS'"));
     ASSERT_THAT(newGrammar["S'"], testing::ElementsAre("XS''"));
     ASSERT_THAT(newGrammar["S''"], testing::ElementsAre("bX"));
     ASSERT_THAT(newGrammar["X"], testing::ElementsAre(epsilon, "aY", "bY"));
     ASSERT_THAT(newGrammar["Y"], testing::ElementsAre("X", "cc"));
-    ASSERT_THAT(newGrammar["Z"], testing::ElementsAre("ZX"));
+    ASSERT_EQ(newGrammar.count("Z"), 0);
+}
+
+TEST(deleteLongRules, TestsThatRulesWithoutStartAreKept)
+{
+    Grammar grammar = {
+        {"E", {"E+T", "T"}},
+        {"T", {"a"}},
+        {"A", {"bcd"}},
+    };
+
+    auto newGrammar = deleteLongRules(grammar);
+    ASSERT_THAT(newGrammar["E"], testing::ElementsAre("EE'", "T"));
+    ASSERT_THAT(newGrammar["E'"], testing::ElementsAre("+T"));
+    ASSERT_THAT(newGrammar["T"], testing::ElementsAre("a"));
+    ASSERT_THAT(newGrammar["A"], testing::ElementsAre("bA'"));
 }
 
 TEST(deleteChainRules, TestsEliminationOfChainRules)
@@ -55,7 +70,96 @@ TEST(deleteChainRules, TestsEliminationOfChainRules)
     ASSERT_THAT(newGrammar["S''"], testing::ElementsAre("b", "bX"));
     ASSERT_THAT(newGrammar["X"], testing::ElementsAre("a", "aY", "b", "bY"));
     ASSERT_THAT(newGrammar["Y"], testing::ElementsAre("a", "aY", "b", "bY", "cc"));
-    ASSERT_THAT(newGrammar["Z"], testing::ElementsAre("Z", "ZX"));
+    ASSERT_THAT(newGrammar["Z"], testing::ElementsAre("ZX"));
+}
+
+TEST(deleteChainRules, TestsThatChainsAreClosedInOnePass)
+{
+    Grammar grammar = {
+        {"A", {"B", "a"}},
+        {"B", {"C", "b"}},
+        {"C", {"A", "c"}},
+        {"D", {"A", "dd"}},
+    };
+
+    auto newGrammar = deleteChainRules(grammar);
+    ASSERT_THAT(newGrammar["A"], testing::ElementsAre("a", "b", "c"));
+    ASSERT_THAT(newGrammar["B"], testing::ElementsAre("a", "b", "c"));
+    ASSERT_THAT(newGrammar["C"], testing::ElementsAre("a", "b", "c"));
+    ASSERT_THAT(newGrammar["D"], testing::ElementsAre("a", "b", "c", "dd"));
+    EXPECT_EQ(deleteChainRules(newGrammar), newGrammar);
+}
+
+TEST(deleteChainRules, TestsThatLongChainsStayFast)
+{
+    CompactGrammar grammar;
+    auto a = grammar.symbols.intern("a", false);
+
+    // N0 -> N1 -> ... -> N999 -> a, each N also has a rule of its own
+    std::vector<SymbolId> nonterms;
+    for (size_t i = 0; i < 1000; ++i)
+    {
+        nonterms.push_back(grammar.symbols.intern("N" + std::to_string(i), true));
+    }
+    grammar.start = nonterms.front();
+    for (size_t i = 0; i < nonterms.size(); ++i)
+    {
+        auto next = i + 1 < nonterms.size() ? nonterms[i + 1] : a;
+        grammar.addProduction(nonterms[i], std::vector<SymbolId>{next});
+        grammar.addProduction(nonterms[i], std::vector<SymbolId>{a, nonterms[i]});
+    }
+
+    auto newGrammar = deleteChainRules(grammar);
+    auto byLhs = newGrammar.groupByLhs();
+    EXPECT_EQ(byLhs[nonterms.front()].size(), nonterms.size() + 1);
+    EXPECT_EQ(byLhs[nonterms.back()].size(), 2);
+}
+
+TEST(toChomskyNormalForm, TestsConversionToChomskyNormalForm)
+{
+    Grammar grammar = {
+        {"S", {"aSb", epsilon}},
+    };
+
+    auto newGrammar = toChomskyNormalForm(grammar);
+    ASSERT_THAT(newGrammar["S'"], testing::ElementsAre(epsilon, "a'S''"));
+    ASSERT_THAT(newGrammar["S"], testing::ElementsAre("a'S''"));
+    ASSERT_THAT(newGrammar["S''"], testing::ElementsAre("Sb'", "b"));
+    ASSERT_THAT(newGrammar["a'"], testing::ElementsAre("a"));
+    ASSERT_THAT(newGrammar["b'"], testing::ElementsAre("b"));
+}
+
+TEST(toChomskyNormalForm, TestsThatStartIsNotGuessed)
+{
+    Grammar grammar = {
+        {"E", {"E+T", "T"}},
+        {"T", {"a"}},
+        {"A", {"b"}},
+    };
+
+    EXPECT_THROW(toChomskyNormalForm(grammar), std::invalid_argument);
+
+    // A is unreachable from E
+    auto newGrammar = toChomskyNormalForm(grammar, "E");
+    ASSERT_THAT(newGrammar["E'"], testing::ElementsAre("EE''", "a"));
+    ASSERT_THAT(newGrammar["E"], testing::ElementsAre("EE''", "a"));
+    ASSERT_THAT(newGrammar["E''"], testing::ElementsAre("+'T"));
+    ASSERT_THAT(newGrammar["T"], testing::ElementsAre("a"));
+    ASSERT_EQ(newGrammar.count("A"), 0);
+}
+
+TEST(toChomskyNormalForm, TestsThatUnitChainsAreReplaced)
+{
+    Grammar grammar = {
+        {"S", {"A"}},
+        {"A", {"B", "aa"}},
+        {"B", {"S", "b"}},
+    };
+
+    auto newGrammar = toChomskyNormalForm(grammar);
+    ASSERT_THAT(newGrammar["S'"], testing::ElementsAre("a'a'", "b"));
+    ASSERT_THAT(newGrammar["A"], testing::ElementsAre("a'a'", "b"));
+    ASSERT_THAT(newGrammar["B"], testing::ElementsAre("a'a'", "b"));
 }
 
 int main(int argc, char **argv)
@@ -0,0 +1,115 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include "utils.h"
+
+TEST(toCompact, TestsThatLongestNontermNameIsUsed)
+{
+    Grammar grammar = {
+        {"X", {"aX'X"}},
+        {"X'", {"b", epsilon}},
+    };
+
+    auto compactGrammar = toCompact(grammar, "X");
+    auto x = compactGrammar.symbols.find("X");
+    auto x1 = compactGrammar.symbols.find("X'");
+    auto a = compactGrammar.symbols.find("a");
+
+    ASSERT_NE(a, noSymbol);
+    EXPECT_FALSE(compactGrammar.symbols.isNonterm(a));
+    EXPECT_TRUE(compactGrammar.symbols.isNonterm(x1));
+
+    auto &&production = compactGrammar.productions.front();
+    EXPECT_EQ(production.lhs, x);
+    ASSERT_THAT(compactGrammar.getRhs(production), testing::ElementsAre(a, x1, x));
+    EXPECT_EQ(compactGrammar.start, x);
+}
+
+TEST(toCompact, TestsThatMissingStartIsAnError)
+{
+    Grammar grammar = {
+        {"E", {"E+T", "T"}},
+        {"T", {"a"}},
+    };
+
+    EXPECT_THROW(toCompact(grammar), std::invalid_argument);
+    EXPECT_THROW(toCompact(grammar, "a"), std::invalid_argument);
+    EXPECT_EQ(toCompact(grammar, "E").start, toCompact(grammar, "E").symbols.find("E"));
+    EXPECT_EQ(toCompactWithoutStart(grammar).start, noSymbol);
+    EXPECT_EQ(toCompact(Grammar()).start, noSymbol);
+}
+
+TEST(toCompact, TestsThatEpsilonIsEmptyRule)
+{
+    Grammar grammar = {
+        {"S", {"aS", epsilon}},
+    };
+
+    auto compactGrammar = toCompact(grammar);
+    ASSERT_EQ(compactGrammar.productions.size(), 2);
+    EXPECT_TRUE(compactGrammar.getRhs(compactGrammar.productions[0]).empty());
+    EXPECT_EQ(compactGrammar.getRhs(compactGrammar.productions[1]).size(), 2);
+}
+
+TEST(toGrammar, TestsThatRoundTripKeepsGrammar)
+{
+    Grammar grammar = {
+        {"S", {"aXbX", "aZ"}},
+        {"X", {"aY", "bY", epsilon}},
+        {"Y", {"X", "cc"}},
+        {"Z", {"ZX"}},
+    };
+
+    EXPECT_EQ(toGrammar(toCompact(grammar)), grammar);
+}
+
+TEST(SymbolTable, TestsThatFreshNontermIsUnique)
+{
+    SymbolTable symbols;
+    auto s = symbols.intern("S", true);
+    symbols.intern("S'", true);
+
+    auto fresh = symbols.fresh(s);
+    EXPECT_EQ(symbols.getName(fresh), "S''");
+    EXPECT_TRUE(symbols.isNonterm(fresh));
+
+    auto copy = symbols;
+    EXPECT_EQ(copy.find("S''"), fresh);
+}
+
+TEST(CompactGrammar, TestsThatNormalizeDropsDuplicates)
+{
+    CompactGrammar grammar;
+    auto s = grammar.symbols.intern("S", true);
+    auto a = grammar.symbols.intern("a", false);
+
+    grammar.addProduction(s, std::vector<SymbolId>{a, s});
+    grammar.addProduction(s, std::vector<SymbolId>{a});
+    grammar.addProduction(s, std::vector<SymbolId>{a, s});
+    grammar.normalize();
+
+    ASSERT_EQ(grammar.productions.size(), 2);
+    ASSERT_THAT(grammar.getRhs(grammar.productions[0]), testing::ElementsAre(a));
+    ASSERT_THAT(grammar.getRhs(grammar.productions[1]), testing::ElementsAre(a, s));
+    EXPECT_EQ(grammar.arena.size(), 3);
+}
+
+TEST(SymbolTable, TestsThatFreshCountsOnFromLastName)
+{
+    SymbolTable symbols;
+    auto s = symbols.intern("S", true);
+
+    EXPECT_EQ(symbols.getName(symbols.fresh(s)), "S'");
+    symbols.intern("S'''", true);
+    EXPECT_EQ(symbols.getName(symbols.fresh(s)), "S''");
+    EXPECT_EQ(symbols.getName(symbols.fresh(s)), "S''''");
+
+    auto copy = symbols;
+    EXPECT_EQ(copy.getName(copy.fresh(s)), "S'''''");
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
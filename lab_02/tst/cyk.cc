@@ -0,0 +1,91 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <string>
+
+#include "cyk.h"
+#include "utils.h"
+
+TEST(CykParser, TestsThatSentencesAreRecognized)
+{
+    Grammar grammar = {
+        {"S", {"aSb", epsilon}},
+    };
+
+    CykParser parser(toCompact(grammar));
+    ASSERT_TRUE(parser.parse("").accepted);
+    ASSERT_TRUE(parser.parse("ab").accepted);
+    ASSERT_TRUE(parser.parse("aaabbb").accepted);
+    ASSERT_FALSE(parser.parse("aab").accepted);
+    ASSERT_FALSE(parser.parse("ba").accepted);
+
+    auto result = parser.parse("abc");
+    ASSERT_FALSE(result.accepted);
+    ASSERT_EQ(result.errorPosition, 2);
+}
+
+TEST(CykParser, TestsThatLeftmostDerivationIsReturned)
+{
+    Grammar grammar = {
+        {"S", {"AB"}},
+        {"A", {"a"}},
+        {"B", {"b"}},
+    };
+
+    CykParser parser(toCompact(grammar));
+    auto result = parser.parse("ab");
+    ASSERT_TRUE(result.accepted);
+
+    const auto &compact = parser.getGrammar();
+    std::vector<std::string> rules;
+    for (auto &&production: result.derivation)
+    {
+        rules.push_back(compact.symbols.getName(compact.productions[production].lhs) + "->" +
+            toString(compact, compact.getRhs(compact.productions[production])));
+    }
+    ASSERT_THAT(rules, testing::ElementsAre("S->AB", "A->a", "B->b"));
+}
+
+TEST(CykParser, TestsThatAmbiguousGrammarsAreParsed)
+{
+    Grammar grammar = {
+        {"E", {"E+E", "E*E", "(E)", "i"}},
+    };
+
+    CykParser single(toCompact(grammar, "E"));
+    CykParser parallel(toCompact(grammar, "E"), 4);
+
+    std::string input = "i";
+    for (size_t i = 0; i < 300; ++i)
+    {
+        input += i % 3 ? "+i" : "*(i+i)";
+    }
+
+    auto result = single.parse(input);
+    ASSERT_TRUE(result.accepted);
+    ASSERT_TRUE(parallel.parse(input).accepted);
+    ASSERT_EQ(parallel.parse(input).derivation, result.derivation);
+
+    ASSERT_FALSE(single.parse(input + "+").accepted);
+    ASSERT_FALSE(parallel.parse("(" + input).accepted);
+}
+
+TEST(CykParser, TestsThatTablesAreReused)
+{
+    Grammar grammar = {
+        {"S", {"SS", "a"}},
+    };
+
+    CykParser parser(toCompact(grammar));
+    ASSERT_TRUE(parser.parse("aaaa").accepted);
+    ASSERT_TRUE(parser.parse("aaaa").accepted);
+    ASSERT_FALSE(parser.parse("aaba").accepted);
+    ASSERT_TRUE(parser.parse("a").accepted);
+    ASSERT_FALSE(parser.parse("").accepted);
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
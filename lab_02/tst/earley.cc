@@ -0,0 +1,199 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <algorithm>
+#include <limits>
+#include <random>
+#include <string>
+
+#include "cyk.h"
+#include "earley.h"
+#include "utils.h"
+
+static std::vector<std::string> toRules(const CompactGrammar &grammar, const ParseResult &result)
+{
+    std::vector<std::string> rules;
+    for (auto &&production: result.derivation)
+    {
+        auto rhs = grammar.getRhs(grammar.productions[production]);
+        rules.push_back(grammar.symbols.getName(grammar.productions[production].lhs) + "->" +
+            (rhs.empty() ? epsilon : toString(grammar, rhs)));
+    }
+    return rules;
+}
+
+// replays a leftmost derivation from the start symbol
+static std::string derive(const CompactGrammar &grammar, const ParseResult &parse)
+{
+    std::vector<SymbolId> sentence = {grammar.start};
+    for (auto &&production: parse.derivation)
+    {
+        auto it = std::find_if(std::begin(sentence), std::end(sentence),
+            [&](auto &&symbol) { return grammar.symbols.isNonterm(symbol); });
+        if (it == std::end(sentence) || *it != grammar.productions[production].lhs)
+        {
+            return "invalid derivation";
+        }
+
+        auto rhs = grammar.getRhs(grammar.productions[production]);
+        it = sentence.erase(it);
+        sentence.insert(it, rhs.begin(), rhs.end());
+    }
+
+    std::string result;
+    for (auto &&symbol: sentence)
+    {
+        result += grammar.symbols.getName(symbol);
+    }
+    return result;
+}
+
+TEST(EarleyParser, TestsThatEpsilonRulesAreHandled)
+{
+    Grammar grammar = {
+        {"S", {"AB"}},
+        {"A", {"a", epsilon}},
+        {"B", {"b", epsilon}},
+    };
+
+    EarleyParser parser(toCompact(grammar));
+    for (auto &&input: {"", "a", "b", "ab"})
+    {
+        ASSERT_TRUE(parser.parse(input).accepted) << input;
+        ASSERT_TRUE(parser.recognize(input)) << input;
+        ASSERT_EQ(parser.getForest().countTrees(), 1);
+    }
+
+    auto result = parser.parse("ba");
+    ASSERT_FALSE(result.accepted);
+    ASSERT_EQ(result.errorPosition, 1);
+    ASSERT_FALSE(parser.recognize("ba"));
+}
+
+TEST(EarleyParser, TestsThatLeftmostDerivationIsReturned)
+{
+    Grammar grammar = {
+        {"S", {"AB"}},
+        {"A", {"a", epsilon}},
+        {"B", {"Bb", epsilon}},
+    };
+
+    EarleyParser parser(toCompact(grammar));
+    auto result = parser.parse("abb");
+    ASSERT_TRUE(result.accepted);
+    ASSERT_THAT(toRules(parser.getGrammar(), result),
+        testing::ElementsAre("S->AB", "A->a", "B->Bb", "B->Bb", "B->?"));
+}
+
+TEST(EarleyParser, TestsThatAmbiguityIsShared)
+{
+    Grammar grammar = {
+        {"E", {"E+E", "i"}},
+    };
+
+    EarleyParser parser(toCompact(grammar, "E"));
+
+    // Catalan numbers of binary bracketings
+    std::string input = "i";
+    for (size_t trees: {1, 1, 2, 5, 14, 42, 132})
+    {
+        ASSERT_TRUE(parser.parse(input).accepted);
+        ASSERT_EQ(parser.getForest().countTrees(), trees) << input;
+        input += "+i";
+    }
+
+    // exponentially many trees, a polynomial forest
+    input = "i";
+    for (size_t i = 0; i < 200; ++i)
+    {
+        input += "+i";
+    }
+    ASSERT_TRUE(parser.parse(input).accepted);
+    ASSERT_EQ(parser.getForest().countTrees(), std::numeric_limits<size_t>::max());
+    ASSERT_LT(parser.getForest().getFamilyCount(), 201 * 201 * 201);
+
+    auto result = parser.parse("i+*i");
+    ASSERT_FALSE(result.accepted);
+    ASSERT_EQ(result.errorPosition, 2);
+}
+
+TEST(EarleyParser, TestsThatCyclicGrammarsHaveInfiniteForests)
+{
+    Grammar grammar = {
+        {"S", {"SS", "a", epsilon}},
+    };
+
+    EarleyParser parser(toCompact(grammar));
+    ASSERT_TRUE(parser.parse("aa").accepted);
+    ASSERT_TRUE(parser.recognize("aa"));
+    ASSERT_EQ(parser.getForest().countTrees(), std::numeric_limits<size_t>::max());
+}
+
+TEST(EarleyParser, TestsThatRightRecursionStaysLinear)
+{
+    Grammar grammar = {
+        {"S", {"aS", "a"}},
+    };
+
+    EarleyParser parser(toCompact(grammar));
+    std::string input(20000, 'a');
+
+    ASSERT_TRUE(parser.recognize(input));
+    ASSERT_LT(parser.getChartSize(), input.size() * 8);
+    ASSERT_FALSE(parser.recognize(input + "b"));
+}
+
+TEST(EarleyParser, TestsThatParsersAgreeOnRandomGrammars)
+{
+    static constexpr char symbols[] = {'S', 'A', 'B', 'a', 'b'};
+
+    std::mt19937 random(20191201);
+    auto uniform = [&](size_t from, size_t to) {
+        return std::uniform_int_distribution<size_t>(from, to)(random);
+    };
+
+    for (size_t g = 0; g < 200; ++g)
+    {
+        Grammar grammar;
+        for (auto &&nonterm: {"S", "A", "B"})
+        {
+            for (size_t r = 0, count = uniform(1, 3); r < count; ++r)
+            {
+                std::string rule;
+                for (size_t k = 0, length = uniform(0, 3); k < length; ++k)
+                {
+                    rule += symbols[uniform(0, std::size(symbols) - 1)];
+                }
+                grammar[nonterm].insert(rule.empty() ? epsilon : rule);
+            }
+        }
+
+        auto compact = toCompact(grammar);
+        EarleyParser earley(compact);
+        CykParser cyk(compact);
+
+        for (size_t w = 0; w < 20; ++w)
+        {
+            std::string input;
+            for (size_t k = 0, length = uniform(0, 6); k < length; ++k)
+            {
+                input += "ab"[uniform(0, 1)];
+            }
+
+            auto expected = cyk.parse(input).accepted;
+            auto result = earley.parse(input);
+            ASSERT_EQ(result.accepted, expected) << input;
+            ASSERT_EQ(earley.recognize(input), expected) << input;
+            if (expected)
+            {
+                ASSERT_EQ(derive(compact, result), input);
+            }
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,103 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "chomskyutils.h"
+#include "grammarshard.h"
+#include "leftutils.h"
+#include "utils.h"
+
+// nonterminals A0..An with short rules over a, b and each other, some of them nullable
+static CompactGrammar makeRandomGrammar(size_t nonterms, unsigned seed)
+{
+    std::mt19937 random(seed);
+    CompactGrammar grammar;
+    std::vector<SymbolId> symbols = {
+        grammar.symbols.intern("a", false), grammar.symbols.intern("b", false)};
+    for (size_t i = 0; i < nonterms; ++i)
+    {
+        symbols.push_back(grammar.symbols.intern("A" + std::to_string(i), true));
+    }
+    grammar.start = symbols[2];
+
+    for (size_t i = 0; i < nonterms; ++i)
+    {
+        auto lhs = symbols[i + 2];
+        grammar.addProduction(lhs, std::vector<SymbolId>{symbols[random() % 2]});
+        for (size_t rule = random() % 4; rule-- > 0;)
+        {
+            std::vector<SymbolId> rhs(random() % 5);
+            for (auto &&symbol: rhs)
+            {
+                symbol = symbols[random() % symbols.size()];
+            }
+            grammar.addProduction(lhs, rhs);
+        }
+    }
+    return grammar;
+}
+
+TEST(GrammarShard, TestsThatFreshNamesFollowMergeOrder)
+{
+    CompactGrammar grammar;
+    auto a = grammar.symbols.intern("a", false);
+    auto s = grammar.symbols.intern("S", true);
+    grammar.start = s;
+
+    GrammarShard first(grammar.symbols.size());
+    auto x = first.fresh(s);
+    auto y = first.fresh(x);
+    first.addProduction(s, std::vector<SymbolId>{a, x});
+    first.addProduction(x, std::vector<SymbolId>{y});
+    first.addProduction(y, std::vector<SymbolId>{a});
+
+    GrammarShard second(grammar.symbols.size());
+    auto z = second.fresh(s);
+    second.addProduction(z, std::vector<SymbolId>{a});
+
+    first.mergeInto(grammar);
+    second.mergeInto(grammar);
+
+    Grammar expected = {
+        {"S", {"aS'"}},
+        {"S'", {"S''"}},
+        {"S''", {"a"}},
+        {"S'''", {"a"}},
+    };
+    EXPECT_EQ(toGrammar(grammar), expected);
+}
+
+TEST(GrammarShard, TestsThatThreadsDoNotChangeResults)
+{
+    auto grammar = makeRandomGrammar(2000, 42);
+
+    EXPECT_EQ(toGrammar(deleteLongRules(grammar, 4)), toGrammar(deleteLongRules(grammar)));
+    EXPECT_EQ(toGrammar(leftFactoring(grammar, 4)), toGrammar(leftFactoring(grammar)));
+
+    for (auto mode: {EpsilonElimination::Permutations, EpsilonElimination::Helpers})
+    {
+        auto sequential = removeEpsilonNonterms(grammar, mode);
+        auto parallel = removeEpsilonNonterms(grammar, mode, maxEpsilonExpansion, 4);
+        EXPECT_EQ(toGrammar(parallel), toGrammar(sequential));
+        EXPECT_EQ(parallel.arena, sequential.arena);
+    }
+}
+
+TEST(GrammarShard, TestsThatEmptyRangesAreMerged)
+{
+    auto grammar = makeRandomGrammar(3, 7);
+    EXPECT_EQ(toGrammar(leftFactoring(grammar, 16)), toGrammar(leftFactoring(grammar)));
+
+    CompactGrammar empty;
+    runSharded(empty, 0, 4, [](GrammarShard &, size_t, size_t) { FAIL(); });
+    EXPECT_TRUE(empty.productions.empty());
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,186 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <stdexcept>
+
+#include "lalr.h"
+
+static const Grammar expressions = {
+    {"E", {"E+T", "T"}},
+    {"T", {"T*F", "F"}},
+    {"F", {"(E)", "i"}},
+};
+
+static std::vector<std::string> toRules(const LalrTable &table, const ParseResult &result)
+{
+    const auto &grammar = table.getGrammar();
+
+    std::vector<std::string> rules;
+    for (auto &&production: result.derivation)
+    {
+        auto rhs = grammar.getRhs(grammar.productions[production]);
+        rules.push_back(grammar.symbols.getName(grammar.productions[production].lhs) + "->" +
+            (rhs.empty() ? epsilon : toString(grammar, rhs)));
+    }
+    return rules;
+}
+
+TEST(LalrTable, TestsThatLeftRecursiveGrammarIsLalr)
+{
+    auto table = makeLalrTable(expressions, "E");
+    ASSERT_TRUE(table.isLalr());
+    ASSERT_EQ(table.getStateCount(), 12);
+    ASSERT_LE(table.getActionRowCount(), table.getStateCount());
+}
+
+TEST(LalrTable, TestsThatLalrButNotSlrGrammarHasNoConflicts)
+{
+    Grammar grammar = {
+        {"S", {"L=R", "R"}},
+        {"L", {"*R", "i"}},
+        {"R", {"L"}},
+    };
+
+    ASSERT_TRUE(makeLalrTable(grammar).isLalr());
+}
+
+TEST(LalrTable, TestsThatMergedLookaheadsConflict)
+{
+    // LR(1) but not LALR(1): merging the two c states mixes d and e
+    Grammar grammar = {
+        {"S", {"aAd", "bBd", "aBe", "bAe"}},
+        {"A", {"c"}},
+        {"B", {"c"}},
+    };
+
+    auto table = makeLalrTable(grammar);
+    ASSERT_FALSE(table.isLalr());
+    ASSERT_EQ(table.getConflicts().size(), 2);
+    for (auto &&conflict: table.getConflicts())
+    {
+        ASSERT_EQ(conflict.kept.kind, LrActionKind::Reduce);
+        ASSERT_EQ(conflict.dropped.kind, LrActionKind::Reduce);
+    }
+    ASSERT_THROW(LalrParser parser(table), std::invalid_argument);
+}
+
+TEST(LalrTable, TestsThatShiftWinsOverReduce)
+{
+    Grammar grammar = {
+        {"E", {"E+E", "i"}},
+    };
+
+    auto table = makeLalrTable(grammar, "E");
+    ASSERT_EQ(table.getConflicts().size(), 1);
+
+    const auto &conflict = table.getConflicts().front();
+    ASSERT_EQ(conflict.kept.kind, LrActionKind::Shift);
+    ASSERT_EQ(conflict.dropped.kind, LrActionKind::Reduce);
+    ASSERT_THAT(table.toString(conflict), testing::HasSubstr("on +: shift"));
+    ASSERT_THAT(table.toString(conflict), testing::EndsWith("vs reduce E -> E+E"));
+}
+
+TEST(LalrTable, TestsThatThreadsDoNotChangeTables)
+{
+    auto single = makeLalrTable(expressions, "E", 1);
+    auto parallel = makeLalrTable(expressions, "E", 4);
+
+    ASSERT_EQ(single.getStateCount(), parallel.getStateCount());
+    for (StateId state = 0; state < single.getStateCount(); ++state)
+    {
+        for (size_t column = 0; column <= single.getEndColumn(); ++column)
+        {
+            auto x = single.getAction(state, column);
+            auto y = parallel.getAction(state, column);
+            ASSERT_EQ(x.kind, y.kind);
+            ASSERT_EQ(x.value, y.value);
+        }
+    }
+}
+
+TEST(LalrParser, TestsThatSentencesAreParsed)
+{
+    auto table = makeLalrTable(expressions, "E");
+    LalrParser parser(table);
+
+    auto result = parser.parse("i+i*i");
+    ASSERT_TRUE(result.accepted);
+    ASSERT_THAT(toRules(table, result),
+        testing::ElementsAre("F->i", "T->F", "E->T", "F->i", "T->F", "F->i", "T->T*F", "E->E+T"));
+
+    ASSERT_TRUE(parser.parse("((i))*i+i").accepted);
+}
+
+TEST(LalrParser, TestsThatErrorsAreLocated)
+{
+    auto table = makeLalrTable(expressions, "E");
+    LalrParser parser(table);
+
+    auto result = parser.parse("i+*i");
+    ASSERT_FALSE(result.accepted);
+    ASSERT_EQ(result.errorPosition, 2);
+
+    result = parser.parse("(i");
+    ASSERT_FALSE(result.accepted);
+    ASSERT_EQ(result.errorPosition, 2);
+
+    ASSERT_FALSE(parser.parse("").accepted);
+    ASSERT_FALSE(parser.parse("i?i").accepted);
+}
+
+TEST(LalrParser, TestsThatNullableRulesAreReduced)
+{
+    Grammar grammar = {
+        {"S", {"AaB"}},
+        {"A", {"Ab", epsilon}},
+        {"B", {"c", epsilon}},
+    };
+
+    auto table = makeLalrTable(grammar);
+    LalrParser parser(table);
+
+    ASSERT_TRUE(parser.parse("a").accepted);
+    ASSERT_TRUE(parser.parse("bbac").accepted);
+    ASSERT_FALSE(parser.parse("abc").accepted);
+}
+
+TEST(LalrTable, TestsThatLargeGrammarsAreBuilt)
+{
+    constexpr size_t count = 4000;
+
+    // E -> E+N0 | N0 over a binary tree of nonterminals: Ni -> 0N(2i+1) | 1N(2i+2),
+    // the leaves are x or a parenthesized E
+    auto name = [](size_t i) { return "N" + std::to_string(i); };
+
+    Grammar grammar = {{"E", {"E+" + name(0), name(0)}}};
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (2 * i + 2 < count)
+        {
+            grammar[name(i)] = {"0" + name(2 * i + 1), "1" + name(2 * i + 2)};
+        }
+        else
+        {
+            grammar[name(i)] = {"x", "(E)"};
+        }
+    }
+
+    auto table = makeLalrTable(grammar, "E", 2);
+    ASSERT_TRUE(table.isLalr());
+
+    std::string leftmost;
+    for (size_t i = 0; 2 * i + 2 < count; i = 2 * i + 1)
+    {
+        leftmost += "0";
+    }
+
+    LalrParser parser(table);
+    ASSERT_TRUE(parser.parse(leftmost + "x+" + leftmost + "(" + leftmost + "x)").accepted);
+    ASSERT_FALSE(parser.parse(leftmost + "0x").accepted);
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
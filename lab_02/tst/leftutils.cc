@@ -16,6 +16,62 @@ TEST(eliminateLeftRecursion, TestsThatLeftRecursionIsEliminated)
     ASSERT_THAT(newGrammar["S'"], testing::ElementsAre("ac", "acS'", "b", "bS'"));
 }
 
+TEST(eliminateLeftRecursion, TestsThatInPlaceVersionReportsGrowth)
+{
+    Grammar grammar = {
+        {"A", {"Sa"}},
+        {"S", {"Sb", "Ac", "b", epsilon}},
+    };
+
+    auto compact = toCompact(grammar);
+    auto stats = eliminateLeftRecursionInPlace(compact);
+    EXPECT_EQ(toGrammar(compact), eliminateLeftRecursion(grammar));
+
+    // without epsilon rules A -> Sa | a, S -> Sb | Ac | b; S -> Ac becomes S -> Sac | ac
+    EXPECT_EQ(stats.productionsBefore, 5);
+    EXPECT_EQ(stats.substitutions, 1);
+    EXPECT_EQ(stats.substituted, 2);
+    EXPECT_EQ(stats.newNonterms, 1);
+    EXPECT_EQ(stats.productionsAfter, compact.productions.size());
+}
+
+TEST(eliminateLeftRecursion, TestsThatSubstitutedDuplicatesAreDropped)
+{
+    // every A(i) starts with all earlier ones, substitution keeps producing the same rules
+    CompactGrammar grammar;
+    auto a = grammar.symbols.intern("a", false);
+    std::vector<SymbolId> nonterms;
+    for (size_t i = 0; i < 100; ++i)
+    {
+        nonterms.push_back(grammar.symbols.intern("A" + std::to_string(i), true));
+    }
+    grammar.start = nonterms.back();
+
+    for (size_t i = 0; i < nonterms.size(); ++i)
+    {
+        grammar.addProduction(nonterms[i], std::vector<SymbolId>{a});
+        for (size_t j = 0; j < i; ++j)
+        {
+            grammar.addProduction(nonterms[i], std::vector<SymbolId>{nonterms[j], a});
+        }
+    }
+
+    auto stats = eliminateLeftRecursionInPlace(grammar);
+    EXPECT_GT(stats.duplicates, 0);
+    EXPECT_EQ(stats.newNonterms, 0);
+
+    // A(i) derives a^1 .. a^(i + 1) and nothing is left recursive
+    auto byLhs = grammar.groupByLhs();
+    EXPECT_EQ(byLhs[nonterms.back()].size(), nonterms.size());
+    for (auto &&production: grammar.productions)
+    {
+        for (auto &&symbol: grammar.getRhs(production))
+        {
+            EXPECT_EQ(symbol, a);
+        }
+    }
+}
+
 TEST(leftFactoring, TestsThatLeftFactoringIsCorrect)
 {
     Grammar grammar = {
@@ -24,9 +80,8 @@ TEST(leftFactoring, TestsThatLeftFactoringIsCorrect)
     };
 
     auto newGrammar = leftFactoring(eliminateLeftRecursion(grammar));
-    ASSERT_THAT(newGrammar["A"], testing::ElementsAre("SaA'", "aA''"));
-    ASSERT_THAT(newGrammar["A'"], testing::ElementsAre("?"));
-    ASSERT_THAT(newGrammar["A''"], testing::ElementsAre("?"));
+    ASSERT_THAT(newGrammar["A"], testing::ElementsAre("Sa", "a"));
+    ASSERT_EQ(newGrammar.count("A'"), 0);
     ASSERT_THAT(newGrammar["S"], testing::ElementsAre("acS''", "bS'''"));
     ASSERT_THAT(newGrammar["S'"], testing::ElementsAre("acS''''", "bS'''''"));
     ASSERT_THAT(newGrammar["S''"], testing::ElementsAre("?", "S'"));
@@ -35,6 +90,46 @@ TEST(leftFactoring, TestsThatLeftFactoringIsCorrect)
     ASSERT_THAT(newGrammar["S'''''"], testing::ElementsAre("?", "S'"));
 }
 
+TEST(leftFactoring, TestsThatAllLevelsAreFactored)
+{
+    Grammar grammar = {
+        {"S", {"abc", "abd", "ab", "ae", "f"}},
+    };
+
+    auto newGrammar = leftFactoring(grammar);
+    ASSERT_THAT(newGrammar["S"], testing::ElementsAre("aS'", "f"));
+    ASSERT_THAT(newGrammar["S'"], testing::ElementsAre("bS''", "e"));
+    ASSERT_THAT(newGrammar["S''"], testing::ElementsAre("?", "c", "d"));
+}
+
+TEST(leftFactoring, TestsThatManyKeywordsAreFactoredQuickly)
+{
+    CompactGrammar grammar;
+    grammar.start = grammar.symbols.intern("S", true);
+
+    std::vector<SymbolId> letters;
+    for (auto c = 'a'; c <= 'z'; ++c)
+    {
+        letters.push_back(grammar.symbols.intern(std::string(1, c), false));
+    }
+
+    // every keyword of three letters, all sharing prefixes with 25 others
+    for (auto &&x: letters)
+    {
+        for (auto &&y: letters)
+        {
+            for (auto &&z: letters)
+            {
+                grammar.addProduction(grammar.start, std::vector<SymbolId>{x, y, z});
+            }
+        }
+    }
+
+    auto newGrammar = leftFactoring(grammar);
+    EXPECT_EQ(newGrammar.productions.size(), 26 + 26 * 26 + 26 * 26 * 26);
+    EXPECT_EQ(newGrammar.symbols.size(), grammar.symbols.size() + 26 + 26 * 26);
+}
+
 int main(int argc, char **argv)
 {
     ::testing::InitGoogleTest(&argc, argv);
@@ -0,0 +1,130 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <stdexcept>
+
+#include "ll1.h"
+
+static const Grammar expressions = {
+    {"E", {"E+T", "T"}},
+    {"T", {"T*F", "F"}},
+    {"F", {"(E)", "i"}},
+};
+
+TEST(Ll1Table, TestsThatLeftRecursiveGrammarBecomesLl1)
+{
+    auto table = makeLl1Table(expressions, "E");
+    ASSERT_TRUE(table.isLl1());
+
+    const auto &grammar = table.getGrammar();
+    auto production = table.getProduction(grammar.symbols.find("F"), grammar.symbols.find("("));
+    ASSERT_NE(production, noProduction);
+    ASSERT_THAT(toString(grammar, grammar.getRhs(grammar.productions[production])),
+        testing::StartsWith("(E)"));
+    ASSERT_EQ(table.getProduction(grammar.symbols.find("F"), grammar.symbols.find("+")),
+        noProduction);
+}
+
+TEST(Ll1Table, TestsThatConflictsAreReported)
+{
+    Grammar grammar = {
+        {"S", {"ab", "ac"}},
+    };
+
+    Ll1Table table(toCompact(grammar));
+    ASSERT_FALSE(table.isLl1());
+    ASSERT_EQ(table.getConflicts().size(), 1);
+    ASSERT_EQ(table.toString(table.getConflicts().front()), "S on a: S -> ab vs S -> ac");
+    ASSERT_THROW(Ll1Parser parser(table), std::invalid_argument);
+
+    ASSERT_TRUE(makeLl1Table(grammar).isLl1());
+}
+
+TEST(Ll1Table, TestsThatNullableRulesArePredictedByFollow)
+{
+    Grammar grammar = {
+        {"S", {"Ab"}},
+        {"A", {"a", epsilon}},
+    };
+
+    Ll1Table table(toCompact(grammar));
+    const auto &compact = table.getGrammar();
+    auto a = compact.symbols.find("A");
+
+    ASSERT_TRUE(table.isLl1());
+
+    auto production = table.getProduction(a, compact.symbols.find("b"));
+    ASSERT_TRUE(compact.getRhs(compact.productions[production]).empty());
+    ASSERT_EQ(table.getProduction(a, noSymbol), noProduction);
+}
+
+TEST(Ll1Parser, TestsThatSentencesAreAccepted)
+{
+    auto table = makeLl1Table(expressions, "E");
+    Ll1Parser parser(table);
+
+    ASSERT_TRUE(parser.parse("i").accepted);
+    ASSERT_TRUE(parser.parse("i+i*i").accepted);
+    ASSERT_TRUE(parser.parse("(i+i)*(i)").accepted);
+}
+
+TEST(Ll1Parser, TestsThatErrorsAreLocated)
+{
+    auto table = makeLl1Table(expressions, "E");
+    Ll1Parser parser(table);
+
+    auto result = parser.parse("i+*i");
+    ASSERT_FALSE(result.accepted);
+    ASSERT_EQ(result.errorPosition, 2);
+
+    result = parser.parse("(i");
+    ASSERT_FALSE(result.accepted);
+    ASSERT_EQ(result.errorPosition, 2);
+
+    result = parser.parse("i-i");
+    ASSERT_FALSE(result.accepted);
+    ASSERT_EQ(result.errorPosition, 1);
+
+    ASSERT_FALSE(parser.parse("").accepted);
+    ASSERT_FALSE(parser.parse("ii").accepted);
+}
+
+TEST(Ll1Parser, TestsThatLeftmostDerivationIsReturned)
+{
+    Grammar grammar = {
+        {"S", {"aS", "b"}},
+    };
+
+    Ll1Table table(toCompact(grammar));
+    Ll1Parser parser(table);
+
+    auto result = parser.parse("aab");
+    ASSERT_TRUE(result.accepted);
+
+    const auto &compact = table.getGrammar();
+    std::vector<std::string> rules;
+    for (auto &&production: result.derivation)
+    {
+        rules.push_back(toString(compact, compact.getRhs(compact.productions[production])));
+    }
+    ASSERT_THAT(rules, testing::ElementsAre("aS", "aS", "b"));
+}
+
+TEST(Ll1Parser, TestsThatLongInputsAreParsed)
+{
+    auto table = makeLl1Table(expressions, "E");
+    Ll1Parser parser(table);
+
+    std::string input = "i";
+    for (size_t i = 0; i < 100000; ++i)
+    {
+        input += i % 2 ? "+(i)" : "*i";
+    }
+    ASSERT_TRUE(parser.parse(input).accepted);
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,195 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "analysis.h"
+#include "chomskyutils.h"
+#include "leftutils.h"
+#include "passmanager.h"
+
+// FIRST of every nonterminal by terminal names, from the manager or from scratch
+static std::vector<std::vector<std::string>> firstNames(PassManager &manager)
+{
+    const auto &grammar = manager.getGrammar();
+    std::vector<std::vector<std::string>> result;
+    for (SymbolId nonterm = 0; nonterm < grammar.symbols.size(); ++nonterm)
+    {
+        if (!grammar.symbols.isNonterm(nonterm))
+        {
+            continue;
+        }
+
+        auto &names = result.emplace_back();
+        for (SymbolId terminal = 0; terminal < grammar.symbols.size(); ++terminal)
+        {
+            if (!grammar.symbols.isNonterm(terminal) &&
+                manager.getFirst(nonterm).test(manager.getTerminalIndex(terminal)))
+            {
+                names.push_back(grammar.symbols.getName(terminal));
+            }
+        }
+        std::sort(std::begin(names), std::end(names));
+    }
+    return result;
+}
+
+static std::vector<std::vector<std::string>> firstNames(const CompactGrammar &grammar)
+{
+    GrammarAnalysis analysis(grammar);
+    std::vector<std::vector<std::string>> result;
+    for (SymbolId nonterm = 0; nonterm < grammar.symbols.size(); ++nonterm)
+    {
+        if (grammar.symbols.isNonterm(nonterm))
+        {
+            auto names = analysis.getNames(analysis.getFirst(nonterm));
+            std::sort(std::begin(names), std::end(names));
+            result.push_back(std::move(names));
+        }
+    }
+    return result;
+}
+
+TEST(PassManager, TestsThatPipelineMatchesCopyingPasses)
+{
+    Grammar grammar = {
+        {"S", {"aXbX", "aZ", "Y"}},
+        {"X", {"aY", "bY", epsilon}},
+        {"Y", {"X", "cc"}},
+        {"Z", {"ZX"}},
+        {"W", {"w"}},
+    };
+    auto compact = toCompact(grammar);
+
+    PassManager manager(compact);
+    manager.removeUselessSymbols().removeEpsilonNonterms().run(deleteChainRules);
+
+    auto expected = deleteChainRules(removeEpsilonNonterms(removeUselessSymbols(compact)));
+    EXPECT_EQ(toGrammar(manager.getGrammar()), toGrammar(expected));
+    EXPECT_EQ(toGrammar(manager.release()), toGrammar(expected));
+}
+
+TEST(PassManager, TestsThatCachedAnalysesStayCorrect)
+{
+    Grammar grammar = {
+        {"S", {"AB", "Cd"}},
+        {"A", {"aA", epsilon}},
+        {"B", {"bB", "C"}},
+        {"C", {"c", epsilon}},
+    };
+
+    PassManager manager(toCompact(grammar));
+    EXPECT_EQ(firstNames(manager), firstNames(manager.getGrammar()));
+
+    auto nullable = findEpsilonNonterms(manager.getGrammar());
+    EXPECT_EQ(manager.getNullable(), nullable);
+
+    // C loses its epsilon rule and gets a new terminal, S, B and C go stale
+    manager.run([](PassManager &, CompactGrammar &grammar, std::vector<SymbolId> &touched) {
+        auto c = grammar.symbols.find("C");
+        auto e = grammar.symbols.intern("e", false);
+        auto newGrammar = makeEmptyCopy(grammar);
+        for (auto &&production: grammar.productions)
+        {
+            auto rhs = grammar.getRhs(production);
+            if (production.lhs != c || !rhs.empty())
+            {
+                newGrammar.addProduction(production.lhs, rhs.begin(), rhs.end());
+            }
+        }
+        newGrammar.addProduction(c, std::vector<SymbolId>{e});
+        grammar = std::move(newGrammar);
+        touched.push_back(c);
+    });
+
+    EXPECT_EQ(manager.getNullable(), findEpsilonNonterms(manager.getGrammar()));
+    EXPECT_EQ(firstNames(manager), firstNames(manager.getGrammar()));
+
+    manager.removeEpsilonNonterms();
+    EXPECT_EQ(manager.getNullable(), findEpsilonNonterms(manager.getGrammar()));
+    EXPECT_EQ(firstNames(manager), firstNames(manager.getGrammar()));
+}
+
+TEST(PassManager, TestsThatOnlyDependentsAreRecomputed)
+{
+    CompactGrammar grammar;
+    auto a = grammar.symbols.intern("a", false);
+    auto b = grammar.symbols.intern("b", false);
+
+    // 1000 chains N(i, 0) -> N(i, 1) -> ... -> N(i, 9) -> a
+    std::vector<SymbolId> heads;
+    for (size_t i = 0; i < 1000; ++i)
+    {
+        SymbolId next = a;
+        for (size_t k = 10; k-- > 0;)
+        {
+            auto name = "N" + std::to_string(i) + "_" + std::to_string(k);
+            auto nonterm = grammar.symbols.intern(name, true);
+            grammar.addProduction(nonterm, std::vector<SymbolId>{next});
+            next = nonterm;
+        }
+        heads.push_back(next);
+    }
+    grammar.start = heads.front();
+    auto tail = grammar.symbols.find("N7_9");
+
+    PassManager manager(std::move(grammar));
+    manager.getNullable();
+    auto full = manager.getRecomputedCount();
+    EXPECT_EQ(full, 10000);
+
+    // the last link of one chain may start with b now
+    manager.run([&](PassManager &, CompactGrammar &grammar, std::vector<SymbolId> &touched) {
+        grammar.addProduction(tail, std::vector<SymbolId>{b});
+        touched.push_back(tail);
+    });
+
+    EXPECT_TRUE(manager.getFirst(heads[7]).test(manager.getTerminalIndex(b)));
+    EXPECT_FALSE(manager.getFirst(heads[8]).test(manager.getTerminalIndex(b)));
+    EXPECT_EQ(manager.getRecomputedCount() - full, 10);
+}
+
+TEST(PassManager, TestsThatSharedPassesMatchCopyingPasses)
+{
+    Grammar grammar = {
+        {"S", {"SaX", "XbXc", "d"}},
+        {"X", {"Xa", "XSe", "e", epsilon}},
+        {"W", {"w"}},
+    };
+    auto compact = toCompact(grammar);
+
+    PassManager manager(compact);
+    manager.eliminateLeftRecursion();
+    EXPECT_EQ(toGrammar(manager.getGrammar()), toGrammar(eliminateLeftRecursion(compact)));
+    EXPECT_EQ(manager.getNullable(), findEpsilonNonterms(manager.getGrammar()));
+    EXPECT_EQ(firstNames(manager), firstNames(manager.getGrammar()));
+
+    manager.deleteLongRules();
+    EXPECT_EQ(toGrammar(manager.getGrammar()),
+        toGrammar(deleteLongRules(eliminateLeftRecursion(compact))));
+    EXPECT_EQ(manager.getNullable(), findEpsilonNonterms(manager.getGrammar()));
+    EXPECT_EQ(firstNames(manager), firstNames(manager.getGrammar()));
+}
+
+TEST(PassManager, TestsThatFailedPassKeepsGrammar)
+{
+    Grammar grammar = {
+        {"S", {"XXXXXXXXXXXXXXXXX"}},
+        {"X", {"x", epsilon}},
+    };
+
+    // 17 nullable symbols in one rule are over the limit
+    PassManager manager(toCompact(grammar));
+    EXPECT_THROW(manager.removeEpsilonNonterms(), std::length_error);
+    EXPECT_EQ(toGrammar(manager.getGrammar()), grammar);
+    EXPECT_EQ(manager.getNullable(), findEpsilonNonterms(manager.getGrammar()));
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,155 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "analysis.h"
+#include "earley.h"
+#include "ll1.h"
+#include "staticgrammar.h"
+
+static constexpr auto expressions = parseStaticGrammar("E -> E+T | T; T -> T*F | F; F -> (E) | i");
+static constexpr auto withoutRecursion = eliminateStaticLeftRecursion(expressions);
+static constexpr auto expressionTable = StaticLl1Table(withoutRecursion);
+
+// all of it is done by the compiler
+static_assert(expressions.symbolCount == 8 && expressions.productionCount == 6);
+static_assert(!StaticLl1Table(expressions).isLl1());
+static_assert(expressionTable.isLl1());
+static_assert(expressionTable.accepts("i+i*i"));
+static_assert(expressionTable.accepts("(i+i)*i"));
+static_assert(!expressionTable.accepts("i+"));
+static_assert(!expressionTable.accepts("i)"));
+static_assert(!expressionTable.accepts("iE"));
+
+// names of the terminals of a mask in name order, the end marker as "$"
+template<typename GrammarType>
+static std::vector<std::string> toNames(const GrammarType &grammar, std::uint64_t set)
+{
+    auto compact = toCompact(grammar);
+    std::vector<std::string> names;
+    for (size_t bit = 0; bit < 64; ++bit)
+    {
+        if (set >> bit & 1)
+        {
+            names.push_back(bit == 63 ? endMarker : compact.symbols.getName(bit));
+        }
+    }
+    std::sort(std::begin(names), std::end(names));
+    return names;
+}
+
+static std::vector<std::string> sorted(std::vector<std::string> names)
+{
+    std::sort(std::begin(names), std::end(names));
+    return names;
+}
+
+TEST(StaticGrammar, TestsThatGrammarConvertsToCompact)
+{
+    Grammar expected = {
+        {"E", {"E+T", "T"}},
+        {"T", {"T*F", "F"}},
+        {"F", {"(E)", "i"}},
+    };
+    EXPECT_EQ(toGrammar(toCompact(expressions)), expected);
+
+    Grammar withoutRecursionExpected = {
+        {"E", {"TE'"}},
+        {"E'", {"+TE'", epsilon}},
+        {"T", {"FT'"}},
+        {"T'", {"*FT'", epsilon}},
+        {"F", {"(E)", "i"}},
+    };
+    EXPECT_EQ(toGrammar(toCompact(withoutRecursion)), withoutRecursionExpected);
+}
+
+TEST(StaticGrammar, TestsThatAnalysisMatchesRuntimeAnalysis)
+{
+    static constexpr auto grammar = parseStaticGrammar(R"(
+        S -> AB | Cd
+        A -> aA | ?
+        B -> bB | C
+        C -> c | ?
+    )");
+    static constexpr auto analysis = StaticAnalysis(grammar);
+    static_assert(analysis.nullable[grammar.find('S')]);
+
+    auto compact = toCompact(grammar);
+    GrammarAnalysis expected(compact);
+    for (SymbolId symbol = 0; symbol < compact.symbols.size(); ++symbol)
+    {
+        if (!compact.symbols.isNonterm(symbol))
+        {
+            continue;
+        }
+
+        EXPECT_EQ(analysis.nullable[symbol], expected.isNullable(symbol));
+        EXPECT_EQ(toNames(grammar, analysis.first[symbol]),
+            sorted(expected.getNames(expected.getFirst(symbol))));
+        EXPECT_EQ(toNames(grammar, analysis.follow[symbol]),
+            sorted(expected.getNames(expected.getFollow(symbol))));
+    }
+}
+
+TEST(StaticGrammar, TestsThatIndirectRecursionIsRemoved)
+{
+    static constexpr auto grammar = parseStaticGrammar("S -> Aa | b; A -> Ac | Sd | ?");
+    static constexpr auto result = eliminateStaticLeftRecursion(grammar);
+
+    // no rule starts with its own left side and the language stays the same
+    auto compact = toCompact(result);
+    for (auto &&production: compact.productions)
+    {
+        auto rhs = compact.getRhs(production);
+        EXPECT_TRUE(rhs.empty() || rhs[0] != production.lhs);
+    }
+
+    auto original = toCompact(grammar);
+    EarleyParser before(original);
+    EarleyParser after(compact);
+    for (auto input: {"b", "a", "ca", "bda", "ada", "cbda", "bdacca", "bd", "ab", ""})
+    {
+        EXPECT_EQ(after.parse(input).accepted, before.parse(input).accepted) << input;
+    }
+}
+
+TEST(StaticGrammar, TestsThatTableMatchesRuntimeTable)
+{
+    auto compact = toCompact(withoutRecursion);
+    Ll1Table runtime(compact);
+
+    for (SymbolId nonterm = 0; nonterm < compact.symbols.size(); ++nonterm)
+    {
+        if (!compact.symbols.isNonterm(nonterm))
+        {
+            continue;
+        }
+        for (SymbolId terminal = 0; terminal < compact.symbols.size(); ++terminal)
+        {
+            if (!compact.symbols.isNonterm(terminal))
+            {
+                auto expected = runtime.getProduction(nonterm, terminal);
+                auto production = expressionTable.getProduction(nonterm, terminal);
+                EXPECT_EQ(production == noStaticProduction ? noProduction : production, expected);
+            }
+        }
+        auto end = expressionTable.getProduction(nonterm, noStaticSymbol);
+        EXPECT_EQ(end == noStaticProduction ? noProduction : end,
+            runtime.getProduction(nonterm, noSymbol));
+    }
+}
+
+TEST(StaticGrammar, TestsThatBadInputThrowsAtRunTime)
+{
+    EXPECT_THROW(parseStaticGrammar("S a"), std::invalid_argument);
+    EXPECT_THROW((parseStaticGrammar<2>("S -> abc")), std::length_error);
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -85,6 +85,31 @@ TEST(findEpsilonNonterms, TestsThatAllEpsilonNonTermsAreFound)
     ASSERT_THAT(findEpsilonNonterms(grammar), testing::ElementsAre("A", "B", "C"));
 }
 
+TEST(findEpsilonNonterms, TestsThatSharedRulesAreNotLost)
+{
+    Grammar grammar = {
+        {"A", {"BC"}},
+        {"B", {"b", epsilon}},
+        {"C", {"BB"}},
+        {"D", {"BC", "d"}},
+        {"X", {"X'"}},
+        {"X'", {"xX", epsilon}},
+    };
+
+    ASSERT_THAT(findEpsilonNonterms(grammar), testing::ElementsAre("A", "B", "C", "D", "X", "X'"));
+}
+
+TEST(findEpsilonNonterms, TestsThatTermsAreNeverNullable)
+{
+    Grammar grammar = {
+        {"S", {"AaA", "AB"}},
+        {"A", {epsilon}},
+        {"B", {"SB", "b"}},
+    };
+
+    ASSERT_THAT(findEpsilonNonterms(grammar), testing::ElementsAre("A"));
+}
+
 TEST(findAllPermutations, TestsThatAllPermutationsAreFound)
 {
     Grammar grammar = {
@@ -131,6 +156,136 @@ TEST(removeEpsilonNonterms, TestsThatEpsilonNonTermsAreRemoved2)
     ASSERT_THAT(newGrammar["C"], testing::ElementsAre("c"));
 }
 
+TEST(removeEpsilonNonterms, TestsThatHelpersShareSuffixes)
+{
+    Grammar grammar = {
+        {"S", {"aAB"}},
+        {"A", {"a", epsilon}},
+        {"B", {"b", epsilon}},
+    };
+
+    auto newGrammar =
+        toGrammar(removeEpsilonNonterms(toCompact(grammar), EpsilonElimination::Helpers));
+    ASSERT_THAT(newGrammar["S"], testing::ElementsAre("a", "aA", "aAS'", "aS'"));
+    ASSERT_THAT(newGrammar["S'"], testing::ElementsAre("B"));
+    ASSERT_THAT(newGrammar["A"], testing::ElementsAre("a"));
+    ASSERT_THAT(newGrammar["B"], testing::ElementsAre("b"));
+}
+
+TEST(removeEpsilonNonterms, TestsThatHelpersGrowLinearly)
+{
+    Grammar grammar = {
+        {"S", {std::string(20, 'A')}},
+        {"A", {"a", epsilon}},
+    };
+
+    auto compact = toCompact(grammar);
+    ASSERT_EQ(estimateEpsilonExpansion(compact), (size_t(1) << 20) + 1);
+
+    auto newGrammar = removeEpsilonNonterms(compact, EpsilonElimination::Helpers);
+    ASSERT_LT(newGrammar.productions.size(), 100);
+}
+
+TEST(removeEpsilonNonterms, TestsThatBlowUpIsReported)
+{
+    Grammar grammar = {
+        {"S", {std::string(20, 'A')}},
+        {"A", {"a", epsilon}},
+    };
+
+    auto compact = toCompact(grammar);
+    ASSERT_THROW(removeEpsilonNonterms(compact), std::length_error);
+    ASSERT_THROW(removeEpsilonNonterms(compact, EpsilonElimination::Permutations, 1000),
+        std::length_error);
+    ASSERT_NO_THROW(removeEpsilonNonterms(compact, EpsilonElimination::Helpers, 1000));
+}
+
+TEST(removeEpsilonNonterms, TestsThatLimitIsPerRule)
+{
+    // 100 rules expanding to 8 productions each are far more than 8 in total but fine
+    CompactGrammar grammar;
+    auto a = grammar.symbols.intern("a", false);
+    auto n = grammar.symbols.intern("N", true);
+    grammar.start = grammar.symbols.intern("S", true);
+    grammar.addProduction(n, std::vector<SymbolId>{a});
+    grammar.addProduction(n, std::vector<SymbolId>{});
+    for (size_t i = 0; i < 100; ++i)
+    {
+        auto x = grammar.symbols.intern("X" + std::to_string(i), true);
+        grammar.addProduction(grammar.start, std::vector<SymbolId>{x});
+        grammar.addProduction(x, std::vector<SymbolId>{a, n, n, n});
+    }
+
+    auto newGrammar = removeEpsilonNonterms(grammar, EpsilonElimination::Permutations, 8);
+    // a, aN, aNN and aNNN for every X, S -> X and N -> a
+    ASSERT_EQ(newGrammar.productions.size(), 100 * 4 + 100 + 1);
+
+    grammar.addProduction(grammar.start, std::vector<SymbolId>{n, n, n, n});
+    ASSERT_THROW(removeEpsilonNonterms(grammar, EpsilonElimination::Permutations, 8),
+        std::length_error);
+}
+
+TEST(removeUselessSymbols, TestsThatNonGeneratingRulesAreRemoved)
+{
+    Grammar grammar = {
+        {"S", {"aXbX", "aZ"}},
+        {"X", {"aY", "bY", epsilon}},
+        {"Y", {"X", "cc"}},
+        {"Z", {"ZX"}},
+    };
+
+    auto newGrammar = removeUselessSymbols(grammar);
+    ASSERT_THAT(newGrammar["S"], testing::ElementsAre("aXbX"));
+    ASSERT_EQ(newGrammar.count("Z"), 0);
+    ASSERT_EQ(newGrammar.size(), 3);
+}
+
+TEST(removeUselessSymbols, TestsThatUnreachableRulesAreRemoved)
+{
+    Grammar grammar = {
+        {"S", {"aA", "b"}},
+        {"A", {"B", "b"}},
+        {"B", {"C"}},
+        {"C", {"c"}},
+        {"D", {"dS"}},
+    };
+
+    // B only reaches C, D is never reached
+    auto newGrammar = removeUselessSymbols(grammar);
+    ASSERT_THAT(newGrammar, testing::ElementsAre(testing::Key("A"), testing::Key("B"),
+        testing::Key("C"), testing::Key("S")));
+
+    // without the generating C both B and the rule A -> B go
+    grammar["C"] = {"cC"};
+    newGrammar = removeUselessSymbols(grammar);
+    ASSERT_THAT(newGrammar["A"], testing::ElementsAre("b"));
+    ASSERT_EQ(newGrammar.count("B"), 0);
+    ASSERT_EQ(newGrammar.count("C"), 0);
+}
+
+TEST(removeUselessSymbols, TestsThatGrammarWithoutStartKeepsUnreachableRules)
+{
+    Grammar grammar = {
+        {"E", {"E+T", "T", epsilon}},
+        {"T", {"a"}},
+        {"A", {"b"}},
+        {"B", {"Bb"}},
+    };
+
+    // a Grammar names no start, only the non-generating B goes
+    auto newGrammar = removeUselessSymbols(grammar);
+    ASSERT_THAT(newGrammar,
+        testing::ElementsAre(testing::Key("A"), testing::Key("E"), testing::Key("T")));
+
+    newGrammar = removeUselessSymbols(grammar, "E");
+    ASSERT_THAT(newGrammar, testing::ElementsAre(testing::Key("E"), testing::Key("T")));
+
+    newGrammar = removeEpsilonNonterms(grammar);
+    ASSERT_THAT(newGrammar["E"], testing::UnorderedElementsAre("E+T", "+T", "T"));
+    ASSERT_THAT(newGrammar["T"], testing::ElementsAre("a"));
+    ASSERT_THAT(newGrammar["A"], testing::ElementsAre("b"));
+}
+
 int main(int argc, char **argv)
 {
     ::testing::InitGoogleTest(&argc, argv);
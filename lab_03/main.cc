@@ -33,7 +33,7 @@ struct MyVertex
 using Graph = boost::adjacency_list<boost::vecS, boost::vecS, boost::directedS, MyVertex>;
 using Grammar = std::map<std::string, std::vector<std::vector<std::string>>>;
 
-void printTree(const parser::detail::Node &tree)
+void printTree(const parser::Ast &ast)
 {
     Graph graph;
 
@@ -45,21 +45,21 @@ void printTree(const parser::detail::Node &tree)
     };
 
     size_t count = 0;
-    std::stack<std::pair<parser::detail::Node, size_t>> stack;
-    stack.push({tree, count});
+    std::stack<std::pair<parser::NodeId, size_t>> stack;
+    stack.push({ast.getRoot(), count});
 
     while (!stack.empty())
     {
         auto [n, num] = stack.top();
         stack.pop();
-        auto v = node(n.data + " " + std::to_string(num), num);
+        auto v = node(std::string(ast.getLabel(n)) + " " + std::to_string(num), num);
 
-        for (auto &&child: n.children)
+        for (auto &&child: ast.getChildren(n))
         {
             ++count;
             stack.push({child, count});
 
-            auto v_ = node(child.data + " " + std::to_string(count), count);
+            auto v_ = node(std::string(ast.getLabel(child)) + " " + std::to_string(count), count);
             boost::add_edge(v, v_, graph);
         }
     }
@@ -75,13 +75,15 @@ void printTree(const parser::detail::Node &tree)
 
 int main()
 {
-    std::string s = "{a=-b+const<(nota+b)*bdiva;{a=a<>a;{c=const}}}";
-    auto &&[tree, str] = parser::accept(s);
-    std::cout << str << std::endl;
+    std::string s = "{a = -b + const < (not a + b) * b div a; {a = a <> a; {c = const}}}";
+    parser::Trace trace;
+    auto ast = parser::parse(s, trace);
+    trace.flush();
+    std::cout << ast.getUnparsed() << std::endl;
 
-    if (tree && str.empty())
+    if (ast.getRoot() != parser::noNode && ast.getUnparsed().empty())
     {
-        printTree(*tree);
+        printTree(ast);
     }
 
     return 0;
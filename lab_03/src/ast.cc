@@ -0,0 +1,165 @@
+#include "ast.h"
+
+#include <array>
+
+namespace
+{
+constexpr std::array<std::string_view, 19> names = {
+    "Block",
+    "OperatorsList",
+    "Tail",
+    "Operator",
+    "Expression",
+    "SimpleExpression",
+    "Term",
+    "Factor",
+    "RelationOperation",
+    "Sign",
+    "AdditionOperation",
+    "MultiplicationOperation",
+    "Identifier",
+    "Constant",
+    "SimpleExpression'",
+    "Term'",
+    "Expression'",
+    "Token",
+    "ϵ",
+};
+}  // namespace
+
+std::string_view parser::toString(NodeKind kind)
+{
+    return names[static_cast<size_t>(kind)];
+}
+
+parser::Ast::Ast(std::string source) : source(std::move(source)), tokens(tokenize(this->source))
+{
+}
+
+const std::string &parser::Ast::getSource() const
+{
+    return source;
+}
+
+const std::vector<parser::Token> &parser::Ast::getTokens() const
+{
+    return tokens;
+}
+
+const parser::Token &parser::Ast::getToken(size_t index) const
+{
+    return tokens[index];
+}
+
+parser::NodeId parser::Ast::getRoot() const
+{
+    return root;
+}
+
+void parser::Ast::setRoot(NodeId root)
+{
+    this->root = root;
+}
+
+std::string_view parser::Ast::getUnparsed() const
+{
+    return std::string_view(source).substr(unparsed);
+}
+
+void parser::Ast::setUnparsed(size_t token)
+{
+    unparsed = tokens[token].offset;
+}
+
+parser::NodeKind parser::Ast::getKind(NodeId node) const
+{
+    return nodes[node].kind;
+}
+
+parser::Ast::Children parser::Ast::getChildren(NodeId node) const
+{
+    const auto &item = nodes[node];
+    if (item.kind == NodeKind::Token || item.kind == NodeKind::Epsilon)
+    {
+        return {nullptr, nullptr};
+    }
+    return {children.data() + item.begin, children.data() + item.begin + item.size};
+}
+
+std::string_view parser::Ast::getLabel(NodeId node) const
+{
+    const auto &item = nodes[node];
+    if (item.kind == NodeKind::Token)
+    {
+        return std::string_view(source).substr(item.begin, item.size);
+    }
+    return toString(item.kind);
+}
+
+size_t parser::Ast::size() const
+{
+    return nodes.size();
+}
+
+parser::NodeId parser::Ast::addToken(size_t token)
+{
+    nodes.push_back({NodeKind::Token, tokens[token].offset, tokens[token].size});
+    return static_cast<NodeId>(nodes.size() - 1);
+}
+
+parser::NodeId parser::Ast::addEpsilon()
+{
+    nodes.push_back({NodeKind::Epsilon, 0, 0});
+    return static_cast<NodeId>(nodes.size() - 1);
+}
+
+parser::NodeId parser::Ast::addNode(NodeKind kind, std::initializer_list<NodeId> nodeChildren)
+{
+    auto begin = static_cast<std::uint32_t>(children.size());
+    children.insert(std::end(children), nodeChildren);
+    nodes.push_back({kind, begin, static_cast<std::uint32_t>(nodeChildren.size())});
+    return static_cast<NodeId>(nodes.size() - 1);
+}
+
+parser::Ast::Mark parser::Ast::mark() const
+{
+    return {nodes.size(), children.size()};
+}
+
+void parser::Ast::rollback(Mark mark)
+{
+    if (memo)
+    {
+        return;
+    }
+
+    nodes.resize(mark.nodes);
+    children.resize(mark.children);
+}
+
+void parser::Ast::setPackrat(bool packrat)
+{
+    if (packrat)
+    {
+        memo.emplace(static_cast<size_t>(NodeKind::Token), tokens.size());
+    }
+    else
+    {
+        memo.reset();
+    }
+}
+
+parser::Memo *parser::Ast::getMemo()
+{
+    return memo ? &*memo : nullptr;
+}
+
+parser::detail::Node parser::Ast::toNode(NodeId node) const
+{
+    detail::Node result{std::string(getLabel(node)), {}};
+    for (auto &&child: getChildren(node))
+    {
+        result.children.push_back(toNode(child));
+    }
+    return result;
+}
@@ -0,0 +1,156 @@
+#pragma once
+
+#include <cstdint>
+#include <initializer_list>
+#include <list>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "lexer.h"
+#include "memo.h"
+
+namespace parser::detail
+{
+// the tree as the parser used to build it, every node owning copies of its children
+struct Node
+{
+    std::string data;
+    std::list<Node> children;
+};
+}  // namespace parser::detail
+
+namespace parser
+{
+using NodeId = std::uint32_t;
+
+inline constexpr NodeId noNode = static_cast<NodeId>(-1);
+
+enum class NodeKind : std::uint8_t
+{
+    Block,
+    OperatorsList,
+    Tail,
+    Operator,
+    Expression,
+    SimpleExpression,
+    Term,
+    Factor,
+    RelationOperation,
+    Sign,
+    AdditionOperation,
+    MultiplicationOperation,
+    Identifier,
+    Constant,
+    SimpleExpression1,
+    Term1,
+    Expression1,
+    Token,    // a piece of the source, the kinds before it are grammar rules
+    Epsilon,  // an empty alternative
+};
+
+// rule name as the parser prints it, "Term'" for Term1
+std::string_view toString(NodeKind kind);
+
+/*
+ * Syntax tree in one arena: nodes live in a vector and are referred to by index,
+ * the children of a node are one range of a shared index vector and tokens are
+ * ranges of the source the tree keeps. The source is lexed once when the tree is
+ * made. A node is three integers, building one allocates nothing but the amortised
+ * growth of the vectors.
+ *
+ * The parser rolls back to a mark when an alternative fails, so nodes of failed
+ * attempts do not stay in the arena. With a memo rollback does nothing: memoized
+ * nodes are reused by later attempts and must outlive the one that made them
+ */
+class Ast
+{
+public:
+    struct Children
+    {
+        const NodeId *first;
+        const NodeId *last;
+
+        const NodeId *begin() const
+        {
+            return first;
+        }
+
+        const NodeId *end() const
+        {
+            return last;
+        }
+
+        size_t size() const
+        {
+            return static_cast<size_t>(last - first);
+        }
+
+        NodeId operator[](size_t i) const
+        {
+            return first[i];
+        }
+    };
+
+    struct Mark
+    {
+        size_t nodes;
+        size_t children;
+    };
+
+    explicit Ast(std::string source = {});
+
+    const std::string &getSource() const;
+    const std::vector<Token> &getTokens() const;
+    const Token &getToken(size_t index) const;
+
+    // noNode if the source does not parse
+    NodeId getRoot() const;
+    void setRoot(NodeId root);
+
+    // the source from the first token after the root, all of it if there is no root
+    std::string_view getUnparsed() const;
+    void setUnparsed(size_t token);
+
+    NodeKind getKind(NodeId node) const;
+    Children getChildren(NodeId node) const;
+
+    // source text of a token, "ϵ" for epsilon and the rule name for anything else
+    std::string_view getLabel(NodeId node) const;
+
+    size_t size() const;
+
+    NodeId addToken(size_t token);
+    NodeId addEpsilon();
+    NodeId addNode(NodeKind kind, std::initializer_list<NodeId> children);
+
+    Mark mark() const;
+    void rollback(Mark mark);
+
+    // packrat parsing, a memo over the grammar rules and the tokens or none
+    void setPackrat(bool packrat);
+    Memo *getMemo();
+
+    // the subtree as the old copying tree
+    detail::Node toNode(NodeId node) const;
+
+private:
+    struct Item
+    {
+        NodeKind kind;
+        std::uint32_t begin;  // into children, or into source for tokens
+        std::uint32_t size;
+    };
+
+    std::string source;
+    std::vector<Token> tokens;
+    NodeId root = noNode;
+    size_t unparsed = 0;
+
+    std::vector<Item> nodes;
+    std::vector<NodeId> children;
+
+    std::optional<Memo> memo;
+};
+}  // namespace parser
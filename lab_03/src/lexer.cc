@@ -0,0 +1,167 @@
+#include "lexer.h"
+
+#include <array>
+#include <cctype>
+
+namespace
+{
+using parser::TokenKind;
+
+struct Keyword
+{
+    std::string_view word;
+    TokenKind kind;
+};
+
+constexpr std::array<Keyword, 6> keywords = {{
+    {"and", TokenKind::And},
+    {"const", TokenKind::Constant},
+    {"div", TokenKind::Div},
+    {"mod", TokenKind::Mod},
+    {"not", TokenKind::Not},
+    {"or", TokenKind::Or},
+}};
+
+// the keywords differ in the low three bits of their first letter
+constexpr size_t slot(std::string_view word)
+{
+    return static_cast<unsigned char>(word.front()) & 7;
+}
+
+constexpr std::array<Keyword, 8> makeTable()
+{
+    std::array<Keyword, 8> table = {};
+    for (auto &&keyword: keywords)
+    {
+        table[slot(keyword.word)] = keyword;
+    }
+    return table;
+}
+
+constexpr auto table = makeTable();
+
+constexpr bool isPerfect()
+{
+    for (auto &&keyword: keywords)
+    {
+        if (table[slot(keyword.word)].word != keyword.word)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static_assert(isPerfect(), "two keywords share a slot, change slot()");
+
+bool isWordStart(char c)
+{
+    return std::isalpha(static_cast<unsigned char>(c)) || c == '_';
+}
+
+bool isWordPart(char c)
+{
+    return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+}
+
+bool isDigit(char c)
+{
+    return std::isdigit(static_cast<unsigned char>(c));
+}
+
+// kind and size of the operator or bracket rest starts with
+std::pair<TokenKind, size_t> punctuation(std::string_view rest)
+{
+    auto next = rest.size() > 1 ? rest[1] : '\0';
+    switch (rest.front())
+    {
+        case '{':
+            return {TokenKind::LeftBrace, 1};
+        case '}':
+            return {TokenKind::RightBrace, 1};
+        case '(':
+            return {TokenKind::LeftParen, 1};
+        case ')':
+            return {TokenKind::RightParen, 1};
+        case ';':
+            return {TokenKind::Semicolon, 1};
+        case '=':
+            return next == '=' ? std::pair(TokenKind::Equal, 2) : std::pair(TokenKind::Assign, 1);
+        case '<':
+            if (next == '>')
+            {
+                return {TokenKind::NotEqual, 2};
+            }
+            return next == '=' ? std::pair(TokenKind::LessEqual, 2) : std::pair(TokenKind::Less, 1);
+        case '>':
+            return next == '=' ? std::pair(TokenKind::GreaterEqual, 2)
+                               : std::pair(TokenKind::Greater, 1);
+        case '+':
+            return {TokenKind::Plus, 1};
+        case '-':
+            return {TokenKind::Minus, 1};
+        case '*':
+            return {TokenKind::Star, 1};
+        case '/':
+            return {TokenKind::Slash, 1};
+        default:
+            return {TokenKind::Invalid, 1};
+    }
+}
+}  // namespace
+
+parser::TokenKind parser::findKeyword(std::string_view word)
+{
+    if (word.empty())
+    {
+        return TokenKind::Identifier;
+    }
+
+    const auto &keyword = table[slot(word)];
+    return keyword.word == word ? keyword.kind : TokenKind::Identifier;
+}
+
+std::vector<parser::Token> parser::tokenize(std::string_view source)
+{
+    std::vector<Token> tokens;
+    size_t i = 0;
+    while (i < source.size())
+    {
+        if (std::isspace(static_cast<unsigned char>(source[i])))
+        {
+            ++i;
+            continue;
+        }
+
+        auto begin = i;
+        TokenKind kind;
+        if (isWordStart(source[i]))
+        {
+            while (i < source.size() && isWordPart(source[i]))
+            {
+                ++i;
+            }
+            kind = findKeyword(source.substr(begin, i - begin));
+        }
+        else if (isDigit(source[i]))
+        {
+            while (i < source.size() && isDigit(source[i]))
+            {
+                ++i;
+            }
+            kind = TokenKind::Constant;
+        }
+        else
+        {
+            auto [punctuationKind, size] = punctuation(source.substr(i));
+            kind = punctuationKind;
+            i += size;
+        }
+
+        tokens.push_back(
+            {kind, static_cast<std::uint32_t>(begin), static_cast<std::uint32_t>(i - begin)});
+    }
+
+    tokens.push_back({TokenKind::End, static_cast<std::uint32_t>(source.size()), 0});
+    return tokens;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace parser
+{
+enum class TokenKind : std::uint8_t
+{
+    Identifier,
+    Constant,  // a number or const
+    LeftBrace,
+    RightBrace,
+    LeftParen,
+    RightParen,
+    Semicolon,
+    Assign,
+    Equal,
+    NotEqual,
+    Less,
+    LessEqual,
+    Greater,
+    GreaterEqual,
+    Plus,
+    Minus,
+    Star,
+    Slash,
+    Div,
+    Mod,
+    And,
+    Or,
+    Not,
+    Invalid,  // a character no token starts with
+    End,      // after the last token, at the end of the source
+};
+
+struct Token
+{
+    TokenKind kind;
+    std::uint32_t offset;
+    std::uint32_t size;
+};
+
+// kind of the keyword word is, Identifier if it is none
+TokenKind findKeyword(std::string_view word);
+
+/*
+ * Splits source into tokens in one pass, whitespace only separates them.
+ * The last token is always End, so the parser may look at the token after
+ * any one it has not consumed yet
+ */
+std::vector<Token> tokenize(std::string_view source);
+}  // namespace parser
@@ -0,0 +1,33 @@
+#include "memo.h"
+
+parser::Memo::Memo(size_t rules, size_t tokens)
+    : rules(rules), entries(rules * tokens, Entry{none, none})
+{
+}
+
+const parser::Memo::Entry *parser::Memo::find(size_t rule, size_t token) const
+{
+    const auto &entry = entries[token * rules + rule];
+    if (entry.next == none)
+    {
+        return nullptr;
+    }
+
+    ++hits;
+    return &entry;
+}
+
+void parser::Memo::store(size_t rule, size_t token, Entry entry)
+{
+    entries[token * rules + rule] = entry;
+}
+
+size_t parser::Memo::getHits() const
+{
+    return hits;
+}
+
+size_t parser::Memo::getMemory() const
+{
+    return entries.capacity() * sizeof(Entry);
+}
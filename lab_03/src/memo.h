@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace parser
+{
+/*
+ * Results of rules by (rule, token) for packrat parsing. The table is dense: every
+ * token has one entry of two integers per rule, entries of a token lie together
+ * because a parser tries several rules at the same token in a row
+ */
+class Memo
+{
+public:
+    static constexpr std::uint32_t none = static_cast<std::uint32_t>(-1);
+
+    struct Entry
+    {
+        std::uint32_t node;  // none if the rule fails at the token
+        std::uint32_t next;  // token after the node, none if the rule was not tried
+    };
+
+    Memo(size_t rules, size_t tokens);
+
+    // nullptr if the rule has not been tried at token yet
+    const Entry *find(size_t rule, size_t token) const;
+    void store(size_t rule, size_t token, Entry entry);
+
+    size_t getHits() const;
+    size_t getMemory() const;  // bytes of the table
+
+private:
+    size_t rules;
+    std::vector<Entry> entries;
+    mutable size_t hits = 0;
+};
+}  // namespace parser
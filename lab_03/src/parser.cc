@@ -2,398 +2,359 @@
 
 #include <iostream>
 
-/*
- * First add operators which are longer if they may conflict
- * For example: '<', '<>' and '<=' are in conflict, so '<' must go last
- */
-static const std::vector<std::string> relationalOperators = {"==", "<>", "<=", ">=", "<", ">"};
-static const std::vector<std::string> signs = {"+", "-"};
-static const std::vector<std::string> additionOperators = {"+", "-", "or"};
-static const std::vector<std::string> multiplicationOperators = {"*", "/", "div", "mod", "and"};
-static const std::vector<std::string> identifiers = {"a", "b", "c"};
-static const std::vector<std::string> constants = {"const"};
-
+using namespace parser;
 using namespace parser::detail;
 
-ReturnType Block::accept(std::string_view str, size_t depth)
+static const std::vector<TokenKind> relationalOperators = {
+    TokenKind::Equal,
+    TokenKind::NotEqual,
+    TokenKind::LessEqual,
+    TokenKind::GreaterEqual,
+    TokenKind::Less,
+    TokenKind::Greater,
+};
+static const std::vector<TokenKind> signs = {TokenKind::Plus, TokenKind::Minus};
+static const std::vector<TokenKind> additionOperators = {
+    TokenKind::Plus, TokenKind::Minus, TokenKind::Or};
+static const std::vector<TokenKind> multiplicationOperators = {
+    TokenKind::Star, TokenKind::Slash, TokenKind::Div, TokenKind::Mod, TokenKind::And};
+
+parser::Trace::Trace() : Trace(std::cout)
 {
-    std::cout << std::string(depth, '\t') << "Block: " << str << std::endl;
+}
+
+parser::Trace::Trace(std::ostream &out, size_t width) : out(out), width(width)
+{
+    buffer.reserve(capacity);
+}
 
-    auto tree = Node{"Block", {}};
-    if (str.front() == '{' && str.back() == '}')
+parser::Trace::~Trace()
+{
+    flush();
+}
+
+void parser::Trace::write(size_t depth, std::string_view rule, std::string_view input)
+{
+    if (buffer.size() + depth + rule.size() + width + 8 > capacity)
     {
-        if (auto &&[node, newStr] = ::accept<OperatorsList>(str.substr(1), depth + 1); node)
+        flush();
+    }
+
+    buffer.append(depth, '\t');
+    buffer.append(rule);
+    buffer.append(": ");
+    buffer.append(input.substr(0, width));
+    buffer.append(input.size() > width ? "...\n" : "\n");
+}
+
+void parser::Trace::flush()
+{
+    out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    out.flush();
+    buffer.clear();
+}
+
+static bool isAt(const Ast &ast, size_t pos, TokenKind kind)
+{
+    return ast.getToken(pos).kind == kind;
+}
+
+template<typename TracePolicy>
+Result Block::accept(size_t pos, size_t depth, Ast &ast, TracePolicy &trace)
+{
+    auto mark = ast.mark();
+    if (isAt(ast, pos, TokenKind::LeftBrace))
+    {
+        if (auto &&[node, next] = ::accept<OperatorsList>(pos + 1, depth + 1, ast, trace); node)
         {
-            if (newStr.front() == '}')
+            if (isAt(ast, next, TokenKind::RightBrace))
             {
-                tree.children.push_back({"{", {}});
-                tree.children.push_back(*node);
-                tree.children.push_back({"}", {}});
-                return {tree, newStr.substr(1)};
+                auto open = ast.addToken(pos);
+                auto close = ast.addToken(next);
+                return {ast.addNode(kind, {open, *node, close}), next + 1};
             }
         }
     }
-    return {std::nullopt, str};
+    ast.rollback(mark);
+    return {std::nullopt, pos};
 }
 
-ReturnType OperatorsList::accept(std::string_view str, size_t depth)
+template<typename TracePolicy>
+Result OperatorsList::accept(size_t pos, size_t depth, Ast &ast, TracePolicy &trace)
 {
-    std::cout << std::string(depth, '\t') << "OperatorsList: " << str << std::endl;
-
-    auto tree = Node{"OperatorsList", {}};
-    if (auto &&[node1, newStr1] = ::accept<Operator>(str, depth + 1); node1)
+    auto mark = ast.mark();
+    if (auto &&[node1, next1] = ::accept<Operator>(pos, depth + 1, ast, trace); node1)
     {
-        if (auto &&[node2, newStr2] = ::accept<Tail>(newStr1, depth + 2); node2)
+        if (auto &&[node2, next2] = ::accept<Tail>(next1, depth + 2, ast, trace); node2)
         {
-            tree.children.push_back(*node1);
-            tree.children.push_back(*node2);
-            return {tree, newStr2};
+            return {ast.addNode(kind, {*node1, *node2}), next2};
         }
     }
-    return {std::nullopt, str};
+    ast.rollback(mark);
+    return {std::nullopt, pos};
 }
 
-ReturnType Tail::accept(std::string_view str, size_t depth)
+template<typename TracePolicy>
+Result Tail::accept(size_t pos, size_t depth, Ast &ast, TracePolicy &trace)
 {
-    std::cout << std::string(depth, '\t') << "Tail: " << str << std::endl;
-
-    auto tree = Node{"Tail", {}};
-    if (str.front() == ';')
+    auto mark = ast.mark();
+    if (isAt(ast, pos, TokenKind::Semicolon))
     {
-        if (auto &&[node1, newStr1] = ::accept<Operator>(str.substr(1), depth + 1); node1)
+        if (auto &&[node1, next1] = ::accept<Operator>(pos + 1, depth + 1, ast, trace); node1)
         {
-            if (auto &&[node2, newStr2] = ::accept<Tail>(newStr1, depth + 2); node2)
+            if (auto &&[node2, next2] = ::accept<Tail>(next1, depth + 2, ast, trace); node2)
             {
-                tree.children.push_back({";", {}});
-                tree.children.push_back(*node1);
-                tree.children.push_back(*node2);
-                return {tree, newStr2};
+                auto semicolon = ast.addToken(pos);
+                return {ast.addNode(kind, {semicolon, *node1, *node2}), next2};
             }
         }
     }
-
-    tree.children.push_back({"ϵ", {}});
-    return {tree, str};
+    ast.rollback(mark);
+    return {ast.addNode(kind, {ast.addEpsilon()}), pos};
 }
 
-ReturnType Operator::accept(std::string_view str, size_t depth)
+template<typename TracePolicy>
+Result Operator::accept(size_t pos, size_t depth, Ast &ast, TracePolicy &trace)
 {
-    std::cout << std::string(depth, '\t') << "Operator: " << str << std::endl;
-
-    auto tree = Node{"Operator", {}};
-    if (auto &&[node1, newStr1] = ::accept<Identifier>(str, depth + 1); node1)
+    auto mark = ast.mark();
+    if (auto &&[node1, next1] = ::accept<Identifier>(pos, depth + 1, ast, trace); node1)
     {
-        if (newStr1.front() == '=')
+        if (isAt(ast, next1, TokenKind::Assign))
         {
-            if (auto &&[node2, newStr2] = ::accept<Expression>(newStr1.substr(1), depth + 2); node2)
+            if (auto &&[node2, next2] = ::accept<Expression>(next1 + 1, depth + 2, ast, trace);
+                node2)
             {
-                tree.children.push_back(*node1);
-                tree.children.push_back({"=", {}});
-                tree.children.push_back(*node2);
-                return {tree, newStr2};
+                auto assign = ast.addToken(next1);
+                return {ast.addNode(kind, {*node1, assign, *node2}), next2};
             }
         }
     }
+    ast.rollback(mark);
 
-    if (auto &&[node, newStr] = ::accept<Block>(str, depth + 1); node)
+    if (auto &&[node, next] = ::accept<Block>(pos, depth + 1, ast, trace); node)
     {
-        tree.children.push_back(*node);
-        return {tree, newStr};
+        return {ast.addNode(kind, {*node}), next};
     }
-    return {std::nullopt, str};
+    return {std::nullopt, pos};
 }
 
-ReturnType Expression::accept(std::string_view str, size_t depth)
+template<typename TracePolicy>
+Result Expression::accept(size_t pos, size_t depth, Ast &ast, TracePolicy &trace)
 {
-    std::cout << std::string(depth, '\t') << "Expression: " << str << std::endl;
-
-    auto tree = Node{"Expression", {}};
-    if (auto &&[node1, newStr1] = ::accept<SimpleExpression>(str, depth + 1); node1)
+    auto mark = ast.mark();
+    if (auto &&[node1, next1] = ::accept<SimpleExpression>(pos, depth + 1, ast, trace); node1)
     {
-        if (auto &&[node2, newStr2] = ::accept<Expression1>(newStr1, depth + 2); node2)
+        if (auto &&[node2, next2] = ::accept<Expression1>(next1, depth + 2, ast, trace); node2)
         {
-            tree.children.push_back(*node1);
-            tree.children.push_back(*node2);
-            return {tree, newStr2};
+            return {ast.addNode(kind, {*node1, *node2}), next2};
         }
     }
-    return {std::nullopt, str};
+    ast.rollback(mark);
+    return {std::nullopt, pos};
 }
 
-ReturnType SimpleExpression::accept(std::string_view str, size_t depth)
+template<typename TracePolicy>
+Result SimpleExpression::accept(size_t pos, size_t depth, Ast &ast, TracePolicy &trace)
 {
-    std::cout << std::string(depth, '\t') << "SimpleExpression: " << str << std::endl;
-
-    auto tree = Node{"SimpleExpression", {}};
-    if (auto &&[node1, newStr1] = ::accept<Term>(str, depth + 1); node1)
+    auto mark = ast.mark();
+    if (auto &&[node1, next1] = ::accept<Term>(pos, depth + 1, ast, trace); node1)
     {
-        if (auto &&[node2, newStr2] = ::accept<SimpleExpression1>(newStr1, depth + 2); node2)
+        if (auto &&[node2, next2] = ::accept<SimpleExpression1>(next1, depth + 2, ast, trace);
+            node2)
         {
-            tree.children.push_back(*node1);
-            tree.children.push_back(*node2);
-            return {tree, newStr2};
+            return {ast.addNode(kind, {*node1, *node2}), next2};
         }
     }
+    ast.rollback(mark);
 
-    if (auto &&[node1, newStr1] = ::accept<Sign>(str, depth + 1); node1)
+    if (auto &&[node1, next1] = ::accept<Sign>(pos, depth + 1, ast, trace); node1)
     {
-        if (auto &&[node2, newStr2] = ::accept<Term>(newStr1, depth + 2); node1)
+        if (auto &&[node2, next2] = ::accept<Term>(next1, depth + 2, ast, trace); node2)
         {
-            if (auto &&[node3, newStr3] = ::accept<SimpleExpression1>(newStr2, depth + 3); node1)
+            if (auto &&[node3, next3] =
+                    ::accept<SimpleExpression1>(next2, depth + 3, ast, trace);
+                node3)
             {
-                tree.children.push_back(*node1);
-                tree.children.push_back(*node2);
-                tree.children.push_back(*node3);
-                return {tree, newStr3};
+                return {ast.addNode(kind, {*node1, *node2, *node3}), next3};
             }
         }
     }
-    return {std::nullopt, str};
+    ast.rollback(mark);
+    return {std::nullopt, pos};
 }
 
-ReturnType Term::accept(std::string_view str, size_t depth)
+template<typename TracePolicy>
+Result Term::accept(size_t pos, size_t depth, Ast &ast, TracePolicy &trace)
 {
-    std::cout << std::string(depth, '\t') << "Term: " << str << std::endl;
-
-    auto tree = Node{"Term", {}};
-    if (auto &&[node1, newStr1] = ::accept<Factor>(str, depth + 1); node1)
+    auto mark = ast.mark();
+    if (auto &&[node1, next1] = ::accept<Factor>(pos, depth + 1, ast, trace); node1)
     {
-        if (auto &&[node2, newStr2] = ::accept<Term1>(newStr1, depth + 2); node2)
+        if (auto &&[node2, next2] = ::accept<Term1>(next1, depth + 2, ast, trace); node2)
         {
-            tree.children.push_back(*node1);
-            tree.children.push_back(*node2);
-            return {tree, newStr2};
+            return {ast.addNode(kind, {*node1, *node2}), next2};
         }
     }
-    return {std::nullopt, str};
+    ast.rollback(mark);
+    return {std::nullopt, pos};
 }
 
-ReturnType Factor::accept(std::string_view str, size_t depth)
+template<typename TracePolicy>
+Result Factor::accept(size_t pos, size_t depth, Ast &ast, TracePolicy &trace)
 {
-    std::cout << std::string(depth, '\t') << "Factor: " << str << std::endl;
-
-    auto tree = Node{"Factor", {}};
-    if (auto &&[node, newStr] = ::accept<Identifier>(str, depth + 1); node)
+    auto mark = ast.mark();
+    if (auto &&[node, next] = ::accept<Identifier>(pos, depth + 1, ast, trace); node)
     {
-        tree.children.push_back(*node);
-        return {tree, newStr};
+        return {ast.addNode(kind, {*node}), next};
     }
-    if (auto &&[node, newStr] = ::accept<Constant>(str, depth + 1); node)
+    if (auto &&[node, next] = ::accept<Constant>(pos, depth + 1, ast, trace); node)
     {
-        tree.children.push_back(*node);
-        return {tree, newStr};
+        return {ast.addNode(kind, {*node}), next};
     }
-    if (str.front() == '(')
+    if (isAt(ast, pos, TokenKind::LeftParen))
     {
-        if (auto &&[node, newStr] = ::accept<SimpleExpression>(str.substr(1), depth + 1); node)
+        if (auto &&[node, next] = ::accept<SimpleExpression>(pos + 1, depth + 1, ast, trace);
+            node)
         {
-            if (newStr.front() == ')')
+            if (isAt(ast, next, TokenKind::RightParen))
             {
-                tree.children.push_back({"(", {}});
-                tree.children.push_back(*node);
-                tree.children.push_back({")", {}});
-                return {tree, newStr.substr(1)};
+                auto open = ast.addToken(pos);
+                auto close = ast.addToken(next);
+                return {ast.addNode(kind, {open, *node, close}), next + 1};
             }
         }
+        ast.rollback(mark);
     }
-    if (str.find("not") == 0)
+    if (isAt(ast, pos, TokenKind::Not))
     {
-        if (auto &&[node, newStr] = ::accept<Factor>(str.substr(3), depth + 1); node)
+        if (auto &&[node, next] = ::accept<Factor>(pos + 1, depth + 1, ast, trace); node)
         {
-            tree.children.push_back(*node);
-            return {tree, newStr};
+            return {ast.addNode(kind, {ast.addToken(pos), *node}), next};
         }
     }
-
-    return {std::nullopt, str};
+    return {std::nullopt, pos};
 }
 
-ReturnType RelationOperation::accept(std::string_view str, size_t depth)
+// a node of kind for the token at pos if it is one of ops
+static Result acceptToken(size_t pos, Ast &ast, NodeKind kind, const std::vector<TokenKind> &ops)
 {
-    std::cout << std::string(depth, '\t') << "RelationOperation: " << str << std::endl;
-
-    auto tree = Node{"RelationOperation", {}};
-    for (auto &&op: relationalOperators)
+    for (auto &&op: ops)
     {
-        if (str.find(op) == 0)
+        if (isAt(ast, pos, op))
         {
-            tree.children.push_back({op, {}});
-            return {tree, str.substr(op.size())};
+            return {ast.addNode(kind, {ast.addToken(pos)}), pos + 1};
         }
     }
-    return {std::nullopt, str};
+    return {std::nullopt, pos};
 }
 
-ReturnType Sign::accept(std::string_view str, size_t depth)
+template<typename TracePolicy>
+Result RelationOperation::accept(size_t pos, size_t, Ast &ast, TracePolicy &)
 {
-    std::cout << std::string(depth, '\t') << "Sign: " << str << std::endl;
-
-    auto tree = Node{"Sign", {}};
-    for (auto &&sign: signs)
-    {
-        if (str.find(sign) == 0)
-        {
-            tree.children.push_back({sign, {}});
-            return {tree, str.substr(sign.size())};
-        }
-    }
-    return {std::nullopt, str};
+    return acceptToken(pos, ast, kind, relationalOperators);
 }
 
-ReturnType AdditionOperation::accept(std::string_view str, size_t depth)
+template<typename TracePolicy>
+Result Sign::accept(size_t pos, size_t, Ast &ast, TracePolicy &)
 {
-    std::cout << std::string(depth, '\t') << "AdditionOperation: " << str << std::endl;
+    return acceptToken(pos, ast, kind, signs);
+}
 
-    auto tree = Node{"AdditionOperation", {}};
-    for (auto &&op: additionOperators)
-    {
-        if (str.find(op) == 0)
-        {
-            tree.children.push_back({op, {}});
-            return {tree, str.substr(op.size())};
-        }
-    }
-    return {std::nullopt, str};
+template<typename TracePolicy>
+Result AdditionOperation::accept(size_t pos, size_t, Ast &ast, TracePolicy &)
+{
+    return acceptToken(pos, ast, kind, additionOperators);
 }
 
-ReturnType MultiplicationOperation::accept(std::string_view str, size_t depth)
+template<typename TracePolicy>
+Result MultiplicationOperation::accept(size_t pos, size_t, Ast &ast, TracePolicy &)
 {
-    std::cout << std::string(depth, '\t') << "MultiplicationOperation: " << str << std::endl;
+    return acceptToken(pos, ast, kind, multiplicationOperators);
+}
 
-    auto tree = Node{"MultiplicationOperation", {}};
-    for (auto &&op: multiplicationOperators)
+template<typename TracePolicy>
+Result Identifier::accept(size_t pos, size_t, Ast &ast, TracePolicy &)
+{
+    if (isAt(ast, pos, TokenKind::Identifier))
     {
-        if (str.find(op) == 0)
-        {
-            tree.children.push_back({op, {}});
-            return {tree, str.substr(op.size())};
-        }
+        return {ast.addNode(kind, {ast.addToken(pos)}), pos + 1};
     }
-    return {std::nullopt, str};
+    return {std::nullopt, pos};
 }
 
-ReturnType Identifier::accept(std::string_view str, size_t depth)
+template<typename TracePolicy>
+Result Constant::accept(size_t pos, size_t, Ast &ast, TracePolicy &)
 {
-    std::cout << std::string(depth, '\t') << "Identifier: " << str << std::endl;
-
-    auto tree = Node{"Identifier", {}};
-    for (auto &&identifier: identifiers)
+    if (isAt(ast, pos, TokenKind::Constant))
     {
-        if (str.find(identifier) == 0)
-        {
-            bool canBeConstant = false;
-            for (auto it = std::begin(constants); it != std::end(constants) && !canBeConstant; ++it)
-            {
-                if (str.find(*it) == 0)
-                {
-                    tree.data = "Constant";
-                    tree.children.push_back({*it, {}});
-                    return {tree, str.substr(it->size())};
-                }
-            }
-
-            if (!canBeConstant)
-            {
-                tree.children.push_back({identifier, {}});
-                return {tree, str.substr(identifier.size())};
-            }
-        }
+        return {ast.addNode(kind, {ast.addToken(pos)}), pos + 1};
     }
-    return {std::nullopt, str};
+    return {std::nullopt, pos};
 }
 
-ReturnType Constant::accept(std::string_view str, size_t depth)
+template<typename TracePolicy>
+Result SimpleExpression1::accept(size_t pos, size_t depth, Ast &ast, TracePolicy &trace)
 {
-    std::cout << std::string(depth, '\t') << "Constant: " << str << std::endl;
-
-    auto tree = Node{"Constant", {}};
-    for (auto &&constant: constants)
+    auto mark = ast.mark();
+    if (auto &&[node1, next1] = ::accept<AdditionOperation>(pos, depth + 1, ast, trace); node1)
     {
-        if (str.find(constant) == 0)
+        if (auto &&[node2, next2] = ::accept<Term>(next1, depth + 2, ast, trace); node2)
         {
-            bool canBeIdentifier = false;
-            for (auto it = std::begin(identifiers); it != std::end(identifiers) && !canBeIdentifier;
-                 ++it)
+            if (auto &&[node3, next3] =
+                    ::accept<SimpleExpression1>(next2, depth + 3, ast, trace);
+                node3)
             {
-                if (str.find(*it) == 0)
-                {
-                    tree.data = "Identifier";
-                    tree.children.push_back({*it, {}});
-                    return {tree, str.substr(it->size())};
-                }
-            }
-
-            if (!canBeIdentifier)
-            {
-                tree.children.push_back({constant, {}});
-                return {tree, str.substr(constant.size())};
+                return {ast.addNode(kind, {*node1, *node2, *node3}), next3};
             }
         }
     }
-    return {std::nullopt, str};
+    ast.rollback(mark);
+    return {ast.addNode(kind, {ast.addEpsilon()}), pos};
 }
 
-ReturnType SimpleExpression1::accept(std::string_view str, size_t depth)
+template<typename TracePolicy>
+Result Term1::accept(size_t pos, size_t depth, Ast &ast, TracePolicy &trace)
 {
-    std::cout << std::string(depth, '\t') << "SimpleExpression': " << str << std::endl;
-
-    auto tree = Node{"SimpleExpression'", {}};
-    if (auto &&[node1, newStr1] = ::accept<AdditionOperation>(str, depth + 1); node1)
+    auto mark = ast.mark();
+    if (auto &&[node1, next1] = ::accept<MultiplicationOperation>(pos, depth + 1, ast, trace);
+        node1)
     {
-        if (auto &&[node2, newStr2] = ::accept<Term>(newStr1, depth + 2); node2)
+        if (auto &&[node2, next2] = ::accept<Factor>(next1, depth + 2, ast, trace); node2)
         {
-            if (auto &&[node3, newStr3] = ::accept<SimpleExpression1>(newStr2, depth + 3); node3)
+            if (auto &&[node3, next3] = ::accept<Term1>(next2, depth + 3, ast, trace); node3)
             {
-                tree.children.push_back(*node1);
-                tree.children.push_back(*node2);
-                tree.children.push_back(*node3);
-                return {tree, newStr3};
+                return {ast.addNode(kind, {*node1, *node2, *node3}), next3};
             }
         }
     }
-
-    tree.children.push_back({"ϵ", {}});
-    return {tree, str};
+    ast.rollback(mark);
+    return {ast.addNode(kind, {ast.addEpsilon()}), pos};
 }
 
-ReturnType Term1::accept(std::string_view str, size_t depth)
+template<typename TracePolicy>
+Result Expression1::accept(size_t pos, size_t depth, Ast &ast, TracePolicy &trace)
 {
-    std::cout << std::string(depth, '\t') << "Term': " << str << std::endl;
-
-    auto tree = Node{"Term'", {}};
-    if (auto &&[node1, newStr1] = ::accept<MultiplicationOperation>(str, depth + 1); node1)
+    auto mark = ast.mark();
+    if (auto &&[node1, next1] = ::accept<RelationOperation>(pos, depth + 1, ast, trace); node1)
     {
-        if (auto &&[node2, newStr2] = ::accept<Factor>(newStr1, depth + 2); node2)
+        if (auto &&[node2, next2] = ::accept<SimpleExpression>(next1, depth + 2, ast, trace);
+            node2)
         {
-            if (auto &&[node3, newStr3] = ::accept<Term1>(newStr2, depth + 3); node3)
-            {
-                tree.children.push_back(*node1);
-                tree.children.push_back(*node2);
-                tree.children.push_back(*node3);
-                return {tree, newStr3};
-            }
+            return {ast.addNode(kind, {*node1, *node2}), next2};
         }
     }
-
-    tree.children.push_back({"ϵ", {}});
-    return {tree, str};
+    ast.rollback(mark);
+    return {ast.addNode(kind, {ast.addEpsilon()}), pos};
 }
 
-ReturnType Expression1::accept(std::string_view str, size_t depth)
+template<typename TracePolicy>
+void parser::detail::parse(Ast &ast, TracePolicy &trace)
 {
-    std::cout << std::string(depth, '\t') << "Expression': " << str << std::endl;
-
-    auto tree = Node{"Expression'", {}};
-    if (auto &&[node1, newStr1] = ::accept<RelationOperation>(str, depth + 1); node1)
+    if (auto &&[node, next] = ::accept<Block>(0, 0, ast, trace); node)
     {
-        if (auto &&[node2, newStr2] = ::accept<SimpleExpression>(newStr1, depth + 2); node2)
-        {
-            tree.children.push_back(*node1);
-            tree.children.push_back(*node2);
-            return {tree, newStr2};
-        }
+        ast.setRoot(*node);
+        ast.setUnparsed(next);
     }
-
-    tree.children.push_back({"ϵ", {}});
-    return {tree, str};
 }
+
+template void parser::detail::parse(Ast &, parser::NoTrace &);
+template void parser::detail::parse(Ast &, parser::Trace &);
@@ -1,11 +1,54 @@
 #pragma once
 
-#include <list>
+#include <ostream>
 #include <vector>
 #include <string>
 #include <string_view>
 #include <optional>
 
+#include "ast.h"
+
+namespace parser
+{
+// tracing switched off, the calls to it are not compiled at all
+struct NoTrace
+{
+    static constexpr bool enabled = false;
+
+    void write(size_t, std::string_view, std::string_view)
+    {
+    }
+};
+
+/*
+ * One line per rule attempt: indentation by depth, the rule and the start of the
+ * remaining input cut to width characters. Lines are collected in a buffer and
+ * written in large blocks, the rest when the trace is flushed or destroyed
+ */
+class Trace
+{
+public:
+    static constexpr bool enabled = true;
+
+    Trace();  // writes to std::cout
+    explicit Trace(std::ostream &out, size_t width = 40);
+    ~Trace();
+
+    Trace(const Trace &) = delete;
+    Trace &operator=(const Trace &) = delete;
+
+    void write(size_t depth, std::string_view rule, std::string_view input);
+    void flush();
+
+private:
+    static constexpr size_t capacity = 1 << 16;
+
+    std::ostream &out;
+    size_t width;
+    std::string buffer;
+};
+}  // namespace parser
+
 namespace parser::detail
 {
 template<typename T, typename U>
@@ -14,122 +57,248 @@ using IsBaseOf = std::enable_if_t<std::is_base_of_v<T, U>>;
 template<typename T, typename U>
 using NotIsBaseOf = std::enable_if_t<!std::is_base_of_v<T, U>>;
 
-struct Node
-{
-    std::string data;
-    std::list<Node> children;
-};
+// the copying tree and the input left after it, the result of parser::accept
+using ReturnType = std::pair<std::optional<Node>, std::string>;
 
-using ReturnType = std::pair<std::optional<Node>, std::string_view>;
+// node of a rule in the arena and the index of the token after it
+using Result = std::pair<std::optional<NodeId>, size_t>;
 
+// rules have a static accept templated on the trace policy and the kind of their nodes
 struct GrammarElement
 {
-    virtual ReturnType accept(std::string_view, size_t depth) = 0;
 };
 
 struct Block : GrammarElement
 {
-    ReturnType accept(std::string_view, size_t depth) override;
+    static constexpr NodeKind kind = NodeKind::Block;
+
+    template<typename TracePolicy>
+    static Result accept(size_t pos, size_t depth, Ast &ast, TracePolicy &trace);
 };
 
 struct OperatorsList : GrammarElement
 {
-    ReturnType accept(std::string_view, size_t depth) override;
+    static constexpr NodeKind kind = NodeKind::OperatorsList;
+
+    template<typename TracePolicy>
+    static Result accept(size_t pos, size_t depth, Ast &ast, TracePolicy &trace);
 };
 
 struct Tail : GrammarElement
 {
-    ReturnType accept(std::string_view, size_t depth) override;
+    static constexpr NodeKind kind = NodeKind::Tail;
+
+    template<typename TracePolicy>
+    static Result accept(size_t pos, size_t depth, Ast &ast, TracePolicy &trace);
 };
 
 struct Operator : GrammarElement
 {
-    ReturnType accept(std::string_view, size_t depth) override;
+    static constexpr NodeKind kind = NodeKind::Operator;
+
+    template<typename TracePolicy>
+    static Result accept(size_t pos, size_t depth, Ast &ast, TracePolicy &trace);
 };
 
 struct Expression : GrammarElement
 {
-    ReturnType accept(std::string_view, size_t depth) override;
+    static constexpr NodeKind kind = NodeKind::Expression;
+
+    template<typename TracePolicy>
+    static Result accept(size_t pos, size_t depth, Ast &ast, TracePolicy &trace);
 };
 
 struct SimpleExpression : GrammarElement
 {
-    ReturnType accept(std::string_view, size_t depth) override;
+    static constexpr NodeKind kind = NodeKind::SimpleExpression;
+
+    template<typename TracePolicy>
+    static Result accept(size_t pos, size_t depth, Ast &ast, TracePolicy &trace);
 };
 
 struct Term : GrammarElement
 {
-    ReturnType accept(std::string_view, size_t depth) override;
+    static constexpr NodeKind kind = NodeKind::Term;
+
+    template<typename TracePolicy>
+    static Result accept(size_t pos, size_t depth, Ast &ast, TracePolicy &trace);
 };
 
 struct Factor : GrammarElement
 {
-    ReturnType accept(std::string_view, size_t depth) override;
+    static constexpr NodeKind kind = NodeKind::Factor;
+
+    template<typename TracePolicy>
+    static Result accept(size_t pos, size_t depth, Ast &ast, TracePolicy &trace);
 };
 
 struct RelationOperation : GrammarElement
 {
-    ReturnType accept(std::string_view, size_t depth) override;
+    static constexpr NodeKind kind = NodeKind::RelationOperation;
+
+    template<typename TracePolicy>
+    static Result accept(size_t pos, size_t depth, Ast &ast, TracePolicy &trace);
 };
 
 struct Sign : GrammarElement
 {
-    ReturnType accept(std::string_view, size_t depth) override;
+    static constexpr NodeKind kind = NodeKind::Sign;
+
+    template<typename TracePolicy>
+    static Result accept(size_t pos, size_t depth, Ast &ast, TracePolicy &trace);
 };
 
 struct AdditionOperation : GrammarElement
 {
-    ReturnType accept(std::string_view, size_t depth) override;
+    static constexpr NodeKind kind = NodeKind::AdditionOperation;
+
+    template<typename TracePolicy>
+    static Result accept(size_t pos, size_t depth, Ast &ast, TracePolicy &trace);
 };
 
 struct MultiplicationOperation : GrammarElement
 {
-    ReturnType accept(std::string_view, size_t depth) override;
+    static constexpr NodeKind kind = NodeKind::MultiplicationOperation;
+
+    template<typename TracePolicy>
+    static Result accept(size_t pos, size_t depth, Ast &ast, TracePolicy &trace);
 };
 
 struct Identifier : GrammarElement
 {
-    ReturnType accept(std::string_view, size_t depth) override;
+    static constexpr NodeKind kind = NodeKind::Identifier;
+
+    template<typename TracePolicy>
+    static Result accept(size_t pos, size_t depth, Ast &ast, TracePolicy &trace);
 };
 
 struct Constant : GrammarElement
 {
-    ReturnType accept(std::string_view, size_t depth) override;
+    static constexpr NodeKind kind = NodeKind::Constant;
+
+    template<typename TracePolicy>
+    static Result accept(size_t pos, size_t depth, Ast &ast, TracePolicy &trace);
 };
 
 struct SimpleExpression1 : GrammarElement
 {
-    ReturnType accept(std::string_view, size_t depth) override;
+    static constexpr NodeKind kind = NodeKind::SimpleExpression1;
+
+    template<typename TracePolicy>
+    static Result accept(size_t pos, size_t depth, Ast &ast, TracePolicy &trace);
 };
 
 struct Term1 : GrammarElement
 {
-    ReturnType accept(std::string_view, size_t depth) override;
+    static constexpr NodeKind kind = NodeKind::Term1;
+
+    template<typename TracePolicy>
+    static Result accept(size_t pos, size_t depth, Ast &ast, TracePolicy &trace);
 };
 
 struct Expression1 : GrammarElement
 {
-    ReturnType accept(std::string_view, size_t depth) override;
+    static constexpr NodeKind kind = NodeKind::Expression1;
+
+    template<typename TracePolicy>
+    static Result accept(size_t pos, size_t depth, Ast &ast, TracePolicy &trace);
 };
 
-template<typename T>
-ReturnType accept(std::string_view str, size_t depth, IsBaseOf<GrammarElement, T> * = nullptr)
+// the result of T at pos from memo, T is run the first time only
+template<typename T, typename TracePolicy>
+Result acceptMemoized(size_t pos, size_t depth, Ast &ast, TracePolicy &trace, Memo &memo)
 {
-    return T{}.accept(str, depth);
+    auto rule = static_cast<size_t>(T::kind);
+    if (auto *entry = memo.find(rule, pos))
+    {
+        if (entry->node == Memo::none)
+        {
+            return {std::nullopt, pos};
+        }
+        return {entry->node, entry->next};
+    }
+
+    auto result = T::accept(pos, depth, ast, trace);
+    auto next = static_cast<std::uint32_t>(result.second);
+    memo.store(rule, pos, {result.first ? *result.first : Memo::none, next});
+    return result;
 }
 
-template<typename T>
-ReturnType accept(std::string_view, size_t, NotIsBaseOf<GrammarElement, T> * = nullptr)
+template<typename T, typename TracePolicy>
+Result accept(size_t pos,
+    size_t depth,
+    Ast &ast,
+    TracePolicy &trace,
+    IsBaseOf<GrammarElement, T> * = nullptr)
+{
+    if constexpr (TracePolicy::enabled)
+    {
+        auto input = std::string_view(ast.getSource()).substr(ast.getToken(pos).offset);
+        trace.write(depth, toString(T::kind), input);
+    }
+
+    if (auto *memo = ast.getMemo())
+    {
+        return acceptMemoized<T>(pos, depth, ast, trace, *memo);
+    }
+    return T::accept(pos, depth, ast, trace);
+}
+
+template<typename T, typename TracePolicy>
+Result accept(size_t,
+    size_t,
+    Ast &,
+    TracePolicy &,
+    NotIsBaseOf<GrammarElement, T> * = nullptr)
 {
     return {};
 }
+
+// the whole program, instantiated in parser.cc for NoTrace and Trace
+template<typename TracePolicy>
+void parse(Ast &ast, TracePolicy &trace);
 }  // namespace parser::detail
 
 namespace parser
 {
-inline detail::ReturnType accept(std::string str)
+/*
+ * The tree of a program, its root is noNode if the program does not parse.
+ * A packrat parse tries every rule at most once at a token, which bounds the time
+ * by the size of the memo; the memo stays with the tree until setPackrat(false)
+ */
+template<typename TracePolicy>
+Ast parse(std::string str, TracePolicy &trace, bool packrat = false)
+{
+    Ast ast(std::move(str));
+    ast.setPackrat(packrat);
+    detail::parse(ast, trace);
+    return ast;
+}
+
+// parser::parse(str) does no tracing, parser::parse<parser::Trace>(str) prints it
+template<typename TracePolicy = NoTrace>
+Ast parse(std::string str, bool packrat = false)
+{
+    TracePolicy trace;
+    return parse(std::move(str), trace, packrat);
+}
+
+// the same as a tree of copies
+template<typename TracePolicy>
+detail::ReturnType accept(std::string str, TracePolicy &trace)
+{
+    auto ast = parse(std::move(str), trace);
+    if (ast.getRoot() == noNode)
+    {
+        return {std::nullopt, std::string(ast.getUnparsed())};
+    }
+    return {ast.toNode(ast.getRoot()), std::string(ast.getUnparsed())};
+}
+
+template<typename TracePolicy = NoTrace>
+detail::ReturnType accept(std::string str)
 {
-    str.erase(std::remove(std::begin(str), std::end(str), ' '), std::end(str));
-    return detail::accept<detail::Block>(str, 0);
+    TracePolicy trace;
+    return accept(std::move(str), trace);
 }
 }  // namespace parser
@@ -0,0 +1,78 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <string>
+
+#include "parser.h"
+
+TEST(AstTest, TestsThatNodesShareTheArena)
+{
+    parser::Ast ast("a + b");
+
+    auto a = ast.addToken(0);
+    auto plus = ast.addToken(1);
+    auto b = ast.addToken(2);
+    auto epsilon = ast.addEpsilon();
+    auto rest = ast.addNode(parser::NodeKind::SimpleExpression1, {plus, b, epsilon});
+    auto root = ast.addNode(parser::NodeKind::SimpleExpression, {a, rest});
+
+    EXPECT_EQ(ast.size(), 6);
+    EXPECT_EQ(ast.getKind(root), parser::NodeKind::SimpleExpression);
+    EXPECT_EQ(ast.getLabel(root), "SimpleExpression");
+    EXPECT_EQ(ast.getLabel(rest), "SimpleExpression'");
+    EXPECT_EQ(ast.getLabel(plus), "+");
+    EXPECT_EQ(ast.getLabel(epsilon), "ϵ");
+    EXPECT_EQ(ast.getChildren(b).size(), 0);
+
+    auto children = ast.getChildren(rest);
+    ASSERT_EQ(children.size(), 3);
+    EXPECT_EQ(children[0], plus);
+    EXPECT_EQ(children[2], epsilon);
+}
+
+TEST(AstTest, TestsThatRollbackDropsNodes)
+{
+    parser::Ast ast("a b");
+
+    auto a = ast.addToken(0);
+    auto mark = ast.mark();
+    ast.addNode(parser::NodeKind::Factor, {ast.addToken(1)});
+    ast.rollback(mark);
+
+    EXPECT_EQ(ast.size(), 1);
+    auto factor = ast.addNode(parser::NodeKind::Factor, {a});
+    EXPECT_EQ(factor, 1);
+    EXPECT_EQ(ast.getChildren(factor)[0], a);
+}
+
+TEST(AstTest, TestsThatParsedTreeMatchesCopyingTree)
+{
+    auto ast = parser::parse("{a=b*(c+const);{c=not const<>-a}}");
+    ASSERT_NE(ast.getRoot(), parser::noNode);
+    EXPECT_TRUE(ast.getUnparsed().empty());
+
+    auto root = ast.getChildren(ast.getRoot());
+    ASSERT_EQ(root.size(), 3);
+    EXPECT_EQ(ast.getLabel(root[0]), "{");
+    EXPECT_EQ(ast.getKind(root[1]), parser::NodeKind::OperatorsList);
+    EXPECT_EQ(ast.getLabel(root[2]), "}");
+
+    auto tree = ast.toNode(ast.getRoot());
+    EXPECT_EQ(tree.data, "Block");
+    ASSERT_EQ(tree.children.size(), 3);
+    EXPECT_EQ(tree.children.front().data, "{");
+    EXPECT_EQ(tree.children.back().data, "}");
+}
+
+TEST(AstTest, TestsThatFailedParseKeepsSource)
+{
+    auto ast = parser::parse("{a=const;}");
+    EXPECT_EQ(ast.getRoot(), parser::noNode);
+    EXPECT_EQ(ast.getUnparsed(), "{a=const;}");
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,92 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <string_view>
+#include <vector>
+
+#include "lexer.h"
+
+using parser::TokenKind;
+
+static std::vector<TokenKind> kinds(std::string_view source)
+{
+    std::vector<TokenKind> result;
+    for (auto &&token: parser::tokenize(source))
+    {
+        result.push_back(token.kind);
+    }
+    return result;
+}
+
+TEST(LexerTest, TestsThatKeywordsAreFound)
+{
+    EXPECT_EQ(parser::findKeyword("div"), TokenKind::Div);
+    EXPECT_EQ(parser::findKeyword("mod"), TokenKind::Mod);
+    EXPECT_EQ(parser::findKeyword("and"), TokenKind::And);
+    EXPECT_EQ(parser::findKeyword("or"), TokenKind::Or);
+    EXPECT_EQ(parser::findKeyword("not"), TokenKind::Not);
+    EXPECT_EQ(parser::findKeyword("const"), TokenKind::Constant);
+
+    EXPECT_EQ(parser::findKeyword("dim"), TokenKind::Identifier);
+    EXPECT_EQ(parser::findKeyword("notconst"), TokenKind::Identifier);
+    EXPECT_EQ(parser::findKeyword("o"), TokenKind::Identifier);
+}
+
+TEST(LexerTest, TestsThatWordsAreSeparatedBySpaces)
+{
+    EXPECT_EQ(kinds("a div b"),
+        (std::vector{
+            TokenKind::Identifier, TokenKind::Div, TokenKind::Identifier, TokenKind::End}));
+    EXPECT_EQ(kinds("adivb"), (std::vector{TokenKind::Identifier, TokenKind::End}));
+    EXPECT_EQ(kinds("not x_1 or 42"),
+        (std::vector{TokenKind::Not,
+            TokenKind::Identifier,
+            TokenKind::Or,
+            TokenKind::Constant,
+            TokenKind::End}));
+}
+
+TEST(LexerTest, TestsThatLongestOperatorIsTaken)
+{
+    EXPECT_EQ(kinds("<<=<>>>===="),
+        (std::vector{TokenKind::Less,
+            TokenKind::LessEqual,
+            TokenKind::NotEqual,
+            TokenKind::Greater,
+            TokenKind::GreaterEqual,
+            TokenKind::Equal,
+            TokenKind::Assign,
+            TokenKind::End}));
+    EXPECT_EQ(kinds("{(;+-*/)}?"),
+        (std::vector{TokenKind::LeftBrace,
+            TokenKind::LeftParen,
+            TokenKind::Semicolon,
+            TokenKind::Plus,
+            TokenKind::Minus,
+            TokenKind::Star,
+            TokenKind::Slash,
+            TokenKind::RightParen,
+            TokenKind::RightBrace,
+            TokenKind::Invalid,
+            TokenKind::End}));
+}
+
+TEST(LexerTest, TestsThatTokensKeepOffsets)
+{
+    auto tokens = parser::tokenize("  ab <= 12 ");
+    ASSERT_EQ(tokens.size(), 4);
+    EXPECT_EQ(tokens[0].offset, 2);
+    EXPECT_EQ(tokens[0].size, 2);
+    EXPECT_EQ(tokens[1].offset, 5);
+    EXPECT_EQ(tokens[1].size, 2);
+    EXPECT_EQ(tokens[2].offset, 8);
+    EXPECT_EQ(tokens[2].size, 2);
+    EXPECT_EQ(tokens[3].kind, TokenKind::End);
+    EXPECT_EQ(tokens[3].offset, 11);
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
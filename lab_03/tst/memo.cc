@@ -0,0 +1,40 @@
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include "memo.h"
+
+TEST(MemoTest, TestsThatUntriedRulesAreNotFound)
+{
+    parser::Memo memo(3, 4);
+
+    EXPECT_EQ(memo.find(0, 0), nullptr);
+    EXPECT_EQ(memo.find(2, 3), nullptr);
+    EXPECT_EQ(memo.getHits(), 0);
+    EXPECT_EQ(memo.getMemory(), 12 * sizeof(parser::Memo::Entry));
+}
+
+TEST(MemoTest, TestsThatResultsAreKeptPerRuleAndToken)
+{
+    parser::Memo memo(3, 4);
+    memo.store(1, 2, {7, 3});
+    memo.store(2, 2, {parser::Memo::none, 2});
+
+    auto *success = memo.find(1, 2);
+    ASSERT_NE(success, nullptr);
+    EXPECT_EQ(success->node, 7);
+    EXPECT_EQ(success->next, 3);
+
+    auto *failure = memo.find(2, 2);
+    ASSERT_NE(failure, nullptr);
+    EXPECT_EQ(failure->node, parser::Memo::none);
+
+    EXPECT_EQ(memo.find(1, 1), nullptr);
+    EXPECT_EQ(memo.find(0, 2), nullptr);
+    EXPECT_EQ(memo.getHits(), 2);
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
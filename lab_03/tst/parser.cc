@@ -1,8 +1,22 @@
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
 
+#include <algorithm>
+#include <sstream>
+#include <string>
+
 #include "parser.h"
 
+static bool equal(const parser::detail::Node &lhs, const parser::detail::Node &rhs)
+{
+    return lhs.data == rhs.data &&
+        std::equal(std::begin(lhs.children),
+            std::end(lhs.children),
+            std::begin(rhs.children),
+            std::end(rhs.children),
+            equal);
+}
+
 TEST(ParserTest, Test1)
 {
     auto &&[tree, str] = parser::accept("{a=const}");
@@ -83,6 +97,122 @@ TEST(ParserTest, Test10)
     EXPECT_TRUE(!str.empty());
 }
 
+TEST(ParserTest, TestsThatKeywordsNeedSeparators)
+{
+    auto &&[tree, str] = parser::accept("{x1 = 42 div y;{z = not x1 or 7}}");
+
+    ASSERT_TRUE(tree);
+    EXPECT_TRUE(str.empty());
+
+    // one identifier, not a division
+    auto ast = parser::parse("{x = adivb}");
+    EXPECT_NE(ast.getRoot(), parser::noNode);
+    EXPECT_EQ(ast.getTokens().size(), 6);
+}
+
+TEST(ParserTest, TestsThatUnparsedInputStartsAtToken)
+{
+    auto &&[tree, str] = parser::accept("{a = b} c");
+
+    EXPECT_TRUE(tree);
+    EXPECT_EQ(str, "c");
+}
+
+TEST(ParserTest, TestsThatTraceIsBuffered)
+{
+    std::ostringstream out;
+    {
+        parser::Trace trace(out, 4);
+        auto &&[tree, str] = parser::accept("{a=const}", trace);
+        EXPECT_TRUE(tree);
+        EXPECT_TRUE(out.str().empty());
+    }
+
+    std::istringstream lines(out.str());
+    std::string line;
+    std::getline(lines, line);
+    EXPECT_EQ(line, "Block: {a=c...");
+    std::getline(lines, line);
+    EXPECT_EQ(line, "\tOperatorsList: a=co...");
+    std::getline(lines, line);
+    EXPECT_EQ(line, "\t\tOperator: a=co...");
+}
+
+TEST(ParserTest, TestsThatLongProgramParsesWithoutTrace)
+{
+    std::string program = "{a=b";
+    for (size_t i = 0; i < 200; ++i)
+    {
+        program += ";a=b*(c+const)";
+    }
+    program += "}";
+
+    auto &&[tree, str] = parser::accept(program);
+    EXPECT_TRUE(tree);
+    EXPECT_TRUE(str.empty());
+}
+
+TEST(ParserTest, TestsThatLongProgramParsesIntoArena)
+{
+    std::string program = "{a=b";
+    for (size_t i = 0; i < 2000; ++i)
+    {
+        program += ";a=b*(c+const)";
+    }
+    program += "}";
+
+    auto ast = parser::parse(program);
+    EXPECT_NE(ast.getRoot(), parser::noNode);
+    EXPECT_TRUE(ast.getUnparsed().empty());
+}
+
+TEST(ParserTest, TestsThatPackratParseBuildsSameTree)
+{
+    std::string program = "{a = -b + 1 < (not a + b) * b div a; {a = ((a)) <> a; {c = const}}}";
+
+    auto ast = parser::parse(program);
+    auto packrat = parser::parse(program, true);
+    ASSERT_NE(ast.getRoot(), parser::noNode);
+    ASSERT_NE(packrat.getRoot(), parser::noNode);
+    EXPECT_TRUE(equal(ast.toNode(ast.getRoot()), packrat.toNode(packrat.getRoot())));
+    EXPECT_EQ(packrat.getUnparsed(), ast.getUnparsed());
+
+    auto failed = parser::parse("{a = (b; c = 1}", true);
+    EXPECT_EQ(failed.getRoot(), parser::noNode);
+    EXPECT_EQ(failed.getUnparsed(), "{a = (b; c = 1}");
+}
+
+TEST(ParserTest, TestsThatPackratTriesRuleOncePerToken)
+{
+    // the alternatives of the grammar start with different tokens, nothing is tried twice
+    std::string program = "{a = ";
+    for (size_t i = 0; i < 100; ++i)
+    {
+        program += "(";
+    }
+    program += "a}";
+
+    auto nested = parser::parse(program, true);
+    EXPECT_EQ(nested.getRoot(), parser::noNode);
+    EXPECT_EQ(nested.getMemo()->getHits(), 0);
+
+    auto ast = parser::parse("{a = b * (c + 1)}", true);
+    auto *memo = ast.getMemo();
+    EXPECT_EQ(memo->getHits(), 0);
+
+    auto *block = memo->find(static_cast<size_t>(parser::NodeKind::Block), 0);
+    ASSERT_NE(block, nullptr);
+    EXPECT_EQ(block->node, ast.getRoot());
+    EXPECT_EQ(block->next, ast.getTokens().size() - 1);
+
+    // Factor is never tried at "=", RelationOperation fails at "}" and that is kept too
+    EXPECT_EQ(memo->find(static_cast<size_t>(parser::NodeKind::Factor), 2), nullptr);
+    auto *relation = memo->find(static_cast<size_t>(parser::NodeKind::RelationOperation), 10);
+    ASSERT_NE(relation, nullptr);
+    EXPECT_EQ(relation->node, parser::Memo::none);
+    EXPECT_EQ(memo->getHits(), 2);
+}
+
 int main(int argc, char **argv)
 {
     ::testing::InitGoogleTest(&argc, argv);